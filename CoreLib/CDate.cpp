@@ -37,18 +37,37 @@
 
 
 #include <sstream>
+#include <cstring>
 #include <ctime>
-#include <boost/lexical_cast.hpp>
 #include "CDate.hpp"
 #include "make_unique.hpp"
 
 using namespace std;
-using namespace boost;
 using namespace CoreLib::CDate;
 
+constexpr std::size_t DateConv::BUFFER_SIZE;
+
+/// Reentrant replacement for gmtime() / localtime()
+static void BreakDown(const std::time_t rawTime, const Timezone &tz, struct tm &out_timeInfo)
+{
+#if defined ( _WIN32 )
+    if (tz == Timezone::UTC) {
+        gmtime_s(&out_timeInfo, &rawTime);
+    } else {
+        localtime_s(&out_timeInfo, &rawTime);
+    }
+#else
+    if (tz == Timezone::UTC) {
+        gmtime_r(&rawTime, &out_timeInfo);
+    } else {
+        localtime_r(&rawTime, &out_timeInfo);
+    }
+#endif  // defined ( _WIN32 )
+}
+
 struct Now::Impl
 {
-    struct tm *TimeInfo;
+    struct tm TimeInfo;
     CDate::Timezone Timezone;
     time_t RawTime;
     int DaylightSavingTime;
@@ -62,40 +81,74 @@ struct Now::Impl
     int Year;
 };
 
+struct DateConv::Impl
+{
+    /// Maps an ASCII digit to the trailing byte of its UTF-8 encoded Persian
+    /// counterpart (U+06F0 - U+06F9, lead byte 0xDB); 0x00 marks the rest
+    static const unsigned char PERSIAN_DIGITS[256];
+
+    /// Per-thread memoized rendering of a given second
+    struct Stamp
+    {
+        std::time_t RawTime = -1;
+        std::string Value;
+    };
+
+    static char *PutNumber(const int number, char *out);
+    static char *PutTwoDigits(const int number, char *out);
+    static std::size_t PutDate(const int year, const int month, const int day, char *out_buffer);
+    static std::size_t PutDateTime(const struct tm &timeInfo, char *out_buffer);
+};
+
+const unsigned char DateConv::Impl::PERSIAN_DIGITS[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
 Now::Now(const Timezone &tz)
     : m_pimpl(make_unique<Now::Impl>())
 {
     m_pimpl->Timezone = tz;
 
     time(&m_pimpl->RawTime);
-    if (tz == Timezone::UTC) {
-        m_pimpl->TimeInfo = gmtime(&m_pimpl->RawTime);
-    } else {
-        m_pimpl->TimeInfo = localtime(&m_pimpl->RawTime);
-    }
+    BreakDown(m_pimpl->RawTime, tz, m_pimpl->TimeInfo);
 
-    m_pimpl->Hour = m_pimpl->TimeInfo->tm_hour; //  hour (0 - 23)
-    m_pimpl->Minutes = m_pimpl->TimeInfo->tm_min; //  minutes (0 - 59)
+    m_pimpl->Hour = m_pimpl->TimeInfo.tm_hour; //  hour (0 - 23)
+    m_pimpl->Minutes = m_pimpl->TimeInfo.tm_min; //  minutes (0 - 59)
     /*
     A leap second is a plus or minus one-second adjustment to the Coordinated Universal Time (UTC) time scale that keeps it close to mean solar time.
     When a positive leap second is added at 23:59:60 UTC, it delays the start of the following UTC day (at 00:00:00 UTC) by one second, effectively slowing the UTC clock.
     */
-    m_pimpl->Seconds = m_pimpl->TimeInfo->tm_sec != 60 ? m_pimpl->TimeInfo->tm_sec : 59; //  seconds (0 - 60, 60 = Leap second)
+    m_pimpl->Seconds = m_pimpl->TimeInfo.tm_sec != 60 ? m_pimpl->TimeInfo.tm_sec : 59; //  seconds (0 - 60, 60 = Leap second)
 
-    m_pimpl->DayOfWeek = m_pimpl->TimeInfo->tm_wday + 1; //  day of the week (0 - 6, 0 = Sunday)
-    m_pimpl->DayOfMonth = m_pimpl->TimeInfo->tm_mday; //  day of the month (1 - 31)
-    m_pimpl->DayOfYear = m_pimpl->TimeInfo->tm_yday + 1; //  day of the year (0 - 365)
-    m_pimpl->Month = m_pimpl->TimeInfo->tm_mon + 1; //  month (0 - 11, 0 = January)
-    m_pimpl->Year = m_pimpl->TimeInfo->tm_year + 1900; //  year since 1900
+    m_pimpl->DayOfWeek = m_pimpl->TimeInfo.tm_wday + 1; //  day of the week (0 - 6, 0 = Sunday)
+    m_pimpl->DayOfMonth = m_pimpl->TimeInfo.tm_mday; //  day of the month (1 - 31)
+    m_pimpl->DayOfYear = m_pimpl->TimeInfo.tm_yday + 1; //  day of the year (0 - 365)
+    m_pimpl->Month = m_pimpl->TimeInfo.tm_mon + 1; //  month (0 - 11, 0 = January)
+    m_pimpl->Year = m_pimpl->TimeInfo.tm_year + 1900; //  year since 1900
 
-    m_pimpl->DaylightSavingTime = m_pimpl->TimeInfo->tm_isdst; //  Daylight saving time enabled (> 0), disabled (= 0), or unknown (< 0)
+    m_pimpl->DaylightSavingTime = m_pimpl->TimeInfo.tm_isdst; //  Daylight saving time enabled (> 0), disabled (= 0), or unknown (< 0)
 }
 
 Now::~Now() = default;
 
 const struct tm *Now::TimeInfo() const
 {
-    return m_pimpl->TimeInfo;
+    return &m_pimpl->TimeInfo;
 }
 
 const CoreLib::CDate::Timezone &Now::TimezoneOffset() const
@@ -154,45 +207,51 @@ int Now::Year() const
 }
 
 std::string DateConv::CalcToG(const int jYear, const int dayOfYear)
+{
+    char buffer[BUFFER_SIZE];
+    return string(buffer, CalcToG(jYear, dayOfYear, buffer));
+}
+
+std::size_t DateConv::CalcToG(const int jYear, const int dayOfYear, char *out_buffer)
 {
     bool isLeapYear = IsLeapYearJ(jYear);
     int dayMatch[13] = { !isLeapYear ? 287 : 288, !isLeapYear ? 318 : 319, !isLeapYear && !IsLeapYearJ(jYear + 1) ? 346 : 347, !isLeapYear ? 12 : 13, !isLeapYear ? 42 : 43, !isLeapYear ? 73 : 74, !isLeapYear ? 103 : 104, !isLeapYear ? 134 : 135, !isLeapYear ? 165 : 166, !isLeapYear ? 195 : 196, !isLeapYear ? 226 : 227, !isLeapYear ? 256 : 257, 999 };
 
-    string gDay;
-    string gMonth;
+    int gDay = 0;
+    int gMonth = 0;
 
     for (int i = 0; i < 12; ++i)
         if ((dayOfYear >= dayMatch[i] && dayOfYear < dayMatch[i + 1]) || ((dayOfYear >= dayMatch[i] || dayOfYear < dayMatch[i + 1]) && (i == 2))) {
-            gDay = lexical_cast<string>(dayOfYear >= dayMatch[i] ? dayOfYear - dayMatch[i] + 1 : !isLeapYear ? dayOfYear + 20 : dayOfYear + 19);
-            gMonth = lexical_cast<string>(i + 1);
+            gDay = dayOfYear >= dayMatch[i] ? dayOfYear - dayMatch[i] + 1 : !isLeapYear ? dayOfYear + 20 : dayOfYear + 19;
+            gMonth = i + 1;
             break;
         }
 
-    return lexical_cast<string>(dayOfYear < dayMatch[0] ? jYear + 621 : jYear + 622) + "/" +
-            (gMonth.size() == 1 ? "0" + gMonth : gMonth)
-            + "/" +
-            (gDay.size() != 1 ? gDay : "0" + gDay);
+    return Impl::PutDate(dayOfYear < dayMatch[0] ? jYear + 621 : jYear + 622, gMonth, gDay, out_buffer);
 }
 
 std::string DateConv::CalcToJ(const int gYear, const int dayOfYear)
+{
+    char buffer[BUFFER_SIZE];
+    return string(buffer, CalcToJ(gYear, dayOfYear, buffer));
+}
+
+std::size_t DateConv::CalcToJ(const int gYear, const int dayOfYear, char *out_buffer)
 {
     bool isLeapYear = IsLeapYearG(gYear - 1);
     int dayMatch[13] = { 80, 111, 142, 173, 204, 235, 266, 296, 326, 356, !isLeapYear ? 21 : 20, !isLeapYear ? 51 : 50, 999 };
 
-    string jDay;
-    string jMonth;
+    int jDay = 0;
+    int jMonth = 0;
 
     for (int i = 0; i < 12; ++i)
         if ((dayOfYear >= dayMatch[i] && dayOfYear < dayMatch[i + 1]) || ((dayOfYear >= dayMatch[i] || dayOfYear < dayMatch[i + 1]) && (i == 9))) {
-            jDay = lexical_cast<string>(dayOfYear >= dayMatch[i] ? dayOfYear - dayMatch[i] + 1 : !isLeapYear ? dayOfYear + 10 : dayOfYear + 11);
-            jMonth = lexical_cast<string>(i + 1);
+            jDay = dayOfYear >= dayMatch[i] ? dayOfYear - dayMatch[i] + 1 : !isLeapYear ? dayOfYear + 10 : dayOfYear + 11;
+            jMonth = i + 1;
             break;
         }
 
-    return lexical_cast<string>(dayOfYear > 79 ? gYear - 621 : gYear - 622) + "/" +
-            (jMonth.size() == 1 ? "0" + jMonth : jMonth)
-            + "/" +
-            (jDay.size() != 1 ? jDay : "0" + jDay);
+    return Impl::PutDate(dayOfYear > 79 ? gYear - 621 : gYear - 622, jMonth, jDay, out_buffer);
 }
 
 bool DateConv::IsRangeValidG(const int gYear, const int gMonth, const int gDay)
@@ -265,149 +324,137 @@ std::string DateConv::ToGregorian(const int jYear, const int jMonth, const int j
 
 std::string DateConv::ToGregorian(const CDate::Timezone &tz)
 {
-    Now n(tz);
-
-    string m = lexical_cast<string>(n.Month());
-    string d = lexical_cast<string>(n.DayOfMonth());
-
-    return lexical_cast<string>(n.Year()) + "/" +
-            (m.size() == 1 ? "0" + m : m)
-            + "/" +
-            (d.size() != 1 ? d : "0" + d);
+    return ToGregorian(Now(tz));
 }
 
 std::string DateConv::ToGregorian(const CDate::Now &now)
 {
-    string m = lexical_cast<string>(now.Month());
-    string d = lexical_cast<string>(now.DayOfMonth());
+    char buffer[BUFFER_SIZE];
+    return string(buffer, ToGregorian(now, buffer));
+}
 
-    return lexical_cast<string>(now.Year()) + "/" +
-            (m.size() == 1 ? "0" + m : m)
-            + "/" +
-            (d.size() != 1 ? d : "0" + d);
+std::size_t DateConv::ToGregorian(const CDate::Now &now, char *out_buffer)
+{
+    return Impl::PutDate(now.Year(), now.Month(), now.DayOfMonth(), out_buffer);
 }
 
 std::string DateConv::ToJalali(int gYear, int gMonth, int gDay)
 {
-    if (!IsRangeValidG(gYear, gMonth, gDay))
-        return "";
+    char buffer[BUFFER_SIZE];
+    return string(buffer, ToJalali(gYear, gMonth, gDay, buffer));
+}
 
-    return CalcToJ(gYear, DayOfYearG(gYear, gMonth, gDay));
+std::size_t DateConv::ToJalali(const int gYear, const int gMonth, const int gDay, char *out_buffer)
+{
+    if (!IsRangeValidG(gYear, gMonth, gDay)) {
+        *out_buffer = '\0';
+        return 0;
+    }
+
+    return CalcToJ(gYear, DayOfYearG(gYear, gMonth, gDay), out_buffer);
 }
 
 std::string DateConv::ToJalali(const CDate::Timezone &tz)
 {
-    Now n(tz);
-    return CalcToJ(n.Year(), n.DayOfYear());
+    return ToJalali(Now(tz));
 }
 
 std::string DateConv::ToJalali(const CDate::Now &now)
 {
-    return CalcToJ(now.Year(), now.DayOfYear());
+    char buffer[BUFFER_SIZE];
+    return string(buffer, ToJalali(now, buffer));
+}
+
+std::size_t DateConv::ToJalali(const CDate::Now &now, char *out_buffer)
+{
+    return CalcToJ(now.Year(), now.DayOfYear(), out_buffer);
 }
 
 std::string DateConv::ToJalali(const std::time_t rawTime, const CDate::Timezone &tz)
 {
-    struct tm *timeInfo;
-    if (tz == Timezone::UTC) {
-        timeInfo = gmtime(&rawTime);
-    } else {
-        timeInfo = localtime(&rawTime);
-    }
+    char buffer[BUFFER_SIZE];
+    return string(buffer, ToJalali(rawTime, tz, buffer));
+}
+
+std::size_t DateConv::ToJalali(const std::time_t rawTime, const CDate::Timezone &tz, char *out_buffer)
+{
+    struct tm timeInfo;
+    BreakDown(rawTime, tz, timeInfo);
 
-    return CalcToJ(timeInfo->tm_year + 1900, timeInfo->tm_yday + 1);
+    return CalcToJ(timeInfo.tm_year + 1900, timeInfo.tm_yday + 1, out_buffer);
 }
 
 std::string DateConv::Time(const CDate::Now &now)
 {
-    string s = lexical_cast<string>(now.Seconds());
-    string m = lexical_cast<string>(now.Minutes());
-    string h = lexical_cast<string>(now.Hour());
+    char buffer[BUFFER_SIZE];
+    return string(buffer, Time(now, buffer));
+}
+
+std::size_t DateConv::Time(const CDate::Now &now, char *out_buffer)
+{
+    char *out = out_buffer;
+
+    out = Impl::PutTwoDigits(now.Hour(), out);
+    *out++ = ':';
+    out = Impl::PutTwoDigits(now.Minutes(), out);
+    *out++ = ':';
+    out = Impl::PutTwoDigits(now.Seconds(), out);
+    *out = '\0';
 
-    return (h.size() == 1 ? "0" + h : h) + ":" +
-            (m.size() == 1 ? "0" + m : m)
-            + ":" +
-            (s.size() != 1 ? s : "0" + s);
+    return static_cast<std::size_t>(out - out_buffer);
 }
 
 std::string DateConv::DateTimeString(const std::time_t rawTime, const CDate::Timezone &tz)
 {
-    if (tz == CDate::Timezone::UTC) {
-        return asctime(gmtime(&rawTime));
-    } else {
-        return asctime(localtime(&rawTime));
-    }
+    char buffer[BUFFER_SIZE];
+    std::size_t length = DateTimeString(rawTime, tz, buffer);
+    buffer[length++] = '\n';
+
+    return string(buffer, length);
 }
 
 std::string DateConv::DateTimeString(const CDate::Now &now)
 {
-    return asctime(now.TimeInfo());
+    char buffer[BUFFER_SIZE];
+    std::size_t length = DateTimeString(now, buffer);
+    buffer[length++] = '\n';
+
+    return string(buffer, length);
+}
+
+std::size_t DateConv::DateTimeString(const std::time_t rawTime, const CDate::Timezone &tz, char *out_buffer)
+{
+    struct tm timeInfo;
+    BreakDown(rawTime, tz, timeInfo);
+
+    return Impl::PutDateTime(timeInfo, out_buffer);
+}
+
+std::size_t DateConv::DateTimeString(const CDate::Now &now, char *out_buffer)
+{
+    return Impl::PutDateTime(*now.TimeInfo(), out_buffer);
 }
 
 std::wstring DateConv::GetPersianDayOfWeek(const CDate::Now &now)
 {
-    switch (now.DayOfWeek()) {
-    case 7:
-        return L"شنبه";
-    case 1:
-        return L"یکشنبه";
-    case 2:
-        return L"دوشنبه";
-    case 3:
-        return L"سه شنبه";
-    case 4:
-        return L"چهارشنبه";
-    case 5:
-        return L"پنج شنبه";
-    case 6:
-        return L"جمعه";
-    default:
-        break;
-    }
+    /// Indexed by Now::DayOfWeek(), i.e. 1 = Sunday
+    static const wchar_t *const DAYS[] = {
+        L"", L"یکشنبه", L"دوشنبه", L"سه شنبه", L"چهارشنبه", L"پنج شنبه", L"جمعه", L"شنبه"
+    };
+
+    int day = now.DayOfWeek();
 
-    return L"";
+    return day > 0 && day < 8 ? DAYS[day] : DAYS[0];
 }
 
 std::wstring DateConv::FormatToPersianNums(const std::string &date)
 {
     wstring res;
+    res.reserve(date.size());
 
-    for (size_t i = 0; i < date.length(); ++i) {
-        switch(date[i]) {
-        case 0x30:
-            res += 0x06F0; // ۰
-            break;
-        case 0x31:
-            res += 0x06F1; // ۱
-            break;
-        case 0x32:
-            res += 0x06F2; // ۲
-            break;
-        case 0x33:
-            res += 0x06F3; // ۳
-            break;
-        case 0x34:
-            res += 0x06F4; // ۴
-            break;
-        case 0x35:
-            res += 0x06F5; // ۵
-            break;
-        case 0x36:
-            res += 0x06F6; // ۶
-            break;
-        case 0x37:
-            res += 0x06F7; // ۷
-            break;
-        case 0x38:
-            res += 0x06F8; // ۸
-            break;
-        case 0x39:
-            res += 0x06F9; // ۹
-            break;
-        default:
-            res += date[i];
-            break;
-        }
+    for (const char c : date) {
+        unsigned char digit = Impl::PERSIAN_DIGITS[static_cast<unsigned char>(c)];
+        res += digit != 0x00 ? static_cast<wchar_t>(0x06F0 + (digit - 0xB0)) : static_cast<wchar_t>(c);
     }
 
     return res;
@@ -416,51 +463,40 @@ std::wstring DateConv::FormatToPersianNums(const std::string &date)
 std::wstring DateConv::FormatToPersianNums(const std::wstring &date)
 {
     wstring res;
+    res.reserve(date.size());
 
-    for (size_t i = 0; i < date.length(); ++i) {
-        switch(date[i]) {
-        case 0x30:
-            res += 0x06F0; // ۰
-            break;
-        case 0x31:
-            res += 0x06F1; // ۱
-            break;
-        case 0x32:
-            res += 0x06F2; // ۲
-            break;
-        case 0x33:
-            res += 0x06F3; // ۳
-            break;
-        case 0x34:
-            res += 0x06F4; // ۴
-            break;
-        case 0x35:
-            res += 0x06F5; // ۵
-            break;
-        case 0x36:
-            res += 0x06F6; // ۶
-            break;
-        case 0x37:
-            res += 0x06F7; // ۷
-            break;
-        case 0x38:
-            res += 0x06F8; // ۸
-            break;
-        case 0x39:
-            res += 0x06F9; // ۹
-            break;
-        default:
-            res += date[i];
-            break;
-        }
+    for (const wchar_t c : date) {
+        unsigned char digit = c >= 0 && c < 256 ? Impl::PERSIAN_DIGITS[c] : 0x00;
+        res += digit != 0x00 ? static_cast<wchar_t>(0x06F0 + (digit - 0xB0)) : c;
     }
 
     return res;
 }
 
+std::size_t DateConv::FormatToPersianNums(const char *date, const std::size_t length, char *out_buffer)
+{
+    char *out = out_buffer;
+
+    for (std::size_t i = 0; i < length; ++i) {
+        unsigned char digit = Impl::PERSIAN_DIGITS[static_cast<unsigned char>(date[i])];
+        if (digit != 0x00) {
+            *out++ = static_cast<char>(0xDB);
+            *out++ = static_cast<char>(digit);
+        } else {
+            *out++ = date[i];
+        }
+    }
+
+    *out = '\0';
+
+    return static_cast<std::size_t>(out - out_buffer);
+}
+
 std::string DateConv::SecondsToHumanReadableTime(const std::time_t seconds)
 {
-    tm *timeInfo = gmtime(&seconds);
+    struct tm timeInfo_;
+    BreakDown(seconds, CDate::Timezone::UTC, timeInfo_);
+    const struct tm *timeInfo = &timeInfo_;
 
     stringstream ss;
 
@@ -552,3 +588,153 @@ std::string DateConv::SecondsToHumanReadableTime(const std::time_t seconds)
 
     return ss.str();
 }
+
+const std::string &DateConv::TimeStamp(const CDate::Now &now)
+{
+    static thread_local Impl::Stamp stamps[2];
+
+    Impl::Stamp &stamp = stamps[now.TimezoneOffset() == CDate::Timezone::UTC ? 1 : 0];
+
+    if (stamp.RawTime != now.RawTime()) {
+        char buffer[BUFFER_SIZE];
+        stamp.Value.assign(buffer, DateTimeString(now, buffer));
+        stamp.RawTime = now.RawTime();
+    }
+
+    return stamp.Value;
+}
+
+const std::string &DateConv::PersianTimeStamp(const CDate::Now &now)
+{
+    static thread_local Impl::Stamp stamps[2];
+
+    Impl::Stamp &stamp = stamps[now.TimezoneOffset() == CDate::Timezone::UTC ? 1 : 0];
+
+    if (stamp.RawTime != now.RawTime()) {
+        char date[BUFFER_SIZE];
+        char buffer[BUFFER_SIZE];
+        std::size_t length = FormatToPersianNums(date, ToJalali(now, date), buffer);
+
+        stamp.Value.assign(buffer, length);
+        stamp.Value.append(" ~ ");
+        stamp.Value.append(TimeStamp(now));
+        stamp.RawTime = now.RawTime();
+    }
+
+    return stamp.Value;
+}
+
+const std::string &DateConv::LogTimeStamp()
+{
+    static const char *const MONTHS[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    static thread_local Impl::Stamp stamp;
+
+    std::time_t rawTime = time(nullptr);
+
+    if (stamp.RawTime != rawTime) {
+        struct tm timeInfo;
+        BreakDown(rawTime, CDate::Timezone::Local, timeInfo);
+
+        char buffer[BUFFER_SIZE];
+        char *out = Impl::PutNumber(timeInfo.tm_year + 1900, buffer);
+        *out++ = '-';
+        std::memcpy(out, MONTHS[timeInfo.tm_mon], 3);
+        out += 3;
+        *out++ = '-';
+        out = Impl::PutTwoDigits(timeInfo.tm_mday, out);
+        *out++ = ' ';
+        out = Impl::PutTwoDigits(timeInfo.tm_hour, out);
+        *out++ = ':';
+        out = Impl::PutTwoDigits(timeInfo.tm_min, out);
+        *out++ = ':';
+        out = Impl::PutTwoDigits(timeInfo.tm_sec, out);
+
+        stamp.Value.assign(buffer, static_cast<std::size_t>(out - buffer));
+        stamp.RawTime = rawTime;
+    }
+
+    return stamp.Value;
+}
+
+char *DateConv::Impl::PutNumber(const int number, char *out)
+{
+    char digits[16];
+    char *end = digits + sizeof(digits);
+    char *begin = end;
+
+    /// Go through unsigned to get away with INT_MIN as well
+    unsigned int value = number < 0 ? 0u - static_cast<unsigned int>(number) : static_cast<unsigned int>(number);
+
+    do {
+        *--begin = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    if (number < 0)
+        *out++ = '-';
+
+    std::memcpy(out, begin, static_cast<std::size_t>(end - begin));
+
+    return out + (end - begin);
+}
+
+char *DateConv::Impl::PutTwoDigits(const int number, char *out)
+{
+    if (number < 0 || number > 99)
+        return PutNumber(number, out);
+
+    *out++ = static_cast<char>('0' + number / 10);
+    *out++ = static_cast<char>('0' + number % 10);
+
+    return out;
+}
+
+std::size_t DateConv::Impl::PutDate(const int year, const int month, const int day, char *out_buffer)
+{
+    char *out = PutNumber(year, out_buffer);
+    *out++ = '/';
+    out = PutTwoDigits(month, out);
+    *out++ = '/';
+    out = PutTwoDigits(day, out);
+    *out = '\0';
+
+    return static_cast<std::size_t>(out - out_buffer);
+}
+
+std::size_t DateConv::Impl::PutDateTime(const struct tm &timeInfo, char *out_buffer)
+{
+    static const char *const WEEK_DAYS[] = {
+        "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+    };
+
+    static const char *const MONTHS[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    /// Same layout as asctime(), i.e. "%.3s %.3s%3d %.2d:%.2d:%.2d %d"
+    char *out = out_buffer;
+
+    std::memcpy(out, WEEK_DAYS[timeInfo.tm_wday % 7], 3);
+    out += 3;
+    *out++ = ' ';
+    std::memcpy(out, MONTHS[timeInfo.tm_mon % 12], 3);
+    out += 3;
+    *out++ = ' ';
+    if (timeInfo.tm_mday < 10)
+        *out++ = ' ';
+    out = PutNumber(timeInfo.tm_mday, out);
+    *out++ = ' ';
+    out = PutTwoDigits(timeInfo.tm_hour, out);
+    *out++ = ':';
+    out = PutTwoDigits(timeInfo.tm_min, out);
+    *out++ = ':';
+    out = PutTwoDigits(timeInfo.tm_sec, out);
+    *out++ = ' ';
+    out = PutNumber(timeInfo.tm_year + 1900, out);
+    *out = '\0';
+
+    return static_cast<std::size_t>(out - out_buffer);
+}
@@ -42,6 +42,7 @@
 
 #include <memory>
 #include <string>
+#include <cstddef>
 #include <ctime>
 
 namespace CoreLib {
@@ -85,9 +86,19 @@ public:
 
 class CoreLib::CDate::DateConv
 {
+private:
+    struct Impl;
+
+public:
+    /// Large enough for any of the buffer overloads below, including the
+    /// terminating null and FormatToPersianNums() of their output
+    static constexpr std::size_t BUFFER_SIZE = 64;
+
 public:
     static std::string CalcToG(const int jYear, const int dayOfYear);
+    static std::size_t CalcToG(const int jYear, const int dayOfYear, char *out_buffer);
     static std::string CalcToJ(const int gYear, const int dayOfYear);
+    static std::size_t CalcToJ(const int gYear, const int dayOfYear, char *out_buffer);
     static bool IsRangeValidG(const int gYear, const int gMonth, const int gDay);
     static bool IsRangeValidJ(const int jYear, const int jMonth, const int jDay);
     static int DayOfYearG(const int gYear, const int gMonth, const int gDay);
@@ -97,17 +108,42 @@ public:
     static std::string ToGregorian(const int jYear, const int jMonth, const int jDay);
     static std::string ToGregorian(const CDate::Timezone &tz = CDate::Timezone::Local);
     static std::string ToGregorian(const CDate::Now &now);
+    static std::size_t ToGregorian(const CDate::Now &now, char *out_buffer);
     static std::string ToJalali(const int gYear, const int gMonth, const int gDay);
+    static std::size_t ToJalali(const int gYear, const int gMonth, const int gDay, char *out_buffer);
     static std::string ToJalali(const CDate::Timezone &tz = CDate::Timezone::Local);
     static std::string ToJalali(const CDate::Now &now);
+    static std::size_t ToJalali(const CDate::Now &now, char *out_buffer);
     static std::string ToJalali(const std::time_t rawTime, const CDate::Timezone &tz = CDate::Timezone::Local);
+    static std::size_t ToJalali(const std::time_t rawTime, const CDate::Timezone &tz, char *out_buffer);
     static std::string Time(const CDate::Now &now);
+    static std::size_t Time(const CDate::Now &now, char *out_buffer);
     static std::string DateTimeString(const std::time_t rawTime, const CDate::Timezone &tz);
     static std::string DateTimeString(const CDate::Now &now);
+
+    /// Same as DateTimeString() without the trailing newline of asctime()
+    static std::size_t DateTimeString(const std::time_t rawTime, const CDate::Timezone &tz, char *out_buffer);
+    static std::size_t DateTimeString(const CDate::Now &now, char *out_buffer);
+
     static std::wstring GetPersianDayOfWeek(const CDate::Now &now);
     static std::wstring FormatToPersianNums(const std::string &date);
     static std::wstring FormatToPersianNums(const std::wstring &date);
+
+    /// UTF-8 variant; out_buffer must hold at least (2 * length + 1) bytes
+    static std::size_t FormatToPersianNums(const char *date, const std::size_t length, char *out_buffer);
+
     static std::string SecondsToHumanReadableTime(const std::time_t seconds);
+
+    /// Trimmed DateTimeString(now), rendered once per second and thread
+    static const std::string &TimeStamp(const CDate::Now &now);
+
+    /// "<Jalali date in Persian digits> ~ <TimeStamp(now)>", rendered once per
+    /// second and thread
+    static const std::string &PersianTimeStamp(const CDate::Now &now);
+
+    /// Current local time as "2019-Jan-01 12:34:56", rendered once per second
+    /// and thread
+    static const std::string &LogTimeStamp();
 };
 
 
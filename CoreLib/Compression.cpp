@@ -33,6 +33,8 @@
  */
 
 
+#include <stdexcept>
+#include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
@@ -48,6 +50,43 @@ using namespace std;
 using namespace boost;
 using namespace CoreLib;
 
+struct Compression::Impl
+{
+    /// A back_inserter that refuses to grow past a limit
+    class BoundedSink
+    {
+    public:
+        typedef char char_type;
+        typedef iostreams::sink_tag category;
+
+    private:
+        std::string &m_output;
+        const std::size_t m_maxSize;
+        bool &m_exceeded;
+
+    public:
+        BoundedSink(std::string &output, const std::size_t maxSize, bool &exceeded)
+            : m_output(output),
+              m_maxSize(maxSize),
+              m_exceeded(exceeded)
+        {
+
+        }
+
+        std::streamsize write(const char_type *s, std::streamsize n)
+        {
+            if (m_exceeded || static_cast<std::size_t>(n) > m_maxSize - m_output.size()) {
+                m_exceeded = true;
+                /// Stops the decompressor right away
+                throw std::length_error("Decompressed size limit exceeded!");
+            }
+
+            m_output.append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+    };
+};
+
 void Compression::Compress(const char *data, const size_t size,
                            Buffer &out_compressedBuffer,
                            const Algorithm &algorithm)
@@ -126,3 +165,47 @@ void Compression::Decompress(const Buffer &dataBuffer,
         LOG_ERROR(DECOMP_ERROR)
     }
 }
+
+bool Compression::Decompress(const Buffer &dataBuffer,
+                             std::string &out_uncompressedString,
+                             const Algorithm &algorithm,
+                             const std::size_t maxSize)
+{
+    bool exceeded = false;
+
+    try {
+        out_uncompressedString.clear();
+
+        {
+            iostreams::filtering_streambuf<iostreams::output> output;
+
+            switch(algorithm) {
+            case Algorithm::Zlib:
+                output.push(iostreams::zlib_decompressor());
+                break;
+            case Algorithm::Gzip:
+                output.push(iostreams::gzip_decompressor());
+                break;
+            case Algorithm::Bzip2:
+                output.push(iostreams::bzip2_decompressor());
+                break;
+            }
+
+            output.push(Impl::BoundedSink(out_uncompressedString, maxSize, exceeded));
+            iostreams::write(output, &dataBuffer[0], static_cast<streamsize>(dataBuffer.size()));
+
+            /// Flush whatever the decompressor still holds before judging
+            output.reset();
+        }
+
+        if (!exceeded)
+            return true;
+    } catch(...) {
+        if (!exceeded) {
+            LOG_ERROR(DECOMP_ERROR)
+        }
+    }
+
+    out_uncompressedString.clear();
+    return false;
+}
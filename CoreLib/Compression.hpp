@@ -37,6 +37,7 @@
 #define CORELIB_COMPRESSION_HPP
 
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -49,6 +50,9 @@ class CoreLib::Compression
 public:
     typedef std::vector<char> Buffer;
 
+private:
+    struct Impl;
+
 public:
     enum class Algorithm : unsigned char {
         Zlib,
@@ -72,6 +76,14 @@ public:
     static void Decompress(const Buffer &dataBuffer,
                            Buffer &out_uncompressedBuffer,
                            const Algorithm &algorithm);
+
+    /// Gives up as soon as the output grows beyond maxSize bytes, so a
+    /// small, hostile input cannot exhaust the memory; returns false then,
+    /// or on corrupted input
+    static bool Decompress(const Buffer &dataBuffer,
+                           std::string &out_uncompressedString,
+                           const Algorithm &algorithm,
+                           const std::size_t maxSize);
 };
 
 
@@ -38,8 +38,13 @@
 #include <stdexcept>
 #include <sstream>
 #include <utility>
+#include <vector>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/tss.hpp>
 #if defined ( _WIN32 )
 #include <windows.h>
 //#include <cryptopp/dll.h>     // msvc-shared only
@@ -47,8 +52,8 @@
 #include <cryptopp/aes.h>
 #include <cryptopp/ccm.h>
 #include <cryptopp/cryptlib.h>
-#include <cryptopp/filters.h>
-#include <cryptopp/hex.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/secblock.h>
 #include <cryptopp/sha.h>
 #include <b64/decode.h>
 #include <b64/encode.h>
@@ -58,24 +63,85 @@
 #include "Log.hpp"
 
 #define     UNKNOWN_ERROR           "Unknown error!"
+#define     INVALID_HEX_ERROR       "Invalid hex-encoded input!"
+#define     INVALID_CIPHER_ERROR    "Invalid cipher text!"
+
+#define     TOKEN_VERSION           0x01
+#define     TOKEN_MAX_LENGTH        4096
+#define     TOKEN_KEY_CONTEXT       "CoreLib::Crypto::Token"
+#define     TOKEN_EXPIRY_BYTES      8
+#define     TOKEN_BASE64_VARIANT    sodium_base64_VARIANT_URLSAFE_NO_PADDING
+
+#define     MAC_KEY_CONTEXT         "CoreLib::Crypto::Mac"
+#define     MAC_BASE64_VARIANT      sodium_base64_VARIANT_URLSAFE_NO_PADDING
 
 using namespace std;
 using namespace boost;
 using namespace CryptoPP;
 using namespace CoreLib;
 
+namespace CoreLib {
+namespace CryptoHex {
+static const char DIGITS[] = "0123456789ABCDEF";
+
+/// -1 marks anything that is not a hex digit
+static const signed char VALUES[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+}
+}
+
 struct Crypto::Impl
 {
+public:
+    /// Keyed once per thread, since CryptoPP cipher objects are not thread-safe
+    struct Ciphers
+    {
+        CBC_Mode<AES>::Encryption Encryption;
+        CBC_Mode<AES>::Decryption Decryption;
+    };
+
 public:
     Crypto::Byte *Key;
     std::size_t KeyLen;
     Crypto::Byte *IV;
     std::size_t IVLen;
 
+    boost::thread_specific_ptr<Ciphers> ThreadCiphers;
+
+    unsigned char TokenKey[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+    unsigned char MacKey[crypto_auth_hmacsha256_KEYBYTES];
+
 public:
     Impl();
     ~Impl();
 
+public:
+    Ciphers &GetCiphers();
+
+    static void DeriveKey(const char *context, const Byte *key, const std::size_t keyLen,
+                          unsigned char *out_derivedKey, const std::size_t derivedKeyLen);
+
+    static void Encrypt(CBC_Mode<AES>::Encryption &enc, const Byte *iv,
+                        const std::string &plainText, std::string &out_encodedText);
+    static bool Decrypt(CBC_Mode<AES>::Decryption &dec, const Byte *iv,
+                        const std::string &cipherText, std::string &out_recoveredText,
+                        std::string &out_error);
 };
 
 void Crypto::Initialize()
@@ -111,13 +177,7 @@ bool Crypto::Encrypt(const std::string &plainText, std::string &out_encodedText,
         CBC_Mode<AES>::Encryption enc;
         enc.SetKeyWithIV(key, keyLen, iv, ivLen);
 
-        string cipher;
-        StringSource(plainText, true,
-                     new StreamTransformationFilter(enc, new StringSink(cipher)));
-
-        string encoded;
-        StringSource(cipher, true, new HexEncoder(new StringSink(encoded)));
-        out_encodedText.assign(std::move(encoded));
+        Impl::Encrypt(enc, iv, plainText, out_encodedText);
 
         return true;
     }
@@ -152,15 +212,7 @@ bool Crypto::Decrypt(const std::string &cipherText, std::string &out_recoveredTe
         CBC_Mode<AES>::Decryption dec;
         dec.SetKeyWithIV(key, keyLen, iv, ivLen);
 
-        string cipher;
-        StringSource(cipherText, true, new HexDecoder(new StringSink(cipher)));
-
-        string decoded;
-        StringSource(cipher, true,
-                     new StreamTransformationFilter(dec, new StringSink(decoded)));
-        out_recoveredText.assign(std::move(decoded));
-
-        return true;
+        return Impl::Decrypt(dec, iv, cipherText, out_recoveredText, out_error);
     }
 
     catch (const CryptoPP::Exception &ex) {
@@ -188,12 +240,10 @@ bool Crypto::Hash(const std::string &text, std::string &out_digest,
                   std::string &out_error)
 {
     try {
-        SHA512 hash;
+        Byte digest[SHA512::DIGESTSIZE];
+        SHA512().CalculateDigest(digest, reinterpret_cast<const Byte *>(text.data()), text.size());
 
-        string digest;
-        StringSource(text, true,
-                     new HashFilter(hash, new HexEncoder(new StringSink(digest))));
-        out_digest.assign(std::move(digest));
+        HexEncode(digest, sizeof(digest), out_digest);
 
         return true;
     }
@@ -293,6 +343,10 @@ Crypto::Crypto(const Byte *key, const std::size_t keyLen, const Byte *iv, const
 
     m_pimpl->KeyLen = keyLen;
     m_pimpl->IVLen = ivLen;
+
+    /// Never reuse the AES key as is; derive dedicated ones for the tokens and the MACs
+    Impl::DeriveKey(TOKEN_KEY_CONTEXT, key, keyLen, m_pimpl->TokenKey, sizeof(m_pimpl->TokenKey));
+    Impl::DeriveKey(MAC_KEY_CONTEXT, key, keyLen, m_pimpl->MacKey, sizeof(m_pimpl->MacKey));
 }
 
 Crypto::~Crypto()
@@ -302,24 +356,214 @@ Crypto::~Crypto()
 
 bool Crypto::Encrypt(const std::string &plainText, std::string &out_encodedText)
 {
-    return Crypto::Encrypt(plainText, out_encodedText, m_pimpl->Key, m_pimpl->KeyLen, m_pimpl->IV, m_pimpl->IVLen);
+    string err;
+    return Encrypt(plainText, out_encodedText, err);
 }
 
 bool Crypto::Encrypt(const std::string &plainText, std::string &out_encodedText,
                      std::string &out_error)
 {
-    return Crypto::Encrypt(plainText, out_encodedText, out_error, m_pimpl->Key, m_pimpl->KeyLen, m_pimpl->IV, m_pimpl->IVLen);
+    try {
+        Impl::Encrypt(m_pimpl->GetCiphers().Encryption, m_pimpl->IV, plainText, out_encodedText);
+
+        return true;
+    }
+
+    catch (const CryptoPP::Exception &ex) {
+        out_error.assign(ex.what());
+    }
+
+    catch (const std::exception &ex) {
+        out_error.assign(ex.what());
+    }
+
+    catch (...) {
+        out_error.assign(UNKNOWN_ERROR);
+    }
+
+    return false;
 }
 
 bool Crypto::Decrypt(const std::string &cipherText, std::string &out_recoveredText)
 {
-    return Crypto::Decrypt(cipherText, out_recoveredText, m_pimpl->Key, m_pimpl->KeyLen, m_pimpl->IV, m_pimpl->IVLen);
+    string err;
+    return Decrypt(cipherText, out_recoveredText, err);
 }
 
 bool Crypto::Decrypt(const std::string &cipherText, std::string &out_recoveredText,
                      std::string &out_error)
 {
-    return Crypto::Encrypt(cipherText, out_recoveredText, out_error, m_pimpl->Key, m_pimpl->KeyLen, m_pimpl->IV, m_pimpl->IVLen);
+    try {
+        return Impl::Decrypt(m_pimpl->GetCiphers().Decryption, m_pimpl->IV, cipherText, out_recoveredText, out_error);
+    }
+
+    catch (const CryptoPP::Exception &ex) {
+        out_error.assign(ex.what());
+    }
+
+    catch (const std::exception &ex) {
+        out_error.assign(ex.what());
+    }
+
+    catch (...) {
+        out_error.assign(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+bool Crypto::SealToken(const std::string &payload, const std::time_t expiry, std::string &out_token)
+{
+    static constexpr std::size_t HEADER_BYTES = 1 + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+
+    /// version | nonce | ciphertext( expiry (big-endian) | payload ) | tag
+    std::string plain(TOKEN_EXPIRY_BYTES + payload.size(), '\0');
+    const uint64_t expiryValue = static_cast<uint64_t>(expiry);
+    for (std::size_t i = 0; i < TOKEN_EXPIRY_BYTES; ++i) {
+        plain[i] = static_cast<char>((expiryValue >> (8 * (TOKEN_EXPIRY_BYTES - 1 - i))) & 0xFF);
+    }
+    std::copy(payload.begin(), payload.end(), plain.begin() + TOKEN_EXPIRY_BYTES);
+
+    std::vector<unsigned char> raw(HEADER_BYTES + plain.size() + crypto_aead_xchacha20poly1305_ietf_ABYTES);
+    raw[0] = TOKEN_VERSION;
+    randombytes_buf(&raw[1], crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+
+    unsigned long long cipherLength = 0;
+    if (crypto_aead_xchacha20poly1305_ietf_encrypt(
+                &raw[HEADER_BYTES], &cipherLength,
+                reinterpret_cast<const unsigned char *>(plain.data()), plain.size(),
+                &raw[0], 1, nullptr, &raw[1], m_pimpl->TokenKey) != 0) {
+        out_token.clear();
+        return false;
+    }
+
+    out_token.resize(sodium_base64_ENCODED_LEN(raw.size(), TOKEN_BASE64_VARIANT));
+    sodium_bin2base64(&out_token[0], out_token.size(), raw.data(), raw.size(), TOKEN_BASE64_VARIANT);
+    out_token.resize(std::strlen(out_token.c_str()));
+
+    return true;
+}
+
+bool Crypto::OpenToken(const std::string &token, std::string &out_payload)
+{
+    std::time_t expiry;
+    return OpenToken(token, out_payload, expiry);
+}
+
+bool Crypto::OpenToken(const std::string &token, std::string &out_payload, std::time_t &out_expiry)
+{
+    static constexpr std::size_t HEADER_BYTES = 1 + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+    static constexpr std::size_t MIN_RAW_BYTES = HEADER_BYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES + TOKEN_EXPIRY_BYTES;
+
+    out_payload.clear();
+    out_expiry = 0;
+
+    if (token.empty() || token.size() > TOKEN_MAX_LENGTH)
+        return false;
+
+    std::vector<unsigned char> raw(token.size() * 3 / 4 + 1);
+    std::size_t rawLength = 0;
+    if (sodium_base642bin(raw.data(), raw.size(), token.c_str(), token.size(),
+                          nullptr, &rawLength, nullptr, TOKEN_BASE64_VARIANT) != 0
+            || rawLength < MIN_RAW_BYTES
+            || raw[0] != TOKEN_VERSION) {
+        return false;
+    }
+
+    std::vector<unsigned char> plain(rawLength - HEADER_BYTES - crypto_aead_xchacha20poly1305_ietf_ABYTES);
+    unsigned long long plainLength = 0;
+    if (crypto_aead_xchacha20poly1305_ietf_decrypt(
+                plain.data(), &plainLength, nullptr,
+                &raw[HEADER_BYTES], rawLength - HEADER_BYTES,
+                &raw[0], 1, &raw[1], m_pimpl->TokenKey) != 0) {
+        return false;
+    }
+
+    uint64_t expiryValue = 0;
+    for (std::size_t i = 0; i < TOKEN_EXPIRY_BYTES; ++i) {
+        expiryValue = (expiryValue << 8) | plain[i];
+    }
+
+    if (static_cast<std::time_t>(expiryValue) < std::time(nullptr))
+        return false;
+
+    out_expiry = static_cast<std::time_t>(expiryValue);
+    out_payload.assign(reinterpret_cast<const char *>(plain.data()) + TOKEN_EXPIRY_BYTES,
+                       static_cast<std::size_t>(plainLength) - TOKEN_EXPIRY_BYTES);
+
+    return true;
+}
+
+bool Crypto::Sign(const std::string &message, std::string &out_signature)
+{
+    unsigned char mac[crypto_auth_hmacsha256_BYTES];
+    if (crypto_auth_hmacsha256(mac, reinterpret_cast<const unsigned char *>(message.data()), message.size(),
+                               m_pimpl->MacKey) != 0) {
+        out_signature.clear();
+        return false;
+    }
+
+    out_signature.resize(sodium_base64_ENCODED_LEN(sizeof(mac), MAC_BASE64_VARIANT));
+    sodium_bin2base64(&out_signature[0], out_signature.size(), mac, sizeof(mac), MAC_BASE64_VARIANT);
+    out_signature.resize(std::strlen(out_signature.c_str()));
+
+    return true;
+}
+
+bool Crypto::VerifySignature(const std::string &message, const std::string &signature)
+{
+    static const std::size_t ENCODED_LENGTH
+            = sodium_base64_ENCODED_LEN(crypto_auth_hmacsha256_BYTES, MAC_BASE64_VARIANT) - 1;
+
+    /// Anything but an exact-length signature is rejected before hashing
+    if (signature.size() != ENCODED_LENGTH)
+        return false;
+
+    unsigned char mac[crypto_auth_hmacsha256_BYTES];
+    std::size_t macLength = 0;
+    if (sodium_base642bin(mac, sizeof(mac), signature.c_str(), signature.size(),
+                          nullptr, &macLength, nullptr, MAC_BASE64_VARIANT) != 0
+            || macLength != sizeof(mac)) {
+        return false;
+    }
+
+    /// Constant-time comparison
+    return crypto_auth_hmacsha256_verify(mac, reinterpret_cast<const unsigned char *>(message.data()), message.size(),
+                                         m_pimpl->MacKey) == 0;
+}
+
+void Crypto::HexEncode(const Byte *data, const std::size_t length, std::string &out_hex)
+{
+    out_hex.resize(length * 2);
+
+    char *out = &out_hex[0];
+    for (std::size_t i = 0; i < length; ++i) {
+        *out++ = CryptoHex::DIGITS[data[i] >> 4];
+        *out++ = CryptoHex::DIGITS[data[i] & 0x0F];
+    }
+}
+
+bool Crypto::HexDecode(const std::string &hex, std::string &out_data)
+{
+    if (hex.size() % 2 != 0)
+        return false;
+
+    out_data.resize(hex.size() / 2);
+
+    const unsigned char *in = reinterpret_cast<const unsigned char *>(hex.data());
+    for (std::size_t i = 0; i < out_data.size(); ++i) {
+        const signed char high = CryptoHex::VALUES[*in++];
+        const signed char low = CryptoHex::VALUES[*in++];
+
+        if (high < 0 || low < 0) {
+            out_data.clear();
+            return false;
+        }
+
+        out_data[i] = static_cast<char>((high << 4) | low);
+    }
+
+    return true;
 }
 
 std::string Crypto::ByteArrayToString(const unsigned char *array, const size_t length)
@@ -379,6 +623,95 @@ Crypto::Impl::Impl()
 
 Crypto::Impl::~Impl()
 {
-    delete IV;
-    delete Key;
+    sodium_memzero(TokenKey, sizeof(TokenKey));
+    sodium_memzero(MacKey, sizeof(MacKey));
+
+    delete[] IV;
+    delete[] Key;
+}
+
+Crypto::Impl::Ciphers &Crypto::Impl::GetCiphers()
+{
+    Ciphers *ciphers = ThreadCiphers.get();
+
+    if (!ciphers) {
+        ciphers = new Ciphers();
+        ciphers->Encryption.SetKeyWithIV(Key, KeyLen, IV, IVLen);
+        ciphers->Decryption.SetKeyWithIV(Key, KeyLen, IV, IVLen);
+        ThreadCiphers.reset(ciphers);
+    }
+
+    return *ciphers;
+}
+
+void Crypto::Impl::DeriveKey(const char *context, const Byte *key, const std::size_t keyLen,
+                             unsigned char *out_derivedKey, const std::size_t derivedKeyLen)
+{
+    /// Keyed BLAKE2b over the context; longer or shorter keys are hashed in instead
+    if (keyLen >= crypto_generichash_KEYBYTES_MIN && keyLen <= crypto_generichash_KEYBYTES_MAX) {
+        crypto_generichash(out_derivedKey, derivedKeyLen,
+                           reinterpret_cast<const unsigned char *>(context), std::strlen(context),
+                           key, keyLen);
+    } else {
+        crypto_generichash_state state;
+        crypto_generichash_init(&state, nullptr, 0, derivedKeyLen);
+        crypto_generichash_update(&state, reinterpret_cast<const unsigned char *>(context), std::strlen(context));
+        crypto_generichash_update(&state, key, keyLen);
+        crypto_generichash_final(&state, out_derivedKey, derivedKeyLen);
+    }
+}
+
+void Crypto::Impl::Encrypt(CBC_Mode<AES>::Encryption &enc, const Byte *iv,
+                           const std::string &plainText, std::string &out_encodedText)
+{
+    /// PKCS #7 padding, the same as StreamTransformationFilter's default
+    const std::size_t padding = AES::BLOCKSIZE - plainText.size() % AES::BLOCKSIZE;
+    SecByteBlock block(plainText.size() + padding);
+
+    std::memcpy(block.data(), plainText.data(), plainText.size());
+    std::memset(block.data() + plainText.size(), static_cast<int>(padding), padding);
+
+    /// Every message starts over from the same IV, as before
+    enc.Resynchronize(iv);
+    enc.ProcessData(block.data(), block.data(), block.size());
+
+    HexEncode(block.data(), block.size(), out_encodedText);
+}
+
+bool Crypto::Impl::Decrypt(CBC_Mode<AES>::Decryption &dec, const Byte *iv,
+                           const std::string &cipherText, std::string &out_recoveredText,
+                           std::string &out_error)
+{
+    string cipher;
+    if (!HexDecode(cipherText, cipher)) {
+        out_error.assign(INVALID_HEX_ERROR);
+        return false;
+    }
+
+    if (cipher.empty() || cipher.size() % AES::BLOCKSIZE != 0) {
+        out_error.assign(INVALID_CIPHER_ERROR);
+        return false;
+    }
+
+    SecByteBlock block(reinterpret_cast<const Byte *>(cipher.data()), cipher.size());
+
+    dec.Resynchronize(iv);
+    dec.ProcessData(block.data(), block.data(), block.size());
+
+    const std::size_t padding = block[block.size() - 1];
+    if (padding == 0 || padding > AES::BLOCKSIZE) {
+        out_error.assign(INVALID_CIPHER_ERROR);
+        return false;
+    }
+
+    for (std::size_t i = block.size() - padding; i < block.size(); ++i) {
+        if (block[i] != padding) {
+            out_error.assign(INVALID_CIPHER_ERROR);
+            return false;
+        }
+    }
+
+    out_recoveredText.assign(reinterpret_cast<const char *>(block.data()), block.size() - padding);
+
+    return true;
 }
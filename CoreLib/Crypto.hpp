@@ -29,8 +29,9 @@
  *
  * @section DESCRIPTION
  *
- * Provides AES and SHA512 cryptographic operations in addition to fast Base64
- * encoding or decoding functions.
+ * Provides AES and SHA512 cryptographic operations, authenticated self-expiring
+ * tokens, keyed message signatures, in addition to fast Base64 encoding or
+ * decoding functions.
  */
 
 
@@ -41,6 +42,7 @@
 #include <memory>
 #include <string>
 #include <cstddef>
+#include <ctime>
 #include <sodium.h>
 
 namespace CoreLib {
@@ -97,6 +99,10 @@ public:
                         const Argon2iMemLimit &memLimit = Argon2iMemLimit::Moderate);
     static bool Argon2iVerify(const std::string &passwd, const std::string &hashedPasswd);
 
+    /// Upper-case, same as CryptoPP::HexEncoder; decoding accepts either case
+    static void HexEncode(const Byte *data, const std::size_t length, std::string &out_hex);
+    static bool HexDecode(const std::string &hex, std::string &out_data);
+
     static std::string ByteArrayToString(const unsigned char *array, const size_t length);
     static std::wstring WCharArrayToString(const wchar_t *array, const size_t length);
 
@@ -114,6 +120,18 @@ public:
     bool Decrypt(const std::string &cipherText, std::string &out_recoveredText);
     bool Decrypt(const std::string &cipherText, std::string &out_recoveredText,
                  std::string &out_error);
+
+    /// Versioned XChaCha20-Poly1305 over the expiry and the payload, base64url
+    /// encoded. Opening a forged, mangled or expired token fails fast, without
+    /// throwing.
+    bool SealToken(const std::string &payload, const std::time_t expiry, std::string &out_token);
+    bool OpenToken(const std::string &token, std::string &out_payload);
+    bool OpenToken(const std::string &token, std::string &out_payload, std::time_t &out_expiry);
+
+    /// HMAC-SHA-256 over the message, base64url encoded. Verification runs in
+    /// constant time.
+    bool Sign(const std::string &message, std::string &out_signature);
+    bool VerifySignature(const std::string &message, const std::string &signature);
 };
 
 
@@ -34,22 +34,35 @@
  */
 
 
+#include <atomic>
+#include <map>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
 #include <cstring>
+#include <ctime>
 #include <boost/algorithm/string.hpp>
+#include <boost/chrono/chrono.hpp>
 #include <boost/format.hpp>
 #include <boost/thread/lock_guard.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <libpq-fe.h>
 #include <pqxx/pqxx>
 #include "make_unique.hpp"
+#include "Crypto.hpp"
 #include "Database.hpp"
 #include "Log.hpp"
 #include "SharedObjectPool.hpp"
 
 #define     MAX_DATABASE_CONNECTIONS    16
+#define     MAX_REPLICA_CONNECTIONS     8
+#define     REPLICA_LAG_CHECK_SECONDS   5
+#define     REPLICA_RETRY_MSEC          10
+#define     LISTENER_POLL_SECONDS       1
+#define     LISTENER_RECONNECT_SECONDS  5
+#define     MIGRATIONS_LOCK_KEY         1634038113
 #define     QUERY_SUCCEED               "CoreLib::Database ==>  Query succeed!"
 #define     UNKNOWN_ERROR               "Unknow database error!"
 
@@ -65,14 +78,90 @@ struct Database::Impl
     typedef std::unordered_map<std::string, std::string> TableNamesHashTable;
     typedef std::unordered_map<std::string, std::string> TableFieldsHashTable;
 
+    std::string ConnectionString;
+
     SharedObjectPool<pqxx::connection> Connections;
     boost::mutex ConnectionsMutex;
 
+    struct Replica
+    {
+        std::string ConnectionString;
+        SharedObjectPool<pqxx::connection> Connections;
+        std::size_t Capacity;
+
+        /// Seconds since epoch of the last lag check, and its outcome
+        std::atomic<std::time_t> LagCheckTime;
+        std::atomic<bool> Lagging;
+
+        Replica() : Capacity(0), LagCheckTime(0), Lagging(false) { }
+    };
+
+    std::vector<std::unique_ptr<Replica>> Replicas;
+    std::atomic<std::size_t> NextReplica;
+    int MaxReplicationLag;
+
     EnumNamesHashTable EnumNames;
     EnumeratorsHashTable Enumerators;
 
     TableNamesHashTable TableNames;
     TableFieldsHashTable TableFields;
+
+    struct Migration
+    {
+        std::string Description;
+        std::string Sql;
+        std::string Checksum;
+    };
+
+    /// Ordered by version
+    std::map<int, Migration> Migrations;
+
+    class Receiver : public pqxx::notification_receiver
+    {
+    private:
+        Database::Impl *m_impl;
+
+    public:
+        Receiver(pqxx::connection_base &conn, const std::string &channel, Database::Impl *impl)
+            : pqxx::notification_receiver(conn, channel),
+              m_impl(impl)
+        {
+
+        }
+
+        void operator()(const std::string &payload, int backendPid) override
+        {
+            (void)backendPid;
+            m_impl->Dispatch(channel(), payload, false);
+        }
+    };
+
+    typedef std::unordered_map<ListenerId, NotificationCallback> CallbacksHashTable;
+    typedef std::unordered_map<std::string, CallbacksHashTable> ListenersHashTable;
+    typedef std::unordered_map<std::string, std::unique_ptr<Receiver>> ReceiversHashTable;
+
+    /// Recursive, so that callbacks are able to (un)register listeners, while
+    /// Unlisten() is still guaranteed not to return during an in-flight call
+    ListenersHashTable Listeners;
+    ListenerId LastListenerId;
+    boost::recursive_mutex ListenersMutex;
+
+    std::unique_ptr<boost::thread> ListenerThread;
+
+    Impl();
+
+    static void Connect(SharedObjectPool<pqxx::connection> &pool, const std::string &connectionString,
+                        const int count, const std::string &label);
+    static void Disconnect(SharedObjectPool<pqxx::connection> &pool, const std::string &label);
+
+    SharedObjectPool<pqxx::connection>::ptrType ReplicaConnection();
+    bool IsLagging(Replica &replica, pqxx::connection &conn);
+
+    void Dispatch(const std::string &channel, const std::string &payload, bool catchUp);
+    void Subscribe(pqxx::connection_base &conn, ReceiversHashTable &receivers);
+    void Listen();
+
+    bool IsSchemaCurrent(pqxx::connection_base &conn, const std::string &versionTable);
 };
 
 std::string Database::Escape(const char *begin, const char *end)
@@ -118,31 +207,30 @@ bool Database::IsTrue(const std::string &value)
     return false;
 }
 
-Database::Database(const std::string &connectionString) :
+Database::Database(const std::string &connectionString,
+                   const std::vector<std::string> &replicaConnectionStrings,
+                   const int maxReplicationLag) :
     m_pimpl(make_unique<Database::Impl>())
 {
     boost::lock_guard<boost::mutex> lock(m_pimpl->ConnectionsMutex);
     (void)lock;
 
+    m_pimpl->ConnectionString = connectionString;
+    m_pimpl->MaxReplicationLag = maxReplicationLag;
+
     LOG_INFO("Setting up database connections...");
 
-    for (int i = 0; i < MAX_DATABASE_CONNECTIONS; ++i) {
-        try {
-            std::unique_ptr<pqxx::connection> c(
-                        std::make_unique<pqxx::connection>(connectionString));
-            c->inhibit_reactivation(false);
-            c->activate();
+    Impl::Connect(m_pimpl->Connections, connectionString, MAX_DATABASE_CONNECTIONS, "Database");
 
-            LOG_INFO((format("Database connection #%1% succeed!") % i).str(), (boost::format("Backend PID: %1%") % c->backendpid()).str(), (boost::format("Socket: %1%") % c->sock()).str(), (boost::format("Host Name: %1%") % c->hostname()).str(), (boost::format("Port Number: %1%") % c->port()).str(), (boost::format("Database Name: %1%") % c->dbname()).str(), (boost::format("User Name: %1%") % c->username()).str());
+    for (std::size_t r = 0; r < replicaConnectionStrings.size(); ++r) {
+        auto replica = make_unique<Impl::Replica>();
+        replica->ConnectionString = replicaConnectionStrings[r];
 
-            m_pimpl->Connections.Add(c);
-        } catch (const pqxx::sql_error &ex) {
-            LOG_FATAL((format("Database connection #%1% failed!") % i).str(), ex.what());
-        } catch (const std::exception &ex) {
-            LOG_FATAL((format("Database connection #%1% failed!") % i).str(), ex.what());
-        } catch (...) {
-            LOG_FATAL((format("Database connection #%1% failed!") % i).str(), UNKNOWN_ERROR);
-        }
+        Impl::Connect(replica->Connections, replica->ConnectionString, MAX_REPLICA_CONNECTIONS,
+                      (format("Replica #%1%") % r).str());
+        replica->Capacity = replica->Connections.Size();
+
+        m_pimpl->Replicas.push_back(std::move(replica));
     }
 
     LOG_INFO("Database connections setup successfully!");
@@ -150,31 +238,31 @@ Database::Database(const std::string &connectionString) :
 
 Database::~Database()
 {
+    if (m_pimpl->ListenerThread) {
+        m_pimpl->ListenerThread->interrupt();
+        m_pimpl->ListenerThread->join();
+    }
+
     boost::lock_guard<boost::mutex> lock(m_pimpl->ConnectionsMutex);
     (void)lock;
 
-    size_t i = 0;
-    while (!m_pimpl->Connections.Empty()) {
-        try {
-            auto c(m_pimpl->Connections.Pool().top().release());
-            c->disconnect();
+    Impl::Disconnect(m_pimpl->Connections, "Database");
 
-            LOG_INFO((format("Database connection #%1% disconnected successfully!") % i).str(), (boost::format("Backend PID: %1%") % c->backendpid()).str(), (boost::format("Socket: %1%") % c->sock()).str(), (boost::format("Host Name: %1%") % c->hostname()).str(), (boost::format("Port Number: %1%") % c->port()).str(), (boost::format("Database Name: %1%") % c->dbname()).str(), (boost::format("User Name: %1%") % c->username()).str());
-
-            m_pimpl->Connections.Pool().pop();
-            ++i;
-        } catch (const pqxx::sql_error &ex) {
-            LOG_ERROR((format("Failed to disconnect from connection #%1%!") % i).str(), ex.what());
-        } catch (const std::exception &ex) {
-            LOG_ERROR((format("Failed to disconnect from connection #%1%!") % i).str(), ex.what());
-        } catch (...) {
-            LOG_ERROR((format("Failed to disconnect from connection #%1%!") % i).str(), UNKNOWN_ERROR);
-        }
+    for (std::size_t r = 0; r < m_pimpl->Replicas.size(); ++r) {
+        Impl::Disconnect(m_pimpl->Replicas[r]->Connections, (format("Replica #%1%") % r).str());
     }
 }
 
-SharedObjectPool<pqxx::connection>::ptrType Database::Connection()
+SharedObjectPool<pqxx::connection>::ptrType Database::Connection(const Intent &intent)
 {
+    if (intent == Intent::ReadOnly && !m_pimpl->Replicas.empty()) {
+        auto c(m_pimpl->ReplicaConnection());
+        if (c)
+            return c;
+
+        /// No replica is fit to serve us; read from the primary instead
+    }
+
     for (;;) {
         size_t connectionNumber = MAX_DATABASE_CONNECTIONS - m_pimpl->Connections.Size();
 
@@ -208,6 +296,11 @@ SharedObjectPool<pqxx::connection>::ptrType Database::Connection()
     return c;
 }
 
+const std::string &Database::GetConnectionString() const
+{
+    return m_pimpl->ConnectionString;
+}
+
 bool Database::CreateEnum(const std::string &id)
 {
     try {
@@ -505,20 +598,176 @@ bool Database::SetTableFields(const std::string &id, const std::string &fields)
     return false;
 }
 
-bool Database::Initialize()
+Database::ListenerId Database::Listen(const std::string &channel, NotificationCallback callback)
+{
+    boost::lock_guard<boost::recursive_mutex> lock(m_pimpl->ListenersMutex);
+    (void)lock;
+
+    ListenerId id = ++m_pimpl->LastListenerId;
+    m_pimpl->Listeners[channel][id] = callback;
+
+    if (!m_pimpl->ListenerThread) {
+        m_pimpl->ListenerThread = make_unique<boost::thread>(&Database::Impl::Listen, m_pimpl.get());
+    }
+
+    return id;
+}
+
+void Database::Unlisten(const ListenerId id)
+{
+    boost::lock_guard<boost::recursive_mutex> lock(m_pimpl->ListenersMutex);
+    (void)lock;
+
+    for (auto it = m_pimpl->Listeners.begin(); it != m_pimpl->Listeners.end(); ++it) {
+        if (it->second.erase(id) > 0) {
+            if (it->second.empty()) {
+                m_pimpl->Listeners.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+bool Database::Notify(const std::string &channel, const std::string &payload)
+{
+    try {
+        auto c = this->Connection();
+        c->activate();
+        pqxx::work txn(*c.get());
+
+        Notify(txn, channel, payload);
+
+        txn.commit();
+
+        return true;
+    } catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    } catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    } catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+void Database::Notify(pqxx::transaction_base &txn, const std::string &channel, const std::string &payload)
 {
-    LOG_INFO("Initializing CoreLib::Database...");
+    /// Delivered only once, and only if, the transaction commits
+    pqxx::result r = txn.exec((format("SELECT pg_notify( %1%, %2% );")
+                               % txn.quote(channel)
+                               % txn.quote(payload)).str());
+
+    LOG_INFO(QUERY_SUCCEED, r.query());
+}
+
+void Database::RegisterMigration(const int version,
+                                 const std::string &description,
+                                 const std::string &sql)
+{
+    Impl::Migration m;
+    m.Description = description;
+    m.Sql = sql;
+    Crypto::Hash(sql, m.Checksum);
+
+    m_pimpl->Migrations[version] = std::move(m);
+}
+
+bool Database::Migrate(const std::string &versionTableId)
+{
+    LOG_INFO("Migrating CoreLib::Database...");
 
     try {
-        for (const auto &e : m_pimpl->EnumNames) {
-            CreateEnum(e.first);
+        const std::string versionTable(GetTableName(versionTableId));
+
+        auto c = this->Connection();
+        c->activate();
+
+        if (m_pimpl->IsSchemaCurrent(*c.get(), versionTable)) {
+            LOG_INFO("CoreLib::Database schema is up to date!");
+            return true;
         }
 
-        for (const auto &t : m_pimpl->TableNames) {
-            CreateTable(t.first);
+        pqxx::work txn(*c.get());
+
+        /// Keeps concurrently booting processes from migrating at the same
+        /// time; released on commit or rollback
+        pqxx::result r = txn.exec((format("SELECT pg_advisory_xact_lock( %1% );")
+                                   % MIGRATIONS_LOCK_KEY).str());
+
+        LOG_INFO(QUERY_SUCCEED, r.query());
+
+        r = txn.exec((format("CREATE TABLE IF NOT EXISTS \"%1%\" ("
+                             " version INTEGER NOT NULL PRIMARY KEY,"
+                             " description TEXT,"
+                             " checksum TEXT,"
+                             " applied_time TIMESTAMPTZ"
+                             " );"
+                             " ALTER TABLE \"%1%\""
+                             " ADD COLUMN IF NOT EXISTS description TEXT,"
+                             " ADD COLUMN IF NOT EXISTS checksum TEXT,"
+                             " ADD COLUMN IF NOT EXISTS applied_time TIMESTAMPTZ;")
+                      % txn.esc(versionTable)).str());
+
+        LOG_INFO(QUERY_SUCCEED, r.query());
+
+        /// A version without a checksum has been recorded before migrations
+        /// were tracked one by one; it does not tell which steps actually ran,
+        /// so those get forgotten and every step is applied again. Steps that
+        /// predate the tracking are written to be re-runnable.
+        r = txn.exec((format("DELETE FROM \"%1%\" WHERE checksum IS NULL;")
+                      % txn.esc(versionTable)).str());
+
+        LOG_INFO(QUERY_SUCCEED, r.query());
+
+        r = txn.exec((format("SELECT version, checksum FROM \"%1%\" ORDER BY version ASC;")
+                      % txn.esc(versionTable)).str());
+
+        LOG_INFO(QUERY_SUCCEED, r.query());
+
+        std::map<int, std::string> applied;
+        for (const auto &row : r) {
+            applied[row["version"].as<int>()] = row["checksum"].as<std::string>();
         }
 
-        LOG_INFO("CoreLib::Crypto initialized successfully!");
+        for (const auto &a : applied) {
+            auto it = m_pimpl->Migrations.find(a.first);
+
+            if (it == m_pimpl->Migrations.end()) {
+                LOG_WARNING("CoreLib::Database schema is newer than this build!", a.first);
+                continue;
+            }
+
+            if (it->second.Checksum != a.second) {
+                LOG_ERROR("CoreLib::Database migration has been modified after being applied!",
+                          a.first, it->second.Description);
+                return false;
+            }
+        }
+
+        for (const auto &m : m_pimpl->Migrations) {
+            if (applied.find(m.first) != applied.end())
+                continue;
+
+            LOG_INFO("Applying CoreLib::Database migration...", m.first, m.second.Description);
+
+            r = txn.exec(m.second.Sql);
+
+            LOG_INFO(QUERY_SUCCEED, m.first);
+
+            r = txn.exec((format("INSERT INTO \"%1%\" ( version, description, checksum, applied_time )"
+                                 " VALUES ( %2%, %3%, %4%, NOW() );")
+                          % txn.esc(versionTable)
+                          % m.first
+                          % txn.quote(m.second.Description)
+                          % txn.quote(m.second.Checksum)).str());
+
+            LOG_INFO(QUERY_SUCCEED, r.query());
+        }
+
+        txn.commit();
+
+        LOG_INFO("CoreLib::Database migrated successfully!");
 
         return true;
     } catch (const pqxx::sql_error &ex) {
@@ -531,3 +780,281 @@ bool Database::Initialize()
 
     return false;
 }
+
+Database::Impl::Impl()
+    : NextReplica(0),
+      MaxReplicationLag(0),
+      LastListenerId(0)
+{
+
+}
+
+void Database::Impl::Connect(SharedObjectPool<pqxx::connection> &pool, const std::string &connectionString,
+                             const int count, const std::string &label)
+{
+    for (int i = 0; i < count; ++i) {
+        try {
+            std::unique_ptr<pqxx::connection> c(
+                        std::make_unique<pqxx::connection>(connectionString));
+            c->inhibit_reactivation(false);
+            c->activate();
+
+            LOG_INFO((format("%1% connection #%2% succeed!") % label % i).str(), (boost::format("Backend PID: %1%") % c->backendpid()).str(), (boost::format("Socket: %1%") % c->sock()).str(), (boost::format("Host Name: %1%") % c->hostname()).str(), (boost::format("Port Number: %1%") % c->port()).str(), (boost::format("Database Name: %1%") % c->dbname()).str(), (boost::format("User Name: %1%") % c->username()).str());
+
+            pool.Add(c);
+        } catch (const pqxx::sql_error &ex) {
+            LOG_FATAL((format("%1% connection #%2% failed!") % label % i).str(), ex.what());
+        } catch (const std::exception &ex) {
+            LOG_FATAL((format("%1% connection #%2% failed!") % label % i).str(), ex.what());
+        } catch (...) {
+            LOG_FATAL((format("%1% connection #%2% failed!") % label % i).str(), UNKNOWN_ERROR);
+        }
+    }
+}
+
+void Database::Impl::Disconnect(SharedObjectPool<pqxx::connection> &pool, const std::string &label)
+{
+    size_t i = 0;
+    while (!pool.Empty()) {
+        try {
+            auto c(pool.Pool().top().release());
+            c->disconnect();
+
+            LOG_INFO((format("%1% connection #%2% disconnected successfully!") % label % i).str(), (boost::format("Backend PID: %1%") % c->backendpid()).str(), (boost::format("Socket: %1%") % c->sock()).str(), (boost::format("Host Name: %1%") % c->hostname()).str(), (boost::format("Port Number: %1%") % c->port()).str(), (boost::format("Database Name: %1%") % c->dbname()).str(), (boost::format("User Name: %1%") % c->username()).str());
+
+            pool.Pool().pop();
+            ++i;
+        } catch (const pqxx::sql_error &ex) {
+            LOG_ERROR((format("Failed to disconnect from %1% connection #%2%!") % label % i).str(), ex.what());
+        } catch (const std::exception &ex) {
+            LOG_ERROR((format("Failed to disconnect from %1% connection #%2%!") % label % i).str(), ex.what());
+        } catch (...) {
+            LOG_ERROR((format("Failed to disconnect from %1% connection #%2%!") % label % i).str(), UNKNOWN_ERROR);
+        }
+    }
+}
+
+SharedObjectPool<pqxx::connection>::ptrType Database::Impl::ReplicaConnection()
+{
+    for (;;) {
+        bool anyFit = false;
+
+        /// Round-robin, starting past whoever got the previous request
+        const std::size_t first = NextReplica++;
+
+        for (std::size_t n = 0; n < Replicas.size(); ++n) {
+            Replica &replica = *Replicas[(first + n) % Replicas.size()];
+
+            if (replica.Capacity == 0)
+                continue;
+
+            if (replica.Lagging && std::time(nullptr) - replica.LagCheckTime < REPLICA_LAG_CHECK_SECONDS)
+                continue;
+
+            try {
+                /// Checking Empty() first would race with other threads
+                /// taking the last connection
+                auto c(replica.Connections.TryAcquire());
+                if (!c) {
+                    /// Busy but otherwise fine, worth waiting for
+                    anyFit = true;
+                    continue;
+                }
+
+                c->activate();
+
+                if (IsLagging(replica, *c.get()))
+                    continue;
+
+                return c;
+            } catch (const pqxx::sql_error &ex) {
+                LOG_ERROR("Replica connection acquisition failed!", ex.what());
+            } catch (const std::exception &ex) {
+                LOG_ERROR("Replica connection acquisition failed!", ex.what());
+            } catch (...) {
+                LOG_ERROR("Replica connection acquisition failed!", UNKNOWN_ERROR);
+            }
+
+            /// Give a failing replica some rest before trying it again
+            replica.LagCheckTime = std::time(nullptr);
+            replica.Lagging = true;
+        }
+
+        if (!anyFit)
+            break;
+
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(REPLICA_RETRY_MSEC));
+    }
+
+    return SharedObjectPool<pqxx::connection>::ptrType();
+}
+
+bool Database::Impl::IsLagging(Replica &replica, pqxx::connection &conn)
+{
+    if (MaxReplicationLag <= 0)
+        return false;
+
+    const std::time_t now = std::time(nullptr);
+    if (now - replica.LagCheckTime < REPLICA_LAG_CHECK_SECONDS)
+        return replica.Lagging;
+
+    replica.LagCheckTime = now;
+
+    /// PostgreSQL 10 renamed the xlog functions to wal ones
+    const bool wal = conn.server_version() >= 100000;
+
+    /// An idle primary does not move the replay timestamp forward, so only
+    /// count the lag while there is still WAL left to replay
+    pqxx::nontransaction txn(conn);
+    pqxx::result r = txn.exec((format("SELECT CASE"
+                                      " WHEN %1%() = %2%() THEN 0"
+                                      " ELSE COALESCE( EXTRACT( EPOCH FROM NOW() - pg_last_xact_replay_timestamp() ), 0 )"
+                                      " END AS lag;")
+                               % (wal ? "pg_last_wal_receive_lsn" : "pg_last_xlog_receive_location")
+                               % (wal ? "pg_last_wal_replay_lsn" : "pg_last_xlog_replay_location")).str());
+
+    const double lag = r.empty() ? 0.0 : r[0]["lag"].as<double>();
+    replica.Lagging = lag > static_cast<double>(MaxReplicationLag);
+
+    if (replica.Lagging) {
+        LOG_WARNING("Replica is lagging behind the primary!", (format("%1% seconds") % lag).str());
+    }
+
+    return replica.Lagging;
+}
+
+void Database::Impl::Dispatch(const std::string &channel, const std::string &payload, bool catchUp)
+{
+    boost::lock_guard<boost::recursive_mutex> lock(ListenersMutex);
+    (void)lock;
+
+    auto it = Listeners.find(channel);
+    if (it == Listeners.end())
+        return;
+
+    if (!catchUp) {
+        LOG_INFO("Database notification received!", channel, payload);
+    }
+
+    /// A callback may unregister itself or others, so iterate over a copy
+    CallbacksHashTable callbacks(it->second);
+
+    for (const auto &c : callbacks) {
+        try {
+            c.second(channel, payload);
+        } catch (const std::exception &ex) {
+            LOG_ERROR(ex.what(), channel);
+        } catch (...) {
+            LOG_ERROR(UNKNOWN_ERROR, channel);
+        }
+    }
+}
+
+void Database::Impl::Subscribe(pqxx::connection_base &conn, ReceiversHashTable &receivers)
+{
+    boost::lock_guard<boost::recursive_mutex> lock(ListenersMutex);
+    (void)lock;
+
+    for (auto it = receivers.begin(); it != receivers.end();) {
+        if (Listeners.find(it->first) == Listeners.end()) {
+            LOG_INFO("Unlistening database notification channel...", it->first);
+            it = receivers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::vector<std::string> subscribed;
+
+    for (const auto &l : Listeners) {
+        if (receivers.find(l.first) == receivers.end()) {
+            LOG_INFO("Listening on database notification channel...", l.first);
+            receivers[l.first] = make_unique<Receiver>(conn, l.first, this);
+            subscribed.push_back(l.first);
+        }
+    }
+
+    for (const auto &channel : subscribed) {
+        Dispatch(channel, "", true);
+    }
+}
+
+void Database::Impl::Listen()
+{
+    LOG_INFO("Database notification listener thread started");
+
+    for (;;) {
+        try {
+            /// A dedicated connection, since LISTEN is bound to the session
+            /// and pooled connections are handed out to anyone.
+            pqxx::connection conn(ConnectionString);
+
+            /// Declared after the connection in order to get destroyed first
+            ReceiversHashTable receivers;
+
+            for (;;) {
+                boost::this_thread::interruption_point();
+                Subscribe(conn, receivers);
+                conn.await_notification(LISTENER_POLL_SECONDS, 0);
+            }
+        }
+
+        catch (const boost::thread_interrupted &) {
+            break;
+        }
+
+        catch (const pqxx::broken_connection &ex) {
+            LOG_ERROR("Database notification listener lost its connection!", ex.what());
+        }
+
+        catch (const std::exception &ex) {
+            LOG_ERROR(ex.what());
+        }
+
+        catch (...) {
+            LOG_ERROR(UNKNOWN_ERROR);
+        }
+
+        try {
+            boost::this_thread::sleep_for(boost::chrono::seconds(LISTENER_RECONNECT_SECONDS));
+        } catch (const boost::thread_interrupted &) {
+            break;
+        }
+    }
+
+    LOG_INFO("Database notification listener thread stopped");
+}
+
+bool Database::Impl::IsSchemaCurrent(pqxx::connection_base &conn, const std::string &versionTable)
+{
+    try {
+        pqxx::work txn(conn);
+
+        pqxx::result r = txn.exec((format("SELECT version, checksum FROM \"%1%\" ORDER BY version ASC;")
+                                   % txn.esc(versionTable)).str());
+
+        txn.commit();
+
+        std::map<int, std::string> applied;
+        for (const auto &row : r) {
+            if (row["checksum"].is_null())
+                return false;
+
+            applied[row["version"].as<int>()] = row["checksum"].as<std::string>();
+        }
+
+        for (const auto &m : Migrations) {
+            auto it = applied.find(m.first);
+            if (it == applied.end() || it->second != m.second.Checksum)
+                return false;
+        }
+
+        return true;
+    } catch (const pqxx::sql_error &ex) {
+        /// Either a brand new database, or one from before the checksums;
+        /// the locked path sorts both out
+        (void)ex;
+    }
+
+    return false;
+}
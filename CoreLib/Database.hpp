@@ -38,17 +38,37 @@
 #define CORELIB_DATABASE_HPP
 
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include <pqxx/connection>
 #include "SharedObjectPool.hpp"
 
+namespace pqxx {
+class transaction_base;
+}
+
 namespace CoreLib {
 class Database;
 }
 
 class CoreLib::Database
 {
+public:
+    /// Read-only work may be routed to a replica, if there is any
+    enum class Intent : unsigned char {
+        ReadWrite,
+        ReadOnly
+    };
+
+    /// Gets called on the notification listener thread with the channel name
+    /// and the payload; an empty payload is also delivered right after the
+    /// channel has been (re-)subscribed, so that whoever relies on it can
+    /// catch up on notifications missed while the listener was disconnected.
+    typedef std::function<void(const std::string &, const std::string &)> NotificationCallback;
+    typedef std::size_t ListenerId;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> m_pimpl;
@@ -61,10 +81,15 @@ public:
     static bool IsTrue(const std::string &value);
 
 public:
-    explicit Database(const std::string &connectionString);
+    /// A replica lagging behind the primary by more than maxReplicationLag
+    /// seconds gets skipped until it catches up; 0 disables the check
+    explicit Database(const std::string &connectionString,
+                      const std::vector<std::string> &replicaConnectionStrings = { },
+                      const int maxReplicationLag = 0);
     virtual ~Database();
 
-    SharedObjectPool<pqxx::connection>::ptrType Connection();
+    SharedObjectPool<pqxx::connection>::ptrType Connection(const Intent &intent = Intent::ReadWrite);
+    const std::string &GetConnectionString() const;
 
     bool CreateEnum(const std::string &id);
 
@@ -96,7 +121,23 @@ public:
     bool SetTableName(const std::string &id, const std::string &newName);
     bool SetTableFields(const std::string &id, const std::string &fields);
 
-    bool Initialize();
+    ListenerId Listen(const std::string &channel, NotificationCallback callback);
+    void Unlisten(const ListenerId id);
+    bool Notify(const std::string &channel, const std::string &payload = "");
+    void Notify(pqxx::transaction_base &txn, const std::string &channel, const std::string &payload = "");
+
+    /// Migrations get applied in ascending version order, each exactly once;
+    /// the SQL of an applied migration must never change afterwards, since
+    /// its checksum gets verified on every run.
+    void RegisterMigration(const int version,
+                           const std::string &description,
+                           const std::string &sql);
+
+    /// Brings the schema up to the latest registered migration in a single
+    /// transaction, serialized among processes by an advisory lock, and
+    /// records the applied steps in the given table. Returns right away
+    /// without taking any lock once the schema is current.
+    bool Migrate(const std::string &versionTableId);
 };
 
 
@@ -44,6 +44,7 @@
 #include <boost/thread/lock_guard.hpp>
 #include <boost/thread/mutex.hpp>
 #include "make_unique.hpp"
+#include "CDate.hpp"
 #include "Log.hpp"
 
 using namespace std;
@@ -158,7 +159,7 @@ Log::Log(const EType type, const std::string &file, const std::string &func, con
 {
     assert(s_pimpl->Storage()->Initialized);
 
-    m_buffer << "[ " << posix_time::second_clock::local_time()
+    m_buffer << "[ " << CDate::DateConv::LogTimeStamp()
              << " " << s_pimpl->Storage()->LogTypeHash[type]
                 << " " << line << " " << func << " " << file << " ]"
                 << "\n";
@@ -34,11 +34,15 @@
 
 
 #include <chrono>
+#include <list>
 #include <queue>
+#include <unordered_map>
 #include <boost/bind.hpp>
 #include <boost/chrono/chrono.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/thread/lock_guard.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
@@ -48,12 +52,17 @@
 #include <vmime/platforms/posix/posixHandler.hpp>
 #include <vmime/vmime.hpp>
 #endif  // defined (_WIN32 )
+#include <vmime/utility/encoder/encoderFactory.hpp>
+#include <vmime/utility/inputStreamStringAdapter.hpp>
+#include <vmime/utility/outputStreamStringAdapter.hpp>
 #include "make_unique.hpp"
+#include "FileSystem.hpp"
 #include "Log.hpp"
 #include "Mail.hpp"
 #include "Utility.hpp"
 
 #define     WORKER_THREAD_STOP_IDLE_MILLISECONDS        10000.0
+#define     DEFAULT_ATTACHMENT_CACHE_LIMIT              (64 * 1024 * 1024)
 #define     UNKNOWN_ERROR                               "Unknown error!"
 
 using namespace std;
@@ -62,6 +71,17 @@ using namespace CoreLib;
 
 struct Mail::Impl
 {
+public:
+    struct CachedAttachment
+    {
+        std::string Key;
+        vmime::shared_ptr<vmime::attachment> Attachment;
+        std::size_t Size;
+    };
+
+    typedef std::list<CachedAttachment> AttachmentCacheList;
+    typedef std::unordered_map<std::string, AttachmentCacheList::iterator> AttachmentCacheHashTable;
+
 public:
     static std::queue<Mail *> MailQueue;
     static std::queue<Mail::SendCallback> MailCallbackQueue;
@@ -70,9 +90,19 @@ public:
     static boost::mutex WorkerMutex;
     static std::unique_ptr<boost::thread> WorkerThread;
 
+    /// Most recently used attachments are kept at the front
+    static AttachmentCacheList AttachmentCache;
+    static AttachmentCacheHashTable AttachmentCacheIndex;
+    static std::size_t AttachmentCacheSize;
+    static std::size_t AttachmentCacheLimit;
+    static boost::mutex AttachmentCacheMutex;
+
 public:
     static void DoWork();
 
+    static vmime::shared_ptr<vmime::attachment> GetAttachment(const std::string &file);
+    static vmime::shared_ptr<vmime::attachment> CreateAttachment(const std::string &file, std::size_t &out_size);
+
 public:
     std::string From;
     std::string To;
@@ -93,6 +123,11 @@ bool Mail::Impl::WorkerThreadIsRunning = false;
 boost::mutex Mail::Impl::MailMutex;
 boost::mutex Mail::Impl::WorkerMutex;
 std::unique_ptr<boost::thread> Mail::Impl::WorkerThread;
+Mail::Impl::AttachmentCacheList Mail::Impl::AttachmentCache;
+Mail::Impl::AttachmentCacheHashTable Mail::Impl::AttachmentCacheIndex;
+std::size_t Mail::Impl::AttachmentCacheSize = 0;
+std::size_t Mail::Impl::AttachmentCacheLimit = DEFAULT_ATTACHMENT_CACHE_LIMIT;
+boost::mutex Mail::Impl::AttachmentCacheMutex;
 
 void Mail::Impl::DoWork()
 {
@@ -189,6 +224,131 @@ void Mail::Impl::DoWork()
     LOG_INFO("Mail worker thread stopped");
 }
 
+vmime::shared_ptr<vmime::attachment> Mail::Impl::GetAttachment(const std::string &file)
+{
+    /// The modification time is part of the key, so a file that has been
+    /// replaced on disk never gets served from a stale entry.
+    const std::string key((boost::format("%1%:%2%")
+                           % file
+                           % filesystem::last_write_time(file)).str());
+
+    {
+        boost::lock_guard<boost::mutex> lock(AttachmentCacheMutex);
+        (void)lock;
+
+        auto it = AttachmentCacheIndex.find(key);
+        if (it != AttachmentCacheIndex.end()) {
+            AttachmentCache.splice(AttachmentCache.begin(), AttachmentCache, it->second);
+            return it->second->Attachment;
+        }
+    }
+
+    /// Encode outside the lock, so that other senders won't have to wait for us
+    std::size_t size = 0;
+    vmime::shared_ptr<vmime::attachment> attachment = CreateAttachment(file, size);
+
+    boost::lock_guard<boost::mutex> lock(AttachmentCacheMutex);
+    (void)lock;
+
+    /// Another thread may have cached the very same file in the meantime
+    auto it = AttachmentCacheIndex.find(key);
+    if (it != AttachmentCacheIndex.end()) {
+        AttachmentCache.splice(AttachmentCache.begin(), AttachmentCache, it->second);
+        return it->second->Attachment;
+    }
+
+    /// Do not let a single huge file flush the whole cache
+    if (size > AttachmentCacheLimit) {
+        LOG_WARNING("Attachment exceeds the attachment cache limit; it won't be cached!", file,
+                    (boost::format("Encoded size: %1%") % size).str(),
+                    (boost::format("Cache limit: %1%") % AttachmentCacheLimit).str());
+        return attachment;
+    }
+
+    while (!AttachmentCache.empty() && AttachmentCacheSize + size > AttachmentCacheLimit) {
+        AttachmentCacheSize -= AttachmentCache.back().Size;
+        AttachmentCacheIndex.erase(AttachmentCache.back().Key);
+        AttachmentCache.pop_back();
+    }
+
+    AttachmentCache.push_front({ key, attachment, size });
+    AttachmentCacheIndex[key] = AttachmentCache.begin();
+    AttachmentCacheSize += size;
+
+    return attachment;
+}
+
+vmime::shared_ptr<vmime::attachment> Mail::Impl::CreateAttachment(const std::string &file, std::size_t &out_size)
+{
+    std::string data;
+    if (!FileSystem::Read(file, data)) {
+        throw std::runtime_error((boost::format("Failed to read the attachment '%1%'!") % file).str());
+    }
+
+    vmime::shared_ptr<vmime::utility::encoder::encoder> encoder =
+            vmime::utility::encoder::encoderFactory::getInstance()->create(vmime::encodingTypes::BASE64);
+
+    vmime::string encoded;
+    vmime::utility::inputStreamStringAdapter in(data);
+    vmime::utility::outputStreamStringAdapter out(encoded);
+    encoder->encode(in, out);
+
+    out_size = encoded.size();
+
+    /// Since the content handler is already in the transfer encoding of the
+    /// attachment, vmime copies it verbatim on every message generation.
+    vmime::shared_ptr<vmime::stringContentHandler> contents =
+            vmime::make_shared<vmime::stringContentHandler>(
+                encoded, vmime::encoding(vmime::encodingTypes::BASE64));
+
+    return vmime::make_shared<vmime::defaultAttachment>(
+                contents,
+                vmime::encoding(vmime::encodingTypes::BASE64),
+                vmime::mediaType("application/octet-stream"),
+                vmime::text(filesystem::path(file).stem().string()),
+                vmime::word(filesystem::path(file).filename().string()));
+}
+
+std::size_t Mail::GetAttachmentCacheSize()
+{
+    boost::lock_guard<boost::mutex> lock(Impl::AttachmentCacheMutex);
+    (void)lock;
+
+    return Impl::AttachmentCacheSize;
+}
+
+std::size_t Mail::GetAttachmentCacheLimit()
+{
+    boost::lock_guard<boost::mutex> lock(Impl::AttachmentCacheMutex);
+    (void)lock;
+
+    return Impl::AttachmentCacheLimit;
+}
+
+void Mail::SetAttachmentCacheLimit(const std::size_t limit)
+{
+    boost::lock_guard<boost::mutex> lock(Impl::AttachmentCacheMutex);
+    (void)lock;
+
+    Impl::AttachmentCacheLimit = limit;
+
+    while (!Impl::AttachmentCache.empty() && Impl::AttachmentCacheSize > Impl::AttachmentCacheLimit) {
+        Impl::AttachmentCacheSize -= Impl::AttachmentCache.back().Size;
+        Impl::AttachmentCacheIndex.erase(Impl::AttachmentCache.back().Key);
+        Impl::AttachmentCache.pop_back();
+    }
+}
+
+void Mail::ClearAttachmentCache()
+{
+    boost::lock_guard<boost::mutex> lock(Impl::AttachmentCacheMutex);
+    (void)lock;
+
+    Impl::AttachmentCacheIndex.clear();
+    Impl::AttachmentCache.clear();
+    Impl::AttachmentCacheSize = 0;
+}
+
 Mail::Mail()
     : m_pimpl(std::make_shared<Mail::Impl>())
 {
@@ -299,11 +459,8 @@ bool Mail::Send(std::string &out_error) const
         mb.getTextPart()->setText(vmime::make_shared<vmime::stringContentHandler>(m_pimpl->Body));
 
         if (m_pimpl->Attachments.size() > 0) {
-            for (auto a : m_pimpl->Attachments) {
-                vmime::shared_ptr <vmime::attachment> att = vmime::make_shared <vmime::fileAttachment>
-                        (a, vmime::mediaType("application/octet-stream"),
-                         vmime::text(filesystem::path(a).stem().string()));
-                mb.appendAttachment(att);
+            for (const auto &a : m_pimpl->Attachments) {
+                mb.appendAttachment(Impl::GetAttachment(a));
             }
         }
 
@@ -37,6 +37,7 @@
 #define CORELIB_MAILER_HPP
 
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
@@ -55,6 +56,12 @@ private:
     struct Impl;
     std::shared_ptr<Impl> m_pimpl;
 
+public:
+    static std::size_t GetAttachmentCacheSize();
+    static std::size_t GetAttachmentCacheLimit();
+    static void SetAttachmentCacheLimit(const std::size_t limit);
+    static void ClearAttachmentCache();
+
 public:
     Mail();
     Mail(const std::string &from, const std::string &to,
@@ -29,19 +29,33 @@
  *
  * @section DESCRIPTION
  *
- * Provides useful random functions.
+ * Provides useful random functions, backed by a per-thread ChaCha20 keystream
+ * which is seeded from the operating system and needs no locking.
  */
 
 
+#include <algorithm>
 #include <unordered_map>
-#include <boost/random/random_device.hpp>
-#include <boost/uuid/random_generator.hpp>
-#include <boost/uuid/uuid.hpp>
-#include <boost/uuid/uuid_io.hpp>
+#include <cerrno>
+#include <cstring>
+#if defined ( __linux__ )
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // defined ( __linux__ )
+#include <sodium.h>
 #include <CoreLib/make_unique.hpp>
 #include "Random.hpp"
 #include "Utility.hpp"
 
+/// Enough for a few hundred UUIDs or session tokens per refill
+#define     RANDOM_BUFFER_SIZE          4096
+
+/// Room for rejection sampling while filling Characters() in a single draw
+#define     RANDOM_CHARACTERS_CHUNK     64
+
+#define     UUID_BYTES                  16
+#define     UUID_LENGTH                 36
+
 using namespace std;
 using namespace boost;
 using namespace CoreLib;
@@ -52,20 +66,69 @@ public:
     typedef std::unordered_map<const CoreLib::Random::Character, const std::string,
     CoreLib::Utility::Hasher<const CoreLib::Random::Character>> CharactersHashTable;
 
+    /// Fast-key-erasure ChaCha20: every refill rekeys from its own output, so a
+    /// leaked state never reveals anything handed out before
+    struct ThreadState
+    {
+    public:
+        unsigned char Key[crypto_stream_chacha20_ietf_KEYBYTES];
+        unsigned char Buffer[crypto_stream_chacha20_ietf_KEYBYTES + RANDOM_BUFFER_SIZE];
+        std::size_t Offset;
+
+    public:
+        ThreadState();
+        ~ThreadState();
+
+    public:
+        void Refill();
+        void Read(unsigned char *out_buffer, std::size_t length);
+    };
+
 public:
     static CharactersHashTable &GetLookupTable();
+    static ThreadState &GetThreadState();
+    static void Seed(unsigned char *out_seed, const std::size_t length);
 };
 
+Random::Engine::result_type Random::Engine::operator()()
+{
+    result_type value;
+    Impl::GetThreadState().Read(reinterpret_cast<unsigned char *>(&value), sizeof(value));
+    return value;
+}
+
+void Random::Bytes(unsigned char *out_buffer, const std::size_t length)
+{
+    Impl::GetThreadState().Read(out_buffer, length);
+}
+
 void Random::Characters(const Character &type, const size_t length, std::string &out_chars)
 {
-    boost::lock_guard<boost::mutex> guard(GetLock());
+    const string &chars = Impl::GetLookupTable().at(type);
+
+    /// Only accept bytes below the largest multiple of the alphabet size, so
+    /// that the modulo does not favour the first few characters
+    const unsigned int size = static_cast<unsigned int>(chars.size());
+    const unsigned int limit = 256 - (256 % size);
 
-    random::uniform_int_distribution<> index_dist(0, static_cast<int>(Impl::GetLookupTable()[type].size()) - 1);
+    Impl::ThreadState &state = Impl::GetThreadState();
+    unsigned char chunk[RANDOM_CHARACTERS_CHUNK];
 
-    out_chars.clear();
-    for (size_t i = 0; i < length; ++i) {
-        out_chars += Impl::GetLookupTable()[type][static_cast<size_t>(index_dist(GetEngine()))];
+    out_chars.resize(length);
+
+    size_t i = 0;
+    while (i < length) {
+        const size_t draw = std::min(sizeof(chunk), length - i);
+        state.Read(chunk, draw);
+
+        for (size_t j = 0; j < draw && i < length; ++j) {
+            if (chunk[j] < limit) {
+                out_chars[i++] = chars[chunk[j] % size];
+            }
+        }
     }
+
+    sodium_memzero(chunk, sizeof(chunk));
 }
 
 std::string Random::Characters(const Character &type, const size_t length)
@@ -77,9 +140,24 @@ std::string Random::Characters(const Character &type, const size_t length)
 
 void Random::Uuid(std::string &out_uuid)
 {
-    static uuids::basic_random_generator<random::mt19937> rng(&GetEngine());
-    uuids::uuid u = rng();
-    out_uuid.assign(uuids::to_string(u));
+    static const char DIGITS[] = "0123456789abcdef";
+
+    unsigned char bytes[UUID_BYTES];
+    Impl::GetThreadState().Read(bytes, sizeof(bytes));
+
+    /// Version 4, variant 10xx
+    bytes[6] = static_cast<unsigned char>((bytes[6] & 0x0F) | 0x40);
+    bytes[8] = static_cast<unsigned char>((bytes[8] & 0x3F) | 0x80);
+
+    out_uuid.resize(UUID_LENGTH);
+
+    char *out = &out_uuid[0];
+    for (size_t i = 0; i < UUID_BYTES; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+            *out++ = '-';
+        *out++ = DIGITS[bytes[i] >> 4];
+        *out++ = DIGITS[bytes[i] & 0x0F];
+    }
 }
 
 std::string Random::Uuid()
@@ -89,17 +167,47 @@ std::string Random::Uuid()
     return uuid;
 }
 
-boost::random::mt19937 &Random::GetEngine()
+Random::Impl::ThreadState::ThreadState()
 {
-    static random::random_device rd;
-    static random::mt19937 rng(rd);
-    return rng;
+    Seed(Key, sizeof(Key));
+    Refill();
 }
 
-boost::mutex &Random::GetLock()
+Random::Impl::ThreadState::~ThreadState()
 {
-    static boost::mutex lock;
-    return lock;
+    sodium_memzero(Key, sizeof(Key));
+    sodium_memzero(Buffer, sizeof(Buffer));
+}
+
+void Random::Impl::ThreadState::Refill()
+{
+    /// The key changes on every refill, so an all-zero nonce never repeats
+    static const unsigned char NONCE[crypto_stream_chacha20_ietf_NONCEBYTES] = { 0 };
+
+    crypto_stream_chacha20_ietf(Buffer, sizeof(Buffer), NONCE, Key);
+
+    std::copy(Buffer, Buffer + sizeof(Key), Key);
+    sodium_memzero(Buffer, sizeof(Key));
+
+    Offset = sizeof(Key);
+}
+
+void Random::Impl::ThreadState::Read(unsigned char *out_buffer, std::size_t length)
+{
+    while (length > 0) {
+        if (Offset == sizeof(Buffer))
+            Refill();
+
+        const std::size_t count = std::min(length, sizeof(Buffer) - Offset);
+
+        /// Hand out and wipe, never give away the same bytes twice
+        std::memcpy(out_buffer, Buffer + Offset, count);
+        std::memset(Buffer + Offset, 0, count);
+
+        Offset += count;
+        out_buffer += count;
+        length -= count;
+    }
 }
 
 Random::Impl::CharactersHashTable &Random::Impl::GetLookupTable()
@@ -120,3 +228,32 @@ Random::Impl::CharactersHashTable &Random::Impl::GetLookupTable()
     };
     return lookupTable;
 }
+
+Random::Impl::ThreadState &Random::Impl::GetThreadState()
+{
+    /// Plain thread_local rather than boost::thread_specific_ptr, since this is
+    /// hit for every single number
+    static thread_local ThreadState state;
+    return state;
+}
+
+void Random::Impl::Seed(unsigned char *out_seed, const std::size_t length)
+{
+#if defined ( __linux__ ) && defined ( SYS_getrandom )
+    std::size_t filled = 0;
+    while (filled < length) {
+        const long ret = syscall(SYS_getrandom, out_seed + filled, length - filled, 0);
+        if (ret > 0) {
+            filled += static_cast<std::size_t>(ret);
+        } else if (ret < 0 && errno != EINTR) {
+            break;
+        }
+    }
+
+    if (filled == length)
+        return;
+#endif  // defined ( __linux__ ) && defined ( SYS_getrandom )
+
+    /// Kernels without getrandom(2) and other platforms
+    randombytes_buf(out_seed, length);
+}
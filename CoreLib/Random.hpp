@@ -29,7 +29,8 @@
  *
  * @section DESCRIPTION
  *
- * Provides useful random functions.
+ * Provides useful random functions, backed by a per-thread ChaCha20 keystream
+ * which is seeded from the operating system and needs no locking.
  */
 
 
@@ -38,11 +39,9 @@
 
 
 #include <string>
-#include <boost/random/mersenne_twister.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <boost/random/uniform_int_distribution.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/lock_guard.hpp>
-#include "System.hpp"
 
 namespace CoreLib {
 class Random;
@@ -66,27 +65,48 @@ public:
         Upper
     };
 
+    /// Draws from the calling thread's keystream; satisfies the
+    /// UniformRandomBitGenerator requirements, hence works with any distribution
+    class Engine
+    {
+    public:
+        typedef std::uint32_t result_type;
+
+    public:
+        static constexpr result_type min()
+        {
+            return 0;
+        }
+
+        static constexpr result_type max()
+        {
+            return UINT32_MAX;
+        }
+
+    public:
+        result_type operator()();
+    };
+
 private:
     struct Impl;
 
 public:
+    static void Bytes(unsigned char *out_buffer, const std::size_t length);
+
     static void Characters(const Character &type, const size_t length, std::string &out_chars);
     static std::string Characters(const Character &type, const size_t length);
 
     template <typename _T>
     static _T Number(const _T lowerBound, const _T upperBound)
     {
-        boost::lock_guard<boost::mutex> guard(GetLock());
-        boost::random::uniform_int_distribution<> dist(lowerBound, upperBound);
-        return dist(GetEngine());
+        Engine engine;
+        boost::random::uniform_int_distribution<_T> dist(lowerBound, upperBound);
+        return dist(engine);
     }
 
+    /// Version 4, lower-case, RFC 4122 formatted
     static void Uuid(std::string &out_uuid);
     static std::string Uuid();
-
-private:
-    static boost::random::mt19937 &GetEngine();
-    static boost::mutex &GetLock();
 };
 
 
@@ -115,6 +115,24 @@ public:
         return std::move(tmp);
     }
 
+    /// Same as Acquire(), but hands out an empty pointer instead of throwing
+    /// when there is nothing left to acquire
+    ptrType TryAcquire() {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        (void)lock;
+
+        if (m_pool.empty()) {
+            return ptrType();
+        }
+
+        ptrType tmp(m_pool.top().release(),
+                    ReturnToPoolDeleter{
+                        std::weak_ptr<SharedObjectPool<_T, _D> *>{m_thisPtr}});
+        m_pool.pop();
+
+        return std::move(tmp);
+    }
+
     bool Empty() const
     {
         return m_pool.empty();
@@ -68,3 +68,41 @@ std::string Utility::CalculateSize(const std::size_t size)
     result.assign("0");
     return result;
 }
+
+void Utility::AppendJsonString(const std::string &value, std::string &out_json)
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    out_json.push_back('"');
+
+    for (const char c : value) {
+        switch (c) {
+        case '"':
+            out_json.append("\\\"");
+            break;
+        case '\\':
+            out_json.append("\\\\");
+            break;
+        case '\n':
+            out_json.append("\\n");
+            break;
+        case '\r':
+            out_json.append("\\r");
+            break;
+        case '\t':
+            out_json.append("\\t");
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out_json.append("\\u00");
+                out_json.push_back(HEX[(c >> 4) & 0x0f]);
+                out_json.push_back(HEX[c & 0x0f]);
+            } else {
+                out_json.push_back(c);
+            }
+            break;
+        }
+    }
+
+    out_json.push_back('"');
+}
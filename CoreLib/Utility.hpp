@@ -87,6 +87,9 @@ public:
     }
 
     static std::string CalculateSize(const std::size_t size);
+
+    /// Appends value as a quoted JSON string; value is expected to be UTF-8
+    static void AppendJsonString(const std::string &value, std::string &out_json);
 };
 
 
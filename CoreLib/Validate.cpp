@@ -0,0 +1,249 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Hand-written, single-pass validators for the formats the service used to
+ * check through boost::regex. They run in linear time, never allocate and
+ * cannot be made to backtrack by crafted input.
+ */
+
+
+#include <cstddef>
+#include <cstring>
+#include "Validate.hpp"
+
+#define     UUID_LENGTH         36
+
+using namespace std;
+using namespace CoreLib;
+
+struct Validate::Impl
+{
+public:
+    /// [a-z0-9!#$%&'*+/=?^_`{|}~-]
+    static bool IsLocal(const char c)
+    {
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+            return true;
+
+        switch (c) {
+        case '!': case '#': case '$': case '%': case '&': case '\'': case '*': case '+':
+        case '/': case '=': case '?': case '^': case '_': case '`': case '{': case '|':
+        case '}': case '~': case '-':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /// [a-z0-9]
+    static bool IsLabel(const char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+    }
+
+    /// [a-z]
+    static bool IsLower(const char c)
+    {
+        return c >= 'a' && c <= 'z';
+    }
+
+    /// [0-9a-f]
+    static bool IsHex(const char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    }
+
+    /// \w in the C locale
+    static bool IsWord(const char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+public:
+    static bool LocalPart(const char *begin, const char *end);
+    static bool TopLevelDomain(const char *begin, const char *end, const bool whole);
+    static bool Domain(const char *begin, const char *end, const bool whole);
+};
+
+bool Validate::Email(const std::string &text)
+{
+    const char *begin = text.data();
+    const char *end = begin + text.size();
+
+    /// '@' is not a local character, hence the first one is the separator
+    const char *at = static_cast<const char *>(std::memchr(begin, '@', text.size()));
+    if (at == nullptr)
+        return false;
+
+    return Impl::LocalPart(begin, at) && Impl::Domain(at + 1, end, true);
+}
+
+bool Validate::ContainsEmail(const std::string &text)
+{
+    const char *begin = text.data();
+    const char *end = begin + text.size();
+
+    /// An unanchored match only needs a single local character right before
+    /// some '@', followed by a domain which ends on a word boundary
+    for (const char *at = begin + 1; at < end; ++at) {
+        if (*at == '@' && Impl::IsLocal(*(at - 1)) && Impl::Domain(at + 1, end, false))
+            return true;
+    }
+
+    return false;
+}
+
+bool Validate::Uuid(const std::string &text)
+{
+    if (text.size() != UUID_LENGTH)
+        return false;
+
+    for (std::size_t i = 0; i < UUID_LENGTH; ++i) {
+        const char c = text[i];
+
+        switch (i) {
+        case 8:
+        case 13:
+        case 18:
+        case 23:
+            if (c != '-')
+                return false;
+            break;
+        case 14:
+            /// Version
+            if (c < '1' || c > '5')
+                return false;
+            break;
+        case 19:
+            /// Variant
+            if (c != '8' && c != '9' && c != 'a' && c != 'b')
+                return false;
+            break;
+        default:
+            if (!Impl::IsHex(c))
+                return false;
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool Validate::LanguageArray(const std::string &text)
+{
+    /// An optional leading comma, then en or fa items separated by commas
+    std::size_t i = (!text.empty() && text[0] == ',') ? 1 : 0;
+
+    for (;;) {
+        if (text.size() - i < 2)
+            return false;
+
+        if (!((text[i] == 'e' && text[i + 1] == 'n') || (text[i] == 'f' && text[i + 1] == 'a')))
+            return false;
+
+        i += 2;
+
+        if (i == text.size())
+            return true;
+
+        if (text[i] != ',')
+            return false;
+
+        ++i;
+    }
+}
+
+bool Validate::Impl::LocalPart(const char *begin, const char *end)
+{
+    /// One or more runs of local characters separated by single dots
+    bool expectRun = true;
+
+    for (const char *p = begin; p < end; ++p) {
+        if (*p == '.') {
+            if (expectRun)
+                return false;
+            expectRun = true;
+        } else if (IsLocal(*p)) {
+            expectRun = false;
+        } else {
+            return false;
+        }
+    }
+
+    return !expectRun;
+}
+
+bool Validate::Impl::TopLevelDomain(const char *begin, const char *end, const bool whole)
+{
+    static const char *const NAMES[] = {
+        "com", "org", "net", "edu", "gov", "mil", "biz", "info", "mobi", "name", "aero", "asia", "jobs", "museum"
+    };
+
+    const std::size_t available = static_cast<std::size_t>(end - begin);
+
+    /// Either the whole rest of the text, or followed by a word boundary
+    auto isAccepted = [&](const std::size_t length) {
+        return whole ? length == available : (length == available || !IsWord(begin[length]));
+    };
+
+    if (available >= 2 && IsLower(begin[0]) && IsLower(begin[1]) && isAccepted(2))
+        return true;
+
+    for (const char *name : NAMES) {
+        const std::size_t length = std::strlen(name);
+        if (length <= available && std::memcmp(begin, name, length) == 0 && isAccepted(length))
+            return true;
+    }
+
+    return false;
+}
+
+bool Validate::Impl::Domain(const char *begin, const char *end, const bool whole)
+{
+    /// One or more labels, each followed by a dot, then a top-level domain.
+    /// Labels cannot contain dots, so the only choice left is after which of
+    /// them the top-level domain begins; each one gets tried once.
+    const char *p = begin;
+
+    for (;;) {
+        const char *label = p;
+        while (p < end && (IsLabel(*p) || *p == '-'))
+            ++p;
+
+        if (p == label || p == end || *p != '.' || !IsLabel(*label) || !IsLabel(*(p - 1)))
+            return false;
+
+        ++p;
+
+        if (TopLevelDomain(p, end, whole))
+            return true;
+    }
+}
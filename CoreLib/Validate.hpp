@@ -0,0 +1,69 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Hand-written, single-pass validators for the formats the service used to
+ * check through boost::regex. They run in linear time, never allocate and
+ * cannot be made to backtrack by crafted input.
+ */
+
+
+#ifndef CORELIB_VALIDATE_HPP
+#define CORELIB_VALIDATE_HPP
+
+
+#include <string>
+
+namespace CoreLib {
+class Validate;
+}
+
+class CoreLib::Validate
+{
+private:
+    struct Impl;
+
+public:
+    /// Same as regex_match() with Service::Pool::Storage().RegexEmail()
+    static bool Email(const std::string &text);
+
+    /// Same as regex_search() with Service::Pool::Storage().RegexEmail(), i.e.
+    /// true if an address appears anywhere in the text
+    static bool ContainsEmail(const std::string &text);
+
+    /// Same as Service::Pool::Storage().RegexUuid(), over the whole text
+    static bool Uuid(const std::string &text);
+
+    /// Same as Service::Pool::Storage().RegexLanguageArray(), over the whole text
+    static bool LanguageArray(const std::string &text);
+};
+
+
+#endif /* CORELIB_VALIDATE_HPP */
@@ -0,0 +1,206 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs Argon2i password hashing and verification on a small pool of worker
+ * threads, admitting only as many jobs at once as the memory budget allows,
+ * and hands the outcome back to the requesting Wt session.
+ */
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <Wt/WApplication>
+#include <Wt/WServer>
+#if defined ( __unix__ )
+#include <unistd.h>
+#endif  // defined ( __unix__ )
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "Argon2Executor.hpp"
+#include "WorkerPool.hpp"
+
+#define     ARGON2_MAX_WORKERS              4
+#define     ARGON2_MAX_QUEUE_DEPTH          64
+#define     ARGON2_MEMORY_BUDGET_PERCENT    25
+
+using namespace std;
+using namespace boost;
+using namespace Wt;
+using namespace CoreLib;
+using namespace Service;
+
+struct Argon2Executor::Impl
+{
+public:
+    WorkerPool Workers;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    static std::size_t PhysicalMemory();
+    static std::size_t MemoryCost(const std::string &hashedPasswd);
+};
+
+Argon2Executor::Argon2Executor()
+    : m_pimpl(make_unique<Argon2Executor::Impl>())
+{
+
+}
+
+Argon2Executor::~Argon2Executor()
+{
+    Stop();
+}
+
+void Argon2Executor::Start()
+{
+    /// A single job has to fit no matter what, otherwise it would never run
+    const std::size_t physicalMemory = Impl::PhysicalMemory();
+    const std::size_t memoryBudget = std::max(
+                physicalMemory / 100 * ARGON2_MEMORY_BUDGET_PERCENT,
+                static_cast<std::size_t>(CoreLib::Crypto::Argon2iMemLimit::Sensitive));
+
+    /// Each job keeps a whole core busy; leave the rest to Wt
+    const std::size_t workers = std::min<std::size_t>(
+                std::max<std::size_t>(boost::thread::hardware_concurrency() / 2, 1),
+                ARGON2_MAX_WORKERS);
+
+    m_pimpl->Workers.Start("argon2", workers, ARGON2_MAX_QUEUE_DEPTH, memoryBudget);
+
+    LOG_INFO("Argon2 executor started!",
+             (boost::format("Memory budget: %1% MiB") % (memoryBudget / 1024 / 1024)).str());
+}
+
+void Argon2Executor::Stop()
+{
+    m_pimpl->Workers.Stop();
+}
+
+bool Argon2Executor::Hash(const std::string &passwd,
+                          const CoreLib::Crypto::Argon2iOpsLimit &opsLimit,
+                          const CoreLib::Crypto::Argon2iMemLimit &memLimit,
+                          const HashHandler &handler)
+{
+    WApplication *app = WApplication::instance();
+    const string sessionId(app->sessionId());
+
+    const bool queued = m_pimpl->Workers.Post([=]() {
+        string hashedPasswd;
+        const bool succeeded = CoreLib::Crypto::Argon2i(passwd, hashedPasswd, opsLimit, memLimit);
+
+        WServer::instance()->post(sessionId, [=]() {
+            WApplication::instance()->resumeRendering();
+            handler(succeeded, hashedPasswd);
+            WApplication::instance()->triggerUpdate();
+        });
+    }, static_cast<std::size_t>(memLimit));
+
+    if (queued)
+        app->deferRendering();
+
+    return queued;
+}
+
+bool Argon2Executor::Verify(const std::string &passwd, const std::string &hashedPasswd,
+                            const VerifyHandler &handler)
+{
+    WApplication *app = WApplication::instance();
+    const string sessionId(app->sessionId());
+
+    const bool queued = m_pimpl->Workers.Post([=]() {
+        const bool verified = CoreLib::Crypto::Argon2iVerify(passwd, hashedPasswd);
+
+        WServer::instance()->post(sessionId, [=]() {
+            WApplication::instance()->resumeRendering();
+            handler(verified);
+            WApplication::instance()->triggerUpdate();
+        });
+    }, Impl::MemoryCost(hashedPasswd));
+
+    if (queued)
+        app->deferRendering();
+
+    return queued;
+}
+
+Argon2Executor::Metrics Argon2Executor::GetMetrics() const
+{
+    const WorkerPool::Metrics pool = m_pimpl->Workers.GetMetrics();
+
+    Metrics metrics;
+    metrics.Workers = pool.Workers;
+    metrics.QueueDepth = pool.QueueDepth;
+    metrics.PeakQueueDepth = pool.PeakQueueDepth;
+    metrics.Running = pool.Running;
+    metrics.MemoryInUse = pool.CostInUse;
+    metrics.MemoryBudget = pool.CostBudget;
+    metrics.Submitted = pool.Submitted;
+    metrics.Completed = pool.Completed;
+    metrics.Rejected = pool.Rejected;
+    metrics.AverageWaitMilliseconds = pool.AverageWaitMilliseconds;
+
+    return metrics;
+}
+
+Argon2Executor::Impl::Impl() = default;
+
+Argon2Executor::Impl::~Impl() = default;
+
+std::size_t Argon2Executor::Impl::PhysicalMemory()
+{
+#if defined ( __unix__ )
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && pageSize > 0)
+        return static_cast<std::size_t>(pages) * static_cast<std::size_t>(pageSize);
+#endif  // defined ( __unix__ )
+
+    return 0;
+}
+
+std::size_t Argon2Executor::Impl::MemoryCost(const std::string &hashedPasswd)
+{
+    /// The encoded hash carries its own parameters, e.g.
+    /// $argon2i$v=19$m=32768,t=4,p=1$<salt>$<hash>, with m in KiB.
+    /// Assume the worst whenever it cannot be figured out.
+    const string::size_type pos = hashedPasswd.find("$m=");
+    if (pos != string::npos) {
+        const unsigned long long kib = std::strtoull(hashedPasswd.c_str() + pos + 3, nullptr, 10);
+        if (kib > 0)
+            return static_cast<std::size_t>(kib) * 1024;
+    }
+
+    return static_cast<std::size_t>(CoreLib::Crypto::Argon2iMemLimit::Sensitive);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs Argon2i password hashing and verification on a small pool of worker
+ * threads, admitting only as many jobs at once as the memory budget allows,
+ * and hands the outcome back to the requesting Wt session.
+ */
+
+
+#ifndef SERVICE_ARGON2_EXECUTOR_HPP
+#define SERVICE_ARGON2_EXECUTOR_HPP
+
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <CoreLib/Crypto.hpp>
+
+namespace Service {
+class Argon2Executor;
+}
+
+class Service::Argon2Executor
+{
+public:
+    typedef std::function<void(const bool succeeded, const std::string &hashedPasswd)> HashHandler;
+    typedef std::function<void(const bool verified)> VerifyHandler;
+
+    struct Metrics
+    {
+        std::size_t Workers;
+        std::size_t QueueDepth;
+        std::size_t PeakQueueDepth;
+        std::size_t Running;
+        std::size_t MemoryInUse;
+        std::size_t MemoryBudget;
+        uint_fast64_t Submitted;
+        uint_fast64_t Completed;
+        uint_fast64_t Rejected;
+        uint_fast64_t AverageWaitMilliseconds;
+    };
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    Argon2Executor();
+    virtual ~Argon2Executor();
+
+public:
+    void Start();
+    void Stop();
+
+    /// Both must be called from within a Wt session; rendering of the current
+    /// request is deferred until the handler has run inside that same session.
+    /// Returns false, without ever calling the handler, when the queue is full.
+    bool Hash(const std::string &passwd,
+              const CoreLib::Crypto::Argon2iOpsLimit &opsLimit,
+              const CoreLib::Crypto::Argon2iMemLimit &memLimit,
+              const HashHandler &handler);
+    bool Verify(const std::string &passwd, const std::string &hashedPasswd,
+                const VerifyHandler &handler);
+
+    Metrics GetMetrics() const;
+};
+
+
+#endif /* SERVICE_ARGON2_EXECUTOR_HPP */
@@ -46,8 +46,8 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
-#include <boost/regex.hpp>
 #include <boost/thread/once.hpp>
+#include <Wt/Http/Request>
 #include <Wt/WApplication>
 #include <Wt/WEnvironment>
 #include <cereal/archives/json.hpp>
@@ -60,9 +60,11 @@
 #include <CoreLib/Log.hpp>
 #include <CoreLib/make_unique.hpp>
 #include <CoreLib/Utility.hpp>
+#include <CoreLib/Validate.hpp>
 #include "CgiEnv.hpp"
 #include "Exception.hpp"
 #include "Pool.hpp"
+#include "SubscriptionLink.hpp"
 
 #define     UNKNOWN_ERROR                   "Unknown error!"
 #define     GEO_LOCATION_INITIALIZE_ERROR   "Failed to initialize GeoIP record!"
@@ -159,6 +161,9 @@ public:
 
     static const char* TranslateMaxMindError(int errorCode);
 
+    /// Never derived from the Host header, which is up to the client
+    static void FillServer(CgiEnv::InformationRecord::ServerRecord &out_server);
+
     FORCEINLINE static char *BytesToHex(
             const uint8_t *bytes, const uint32_t size)
     {
@@ -534,6 +539,46 @@ CgiEnv::CgiEnv()
 
 CgiEnv::~CgiEnv() = default;
 
+void CgiEnv::FromRequest(const Wt::Http::Request &request, const std::string &language,
+                         InformationRecord &out_info)
+{
+    Impl::FillServer(out_info.Server);
+
+    out_info.Client.IPAddress = request.clientAddress();
+    out_info.Client.UserAgent = request.userAgent();
+    out_info.Client.Referer = request.headerValue("Referer");
+
+    string lang(language);
+
+    if (lang != "en" && lang != "fa") {
+        /// Same as what WEnvironment::getCookie("lang") would return
+        const string cookies(" " + request.headerValue("Cookie"));
+        string::size_type pos = cookies.find(" lang=");
+        if (pos == string::npos)
+            pos = cookies.find(";lang=");
+        if (pos != string::npos) {
+            pos += 6;
+            lang = trim_copy(cookies.substr(pos, cookies.find(';', pos) - pos));
+        }
+    }
+
+    if (lang != "en" && lang != "fa") {
+        lang = algorithm::istarts_with(request.headerValue("Accept-Language"), "fa") ? "fa" : "en";
+    }
+
+    if (lang == "fa") {
+        out_info.Client.Language.Code = InformationRecord::ClientRecord::LanguageCode::Fa;
+        out_info.Client.Language.PageDirection = InformationRecord::ClientRecord::PageDirection::RightToLeft;
+    } else {
+        out_info.Client.Language.Code = InformationRecord::ClientRecord::LanguageCode::En;
+        out_info.Client.Language.PageDirection = InformationRecord::ClientRecord::PageDirection::LeftToRight;
+    }
+    out_info.Client.Language.CodeAsString = lang;
+
+    out_info.Subscription.Subscribe = InformationRecord::SubscriptionRecord::Action::None;
+    out_info.Subscription.Timestamp = 0;
+}
+
 const CgiEnv::InformationRecord &CgiEnv::GetInformation() const
 {
     return m_pimpl->Information;
@@ -569,6 +614,14 @@ void CgiEnv::SetSubscriptionInbox(const std::string &inbox)
     m_pimpl->Information.Subscription.Inbox.assign(inbox);
 }
 
+void CgiEnv::Impl::FillServer(CgiEnv::InformationRecord::ServerRecord &out_server)
+{
+    out_server.Hostname = Pool::Storage().ServiceHostname();
+    out_server.Url = Pool::Storage().ServiceUrl();
+    out_server.RootLoginUrl = out_server.Url + "/?root";
+    out_server.NoReplyAddress = "no-reply@" + out_server.Hostname;
+}
+
 const char* CgiEnv::Impl::TranslateMaxMindError(int errorCode)
 {
     switch (errorCode) {
@@ -654,12 +707,7 @@ void CgiEnv::Impl::Initialize()
 {
     WApplication *app = WApplication::instance();
 
-    this->Information.Server.Hostname = app->environment().hostName();
-    this->Information.Server.Url = app->environment().urlScheme() + "://" + this->Information.Server.Hostname;
-    this->Information.Server.RootLoginUrl = this->Information.Server.Url
-            + (algorithm::ends_with(this->Information.Server.Url, "/") ? "" : "/")
-            + "?root";
-    this->Information.Server.NoReplyAddress = "no-reply@" + this->Information.Server.Hostname;
+    FillServer(this->Information.Server);
 
     this->Information.Client.IPAddress = app->environment().clientAddress();
     this->Information.Client.UserAgent = app->environment().userAgent();
@@ -676,8 +724,14 @@ void CgiEnv::Impl::Initialize()
             ? true : false;
 
     this->Information.Subscription.Subscribe = InformationRecord::SubscriptionRecord::Action::None;
+    this->Information.Subscription.Timestamp = 0;
 
     bool logout = false;
+    string tokenRecipient;
+    string linkAction;
+    string linkLanguages;
+    string linkExpiry;
+    string linkSignature;
 
     Http::ParameterMap map = app->environment().getParameterMap();
     for (std::map<string, Http::ParameterValues>::const_iterator it = map.begin(); it != map.end(); ++it) {
@@ -706,6 +760,7 @@ void CgiEnv::Impl::Initialize()
                 if (it->second[0] == "1" || it->second[0] == "2"
                         || it->second[0] == "-1" || it->second[0] == "-2") {
                     auto action = lexical_cast<short>(it->second[0]);
+                    linkAction.assign(it->second[0]);
                     this->Information.Subscription.Subscribe = static_cast<InformationRecord::SubscriptionRecord::Action>(action);
                 }
             } catch (...) {
@@ -714,17 +769,14 @@ void CgiEnv::Impl::Initialize()
         }
 
         if (it->first == "inbox" && it->second[0] != "") {
-            static const regex REGEX(Pool::Storage().RegexEmail());
-            smatch result;
-            if (regex_search(it->second[0], result, REGEX)) {
+            if (CoreLib::Validate::ContainsEmail(it->second[0])) {
                 this->Information.Subscription.Inbox.assign(it->second[0]);
             }
         }
 
         if (it->first == "subscription" && it->second[0] != "") {
-            static const regex REGEX(Pool::Storage().RegexLanguageArray());
-            smatch result;
-            if (regex_search(it->second[0], result, REGEX)) {
+            if (CoreLib::Validate::LanguageArray(it->second[0])) {
+                linkLanguages.assign(it->second[0]);
                 vector<string> vec;
                 split(vec, it->second[0], boost::is_any_of(","));
                 vector<InformationRecord::SubscriptionRecord::Language> langs;
@@ -740,27 +792,47 @@ void CgiEnv::Impl::Initialize()
         }
 
         if (it->first == "recipient" && it->second[0] != "") {
-            static const regex REGEX(Pool::Storage().RegexUuid());
-            smatch result;
-            if (regex_search(it->second[0], result, REGEX)) {
+            if (CoreLib::Validate::Uuid(it->second[0])) {
                 this->Information.Subscription.Uuid.assign(it->second[0]);
             }
         }
 
         if (it->first == "token" && it->second[0] != "") {
-            try {
-                string token;
-                Pool::Crypto().Decrypt(it->second[0], token);
-                this->Information.Subscription.Timestamp = lexical_cast<time_t>(token);
-            } catch (...) {
+            time_t expiry;
+            if (Pool::Crypto().OpenToken(it->second[0], tokenRecipient, expiry)) {
+                this->Information.Subscription.Timestamp = expiry;
             }
         }
 
+        if (it->first == "expires" && it->second[0] != "") {
+            linkExpiry.assign(it->second[0]);
+        }
+
+        if (it->first == "signature" && it->second[0] != "") {
+            linkSignature.assign(it->second[0]);
+        }
+
         if (it->first == "contact-form") {
             this->Information.Client.Request.ContactForm = true;
         }
     }
 
+    /// A token issued for someone else is as good as none
+    if (this->Information.Subscription.Timestamp != 0
+            && tokenRecipient != this->Information.Subscription.Uuid) {
+        this->Information.Subscription.Timestamp = 0;
+    }
+
+    /// Confirmation and unsubscribe links must be signed by us. Forget about
+    /// the recipient of a forged one, so no page ever looks it up.
+    if (this->Information.Subscription.Subscribe == InformationRecord::SubscriptionRecord::Action::Confirm
+            || this->Information.Subscription.Subscribe == InformationRecord::SubscriptionRecord::Action::Unsubscribe) {
+        if (!SubscriptionLink::Verify(linkAction, this->Information.Subscription.Uuid, linkLanguages,
+                                      linkExpiry, linkSignature, this->Information.Subscription.Timestamp)) {
+            this->Information.Subscription.Uuid.clear();
+        }
+    }
+
     if (this->Information.Client.Request.Root.Login && logout) {
         this->Information.Client.Request.Root.Logout = true;
     }
@@ -46,6 +46,9 @@
 
 namespace Wt {
 class WEnvironment;
+namespace Http {
+class Request;
+}
 }
 
 namespace Service {
@@ -277,6 +280,7 @@ public:
             std::string Inbox;
             std::vector<Language> Languages;
             std::string Uuid;
+            /// Expiry of a valid cancellation token or a signed link, 0 if there is none
             std::time_t Timestamp;
 
         public:
@@ -318,6 +322,14 @@ protected:
 public:
     virtual ~CgiEnv();
 
+public:
+    /// For the session-less resources: the server, the client and the
+    /// language, which is the requested one if valid, otherwise the lang
+    /// cookie or else the browser's. Neither query parameters nor the
+    /// geolocation are looked into.
+    static void FromRequest(const Wt::Http::Request &request, const std::string &language,
+                            InformationRecord &out_info);
+
 public:
     const InformationRecord &GetInformation() const;
 
@@ -131,8 +131,9 @@ CgiRoot::CgiRoot(const WEnvironment &env)
             }
         }
 
+        /// Messages resolve through the bundles shared by all sessions, see
+        /// SharedLocalizedStrings
         setLocale(cgiEnv->GetInformation().Client.Language.CodeAsString);
-        messageResourceBundle().use(appRoot() + "../i18n/localization");
 
         if (cgiEnv->GetInformation().Client.Language.PageDirection
                 == CgiEnv::InformationRecord::ClientRecord::PageDirection::RightToLeft) {
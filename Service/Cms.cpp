@@ -64,6 +64,7 @@
 #include "CmsSubscribers.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "SessionCache.hpp"
 #include "SysMon.hpp"
 
 using namespace std;
@@ -293,27 +294,12 @@ void Cms::Impl::ValidateSession()
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        string query((boost::format("SELECT EXTRACT ( EPOCH FROM expiry::TIMESTAMPTZ ) as expiry FROM \"%1%\""
-                                    " WHERE token = %2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("ROOT_SESSIONS"))
-                      % txn.quote(cgiEnv->GetInformation().Client.Session.Token)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-        result r = txn.exec(query);
-
-        string expiry("0");
-        if (!r.empty()) {
-            const pqxx::row row(r[0]);
-            expiry = row["expiry"].c_str();
+        /// A memory lookup, unless this process has never seen the token
+        time_t rawTime;
+        if (!Pool::Sessions().Lookup(cgiEnv->GetInformation().Client.Session.Token, rawTime)) {
+            return;
         }
 
-        time_t rawTime = lexical_cast<time_t>(expiry);
-        CDate::Now n(CDate::Timezone::UTC);
-
         /// 0 means force exit the current session
         /// if you don't know why,
         /// see Service::RootLogin::PreserveSessionData method
@@ -322,10 +308,6 @@ void Cms::Impl::ValidateSession()
         }
     }
 
-    catch (const pqxx::sql_error &ex) {
-        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
-    }
-
     catch (const boost::exception &ex) {
         LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
     }
@@ -346,6 +328,9 @@ void Cms::Impl::ForceExit()
 
     srand(static_cast<unsigned int>(System::RandSeed()));
     try {
+        /// Make sure the token is of no use anymore, in any process
+        Pool::Sessions().Terminate(cgiEnv->GetInformation().Client.Session.Token);
+
         cgiRoot->removeCookie("cms-session-token");
         LOG_INFO("Root logout succeed!", cgiEnv->GetInformation().ToJson());
     } catch(...) {
@@ -51,6 +51,7 @@
 #include <CoreLib/FileSystem.hpp>
 #include <CoreLib/Log.hpp>
 #include <CoreLib/make_unique.hpp>
+#include "Argon2Executor.hpp"
 #include "CgiEnv.hpp"
 #include "CgiRoot.hpp"
 #include "CmsChangeEmail.hpp"
@@ -75,12 +76,16 @@ public:
 private:
     CmsChangeEmail *m_parent;
 
+    /// Lets the hashing callbacks know whether we are still around
+    std::shared_ptr<bool> LifeToken;
+
 public:
     explicit Impl(CmsChangeEmail *parent);
     ~Impl();
 
 public:
     void OnEmailChangeFormSubmitted();
+    void OnPasswordVerified(const bool verified, const std::string &email);
 };
 
 CmsChangeEmail::CmsChangeEmail()
@@ -174,7 +179,8 @@ WWidget *CmsChangeEmail::Layout()
 }
 
 CmsChangeEmail::Impl::Impl(CmsChangeEmail *parent)
-    : m_parent(parent)
+    : m_parent(parent),
+      LifeToken(std::make_shared<bool>(true))
 {
 
 }
@@ -192,32 +198,75 @@ void CmsChangeEmail::Impl::OnEmailChangeFormSubmitted()
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
+        string hashedPwd;
 
-        bool success = false;
+        {
+            auto conn = Pool::Database().Connection();
+            conn->activate();
+            pqxx::work txn(*conn.get());
 
-        string query((format("SELECT pwd FROM \"%1%\""
-                             " WHERE user_id = %2%;")
-                      % Pool::Database().GetTableName("ROOT_CREDENTIALS")
-                      % txn.quote(cgiEnv->GetInformation().Client.Session.UserId)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+            string query((format("SELECT pwd FROM \"%1%\""
+                                 " WHERE user_id = %2%;")
+                          % Pool::Database().GetTableName("ROOT_CREDENTIALS")
+                          % txn.quote(cgiEnv->GetInformation().Client.Session.UserId)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        result r = txn.exec(query);
+            result r = txn.exec(query);
 
-        if (!r.empty()) {
-            const pqxx::row row(r[0]);
+            if (!r.empty()) {
+                const pqxx::row row(r[0]);
 
-            string hashedPwd(row["pwd"].c_str());
-            Pool::Crypto().Decrypt(hashedPwd, hashedPwd);
-
-            if (Pool::Crypto().Argon2iVerify(PasswordLineEdit->text().toUTF8(), hashedPwd)) {
-                success = true;
+                hashedPwd.assign(row["pwd"].c_str());
+                Pool::Crypto().Decrypt(hashedPwd, hashedPwd);
             }
         }
 
-        if (!success) {
+        if (hashedPwd.empty()) {
+            OnPasswordVerified(false, "");
+            return;
+        }
+
+        const std::weak_ptr<bool> lifeToken(LifeToken);
+        CmsChangeEmail::Impl *self = this;
+        const string email(EmailLineEdit->text().toUTF8());
+
+        if (Pool::Argon2().Verify(PasswordLineEdit->text().toUTF8(), hashedPwd,
+                                  [=](const bool verified) {
+                                      if (!lifeToken.expired())
+                                          self->OnPasswordVerified(verified, email);
+                                  })) {
+            return;
+        }
+
+        LOG_ERROR("Password hashing is too busy!", cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("password-hashing-busy-error"), ChangeEmailMessageArea);
+        return;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
+    }
+}
+
+void CmsChangeEmail::Impl::OnPasswordVerified(const bool verified, const std::string &email)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    try {
+        if (!verified) {
             LOG_ERROR("Invalid password!", cgiEnv->GetInformation().ToJson());
             m_parent->HtmlError(tr("cms-change-email-invalid-pwd-error"), ChangeEmailMessageArea);
             PasswordLineEdit->setFocus();
@@ -226,9 +275,11 @@ void CmsChangeEmail::Impl::OnEmailChangeFormSubmitted()
 
         CDate::Now n(CDate::Timezone::UTC);
 
-        string email(EmailLineEdit->text().toUTF8());
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
 
-        query.assign((boost::format("UPDATE ONLY \"%1%\""
+        string query((boost::format("UPDATE ONLY \"%1%\""
                                     " SET email = %2%, modification_time = TO_TIMESTAMP(%3%)::TIMESTAMPTZ"
                                     " WHERE user_id = %4%;")
                       % txn.esc(Service::Pool::Database().GetTableName("ROOT"))
@@ -237,7 +288,7 @@ void CmsChangeEmail::Impl::OnEmailChangeFormSubmitted()
                       % txn.quote(cgiEnv->GetInformation().Client.Session.UserId)).str());
         LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        r = txn.exec(query);
+        txn.exec(query);
 
         txn.commit();
 
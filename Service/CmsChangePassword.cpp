@@ -50,6 +50,7 @@
 #include <CoreLib/FileSystem.hpp>
 #include <CoreLib/Log.hpp>
 #include <CoreLib/make_unique.hpp>
+#include "Argon2Executor.hpp"
 #include "CgiEnv.hpp"
 #include "CgiRoot.hpp"
 #include "CmsChangePassword.hpp"
@@ -75,12 +76,17 @@ public:
 private:
     CmsChangePassword *m_parent;
 
+    /// Lets the hashing callbacks know whether we are still around
+    std::shared_ptr<bool> LifeToken;
+
 public:
     explicit Impl(CmsChangePassword *parent);
     ~Impl();
 
 public:
     void OnPasswordChangeFormSubmitted();
+    void OnCurrentPasswordVerified(const bool verified, const std::string &newPwd);
+    void OnNewPasswordHashed(const bool succeeded, const std::string &hashedPwd);
 };
 
 CmsChangePassword::CmsChangePassword()
@@ -186,7 +192,8 @@ WWidget *CmsChangePassword::Layout()
 }
 
 CmsChangePassword::Impl::Impl(CmsChangePassword *parent)
-    : m_parent(parent)
+    : m_parent(parent),
+      LifeToken(std::make_shared<bool>(true))
 {
 
 }
@@ -205,61 +212,132 @@ void CmsChangePassword::Impl::OnPasswordChangeFormSubmitted()
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
+        /// Cheap checks go first, so we won't burn an Argon2 run for nothing
+        if (NewPasswordLineEdit->text() == CurrentPasswordLineEdit->text()) {
+            LOG_ERROR("Password must be different from the current password!", cgiEnv->GetInformation().ToJson());
+            m_parent->HtmlError(tr("cms-change-password-same-pwd-error"), ChangePasswordMessageArea);
+            NewPasswordLineEdit->setFocus();
+            return;
+        }
 
-        bool success = false;
+        if (NewPasswordLineEdit->text() != ConfirmPasswordLineEdit->text()) {
+            LOG_ERROR("Password mismatch!", cgiEnv->GetInformation().ToJson());
+            m_parent->HtmlError(tr("cms-change-password-confirm-pwd-error"), ChangePasswordMessageArea);
+            ConfirmPasswordLineEdit->setFocus();
+            return;
+        }
 
-        string query((format("SELECT pwd FROM \"%1%\""
-                             " WHERE user_id = %2%;")
-                      % Pool::Database().GetTableName("ROOT_CREDENTIALS")
-                      % txn.quote(cgiEnv->GetInformation().Client.Session.UserId)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+        string hashedPwd;
+
+        {
+            auto conn = Pool::Database().Connection();
+            conn->activate();
+            pqxx::work txn(*conn.get());
 
-        result r = txn.exec(query);
+            string query((format("SELECT pwd FROM \"%1%\""
+                                 " WHERE user_id = %2%;")
+                          % Pool::Database().GetTableName("ROOT_CREDENTIALS")
+                          % txn.quote(cgiEnv->GetInformation().Client.Session.UserId)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        if (!r.empty()) {
-            const pqxx::row row(r[0]);
+            result r = txn.exec(query);
 
-            string hashedPwd(row["pwd"].c_str());
-            Pool::Crypto().Decrypt(hashedPwd, hashedPwd);
+            if (!r.empty()) {
+                const pqxx::row row(r[0]);
 
-            if (Pool::Crypto().Argon2iVerify(CurrentPasswordLineEdit->text().toUTF8(), hashedPwd)) {
-                success = true;
+                hashedPwd.assign(row["pwd"].c_str());
+                Pool::Crypto().Decrypt(hashedPwd, hashedPwd);
             }
         }
 
-        if (!success) {
-            LOG_ERROR("Invalid password!", cgiEnv->GetInformation().ToJson());
-            m_parent->HtmlError(tr("cms-change-password-invalid-pwd-error"), ChangePasswordMessageArea);
-            CurrentPasswordLineEdit->setFocus();
+        if (hashedPwd.empty()) {
+            OnCurrentPasswordVerified(false, "");
             return;
         }
 
-        if (NewPasswordLineEdit->text() == CurrentPasswordLineEdit->text()) {
-            LOG_ERROR("Password must be different from the current password!", cgiEnv->GetInformation().ToJson());
-            m_parent->HtmlError(tr("cms-change-password-same-pwd-error"), ChangePasswordMessageArea);
-            NewPasswordLineEdit->setFocus();
+        const std::weak_ptr<bool> lifeToken(LifeToken);
+        CmsChangePassword::Impl *self = this;
+        const string newPwd(NewPasswordLineEdit->text().toUTF8());
+
+        if (Pool::Argon2().Verify(CurrentPasswordLineEdit->text().toUTF8(), hashedPwd,
+                                  [=](const bool verified) {
+                                      if (!lifeToken.expired())
+                                          self->OnCurrentPasswordVerified(verified, newPwd);
+                                  })) {
             return;
         }
 
-        if (NewPasswordLineEdit->text() != ConfirmPasswordLineEdit->text()) {
-            LOG_ERROR("Password mismatch!", cgiEnv->GetInformation().ToJson());
-            m_parent->HtmlError(tr("cms-change-password-confirm-pwd-error"), ChangePasswordMessageArea);
-            ConfirmPasswordLineEdit->setFocus();
+        LOG_ERROR("Password hashing is too busy!", cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("password-hashing-busy-error"), ChangePasswordMessageArea);
+        return;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
+    }
+}
+
+void CmsChangePassword::Impl::OnCurrentPasswordVerified(const bool verified, const std::string &newPwd)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    if (!verified) {
+        LOG_ERROR("Invalid password!", cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("cms-change-password-invalid-pwd-error"), ChangePasswordMessageArea);
+        CurrentPasswordLineEdit->setFocus();
+        return;
+    }
+
+    const std::weak_ptr<bool> lifeToken(LifeToken);
+    CmsChangePassword::Impl *self = this;
+
+    if (!Pool::Argon2().Hash(newPwd,
+                             CoreLib::Crypto::Argon2iOpsLimit::Sensitive,
+                             CoreLib::Crypto::Argon2iMemLimit::Sensitive,
+                             [=](const bool succeeded, const std::string &hashedPwd) {
+                                 if (!lifeToken.expired())
+                                     self->OnNewPasswordHashed(succeeded, hashedPwd);
+                             })) {
+        LOG_ERROR("Password hashing is too busy!", cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("password-hashing-busy-error"), ChangePasswordMessageArea);
+    }
+}
+
+void CmsChangePassword::Impl::OnNewPasswordHashed(const bool succeeded, const std::string &hashedPwd)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    try {
+        if (!succeeded) {
+            LOG_ERROR("Password hashing failed!", cgiEnv->GetInformation().ToJson());
+            m_parent->HtmlError(tr("internal-server-error"), ChangePasswordMessageArea);
             return;
         }
 
         string encryptedPwd;
-        Pool::Crypto().Argon2i(NewPasswordLineEdit->text().toUTF8(), encryptedPwd,
-                                CoreLib::Crypto::Argon2iOpsLimit::Sensitive,
-                                CoreLib::Crypto::Argon2iMemLimit::Sensitive);
-        Pool::Crypto().Encrypt(encryptedPwd, encryptedPwd);
+        Pool::Crypto().Encrypt(hashedPwd, encryptedPwd);
 
         CDate::Now n(CDate::Timezone::UTC);
 
-        query.assign((boost::format("UPDATE ONLY \"%1%\""
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        string query((boost::format("UPDATE ONLY \"%1%\""
                                     " SET pwd = %2%, modification_time = TO_TIMESTAMP(%3%)::TIMESTAMPTZ"
                                     " WHERE user_id = %4%;")
                       % txn.esc(Service::Pool::Database().GetTableName("ROOT_CREDENTIALS"))
@@ -268,7 +346,7 @@ void CmsChangePassword::Impl::OnPasswordChangeFormSubmitted()
                       % txn.quote(cgiEnv->GetInformation().Client.Session.UserId)).str());
         LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        r = txn.exec(query);
+        txn.exec(query);
 
         txn.commit();
 
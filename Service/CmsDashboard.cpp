@@ -53,6 +53,7 @@
 #include "CmsDashboard.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "SessionCache.hpp"
 
 using namespace std;
 using namespace boost;
@@ -231,6 +232,9 @@ void CmsDashboard::Impl::OnForceTerminateAllSessionsDialogClosed(Wt::StandardBut
 
             txn.exec(query);
 
+            /// Every process drops its cached sessions on commit
+            Pool::Sessions().Invalidate(txn);
+
             txn.commit();
 
             ForceTerminateAllSessionsMessageBox.reset();
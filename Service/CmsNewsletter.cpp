@@ -51,6 +51,7 @@
 #include <Wt/WText>
 #include <Wt/WTextEdit>
 #include <Wt/WWidget>
+#include <CoreLib/CDate.hpp>
 #include <CoreLib/Crypto.hpp>
 #include <CoreLib/Database.hpp>
 #include <CoreLib/FileSystem.hpp>
@@ -62,6 +63,8 @@
 #include "CmsNewsletter.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "SettingsCache.hpp"
+#include "SubscriptionLink.hpp"
 
 using namespace std;
 using namespace boost;
@@ -336,38 +339,24 @@ void CmsNewsletter::Impl::OnSendConfirmDialogClosed(Wt::StandardButton button)
 
                 replace_all(htmlData, "${newsletter}", bodyHtmlText);
 
-                string homePageFields;
+                SettingsCache::SnapshotPtr settings(Pool::Settings().Get());
+
+                string homePageUrl;
+                string homePageTitle;
                 if (recipients == tr("cms-newsletter-all-recipients")) {
-                    homePageFields = "homepage_url_en, homepage_title_en";
+                    homePageUrl.assign(settings->HomePageUrlEn);
+                    homePageTitle.assign(settings->HomePageTitleEn);
                 } else if (recipients == tr("cms-newsletter-english-recipients")) {
-                    homePageFields = "homepage_url_en, homepage_title_en";
+                    homePageUrl.assign(settings->HomePageUrlEn);
+                    homePageTitle.assign(settings->HomePageTitleEn);
                 } else if (recipients == tr("cms-newsletter-farsi-recipients")) {
-                    homePageFields = "homepage_url_fa, homepage_title_fa";
+                    homePageUrl.assign(settings->HomePageUrlFa);
+                    homePageTitle.assign(settings->HomePageTitleFa);
                 } else {
                     LOG_DEBUG("Ops");
                     return;
                 }
 
-                auto conn = Pool::Database().Connection();
-                conn->activate();
-                pqxx::work txn(*conn.get());
-
-                string query((format("SELECT %1% FROM \"%2%\""
-                                     " WHERE pseudo_id = '0';")
-                              % homePageFields
-                              % Pool::Database().GetTableName("SETTINGS")).str());
-                LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-                result r = txn.exec(query);
-
-                string homePageUrl;
-                string homePageTitle;
-                if (!r.empty()) {
-                    const pqxx::row row(r[0]);
-                    homePageUrl.assign(row[0].c_str());
-                    homePageTitle.assign(row[1].c_str());
-                }
-
                 replace_all(htmlData, "${home-page-url}", homePageUrl);
                 replace_all(htmlData, "${home-page-title}", homePageTitle);
 
@@ -375,20 +364,25 @@ void CmsNewsletter::Impl::OnSendConfirmDialogClosed(Wt::StandardButton button)
                 if (!ends_with(unsubscribeLink, "/"))
                     unsubscribeLink += "/";
 
+                string query;
+                string languages;
                 if (recipients == tr("cms-newsletter-all-recipients")) {
-                    unsubscribeLink += "?subscribe=-1&recipient=${uuid}&subscription=en,fa";
+                    unsubscribeLink += "?";
+                    languages.assign("en,fa");
 
                     query.assign((format("SELECT inbox, uuid FROM \"%1%\""
                                          " WHERE subscription <> 'none';")
                                   % Pool::Database().GetTableName("SUBSCRIBERS")).str());
                 } else if (recipients == tr("cms-newsletter-english-recipients")) {
-                    unsubscribeLink += "?lang=${lang}&subscribe=-1&recipient=${uuid}&subscription=en";
+                    unsubscribeLink += "?lang=${lang}&";
+                    languages.assign("en");
 
                     query.assign((format("SELECT inbox, uuid FROM \"%1%\""
                                          " WHERE subscription = 'en_fa' OR subscription = 'en';")
                                   % Pool::Database().GetTableName("SUBSCRIBERS")).str());
                 } else if (recipients == tr("cms-newsletter-farsi-recipients")) {
-                    unsubscribeLink += "?lang=${lang}&subscribe=-1&recipient=${uuid}&subscription=fa";
+                    unsubscribeLink += "?lang=${lang}&";
+                    languages.assign("fa");
 
                     query.assign((format("SELECT inbox, uuid FROM \"%1%\""
                                          " WHERE subscription = 'en_fa' OR subscription = 'fa';")
@@ -401,21 +395,33 @@ void CmsNewsletter::Impl::OnSendConfirmDialogClosed(Wt::StandardButton button)
                 string enUnsubscribeLink(replace_all_copy(unsubscribeLink, "${lang}", "en"));
                 string faUnsubscribeLink(replace_all_copy(unsubscribeLink, "${lang}", "fa"));
 
+                CoreLib::CDate::Now n(CoreLib::CDate::Timezone::UTC);
+                const time_t expiry = n.RawTime() + Pool::Storage().UnsubscribeLinkLifespan();
+
                 string message;
                 string inbox;
                 string uuid;
+                string signedQuery;
+
+                auto conn = Pool::Database().Connection();
+                conn->activate();
+                pqxx::work txn(*conn.get());
 
                 LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-                r = txn.exec(query);
+                result r = txn.exec(query);
 
                 for (const auto & row : r) {
                     inbox.assign(row["inbox"].c_str());
                     uuid.assign(row["uuid"].c_str());
 
+                    /// Each recipient gets a link of their own, signed for them only
+                    signedQuery.clear();
+                    SubscriptionLink::Sign("-1", uuid, languages, expiry, signedQuery);
+
                     message.assign(htmlData);
-                    replace_all(message, "${unsubscribe-link-en}", replace_all_copy(enUnsubscribeLink, "${uuid}", uuid));
-                    replace_all(message, "${unsubscribe-link-fa}", replace_all_copy(faUnsubscribeLink, "${uuid}", uuid));
+                    replace_all(message, "${unsubscribe-link-en}", enUnsubscribeLink + signedQuery);
+                    replace_all(message, "${unsubscribe-link-fa}", faUnsubscribeLink + signedQuery);
 
                     CoreLib::Mail *mail = new CoreLib::Mail(
                                 cgiEnv->GetInformation().Server.NoReplyAddress, inbox,
@@ -55,6 +55,7 @@
 #include "CmsSettings.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "SettingsCache.hpp"
 
 using namespace std;
 using namespace boost;
@@ -147,29 +148,12 @@ WWidget *CmsSettings::Layout()
 
             m_pimpl->SettingsMessageArea = new WText();
 
-            auto conn = Pool::Database().Connection();
-            conn->activate();
-            pqxx::work txn(*conn.get());
+            SettingsCache::SnapshotPtr settings(Pool::Settings().Get());
 
-            string query((format("SELECT homepage_url_en, homepage_url_fa, homepage_title_en, homepage_title_fa"
-                                 " FROM \"%1%\" WHERE pseudo_id = '0';")
-                          % Pool::Database().GetTableName("SETTINGS")).str());
-            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-            result r = txn.exec(query);
-
-            if (!r.empty()) {
-                const pqxx::row row(r[0]);
-                const string homepage_url_en(row["homepage_url_en"].c_str());
-                const string homepage_url_fa(row["homepage_url_fa"].c_str());
-                const string homepage_title_en(row["homepage_title_en"].c_str());
-                const string homepage_title_fa(row["homepage_title_fa"].c_str());
-
-                m_pimpl->EnHomePageUrlLineEdit->setText(WString::fromUTF8(homepage_url_en));
-                m_pimpl->FaHomePageUrlLineEdit->setText(WString::fromUTF8(homepage_url_fa));
-                m_pimpl->EnHomePageTitleLineEdit->setText(WString::fromUTF8(homepage_title_en));
-                m_pimpl->FaHomePageTitleLineEdit->setText(WString::fromUTF8(homepage_title_fa));
-            }
+            m_pimpl->EnHomePageUrlLineEdit->setText(WString::fromUTF8(settings->HomePageUrlEn));
+            m_pimpl->FaHomePageUrlLineEdit->setText(WString::fromUTF8(settings->HomePageUrlFa));
+            m_pimpl->EnHomePageTitleLineEdit->setText(WString::fromUTF8(settings->HomePageTitleEn));
+            m_pimpl->FaHomePageTitleLineEdit->setText(WString::fromUTF8(settings->HomePageTitleFa));
 
             tmpl->bindString("home-page-url-en-input-id", m_pimpl->EnHomePageUrlLineEdit->id());
             tmpl->bindString("home-page-url-fa-input-id", m_pimpl->FaHomePageUrlLineEdit->id());
@@ -245,15 +229,33 @@ void CmsSettings::Impl::OnSaveSettingsFormSubmitted()
         string homepage_title_en(EnHomePageTitleLineEdit->text().toUTF8());
         string homepage_title_fa(FaHomePageTitleLineEdit->text().toUTF8());
 
-        Pool::Database().Update("SETTINGS",
-                                 "pseudo_id", "0",
-                                 "homepage_url_en=?, homepage_url_fa=?, homepage_title_en=?, homepage_title_fa=?",
-                                 {
-                                     homepage_url_en,
-                                     homepage_url_fa,
-                                     homepage_title_en,
-                                     homepage_title_fa
-                                 });
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        /// Upsert the row and wake up every other service process' settings
+        /// cache; NOTIFY is only delivered once the transaction commits.
+        string query((format("INSERT INTO \"%1%\""
+                             " ( pseudo_id, homepage_url_en, homepage_url_fa, homepage_title_en, homepage_title_fa )"
+                             " VALUES ( '0', %2%, %3%, %4%, %5% )"
+                             " ON CONFLICT ( pseudo_id ) DO UPDATE"
+                             " SET homepage_url_en = EXCLUDED.homepage_url_en,"
+                             " homepage_url_fa = EXCLUDED.homepage_url_fa,"
+                             " homepage_title_en = EXCLUDED.homepage_title_en,"
+                             " homepage_title_fa = EXCLUDED.homepage_title_fa;")
+                      % txn.esc(Pool::Database().GetTableName("SETTINGS"))
+                      % txn.quote(homepage_url_en)
+                      % txn.quote(homepage_url_fa)
+                      % txn.quote(homepage_title_en)
+                      % txn.quote(homepage_title_fa)).str());
+        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+
+        txn.exec(query);
+        Pool::Database().Notify(txn, SettingsCache::Channel());
+        txn.commit();
+
+        /// Do not wait for our own listener to catch up
+        Pool::Settings().Refresh();
 
         EnHomePageUrlLineEdit->setFocus();
 
@@ -33,21 +33,32 @@
  */
 
 
+#include <algorithm>
+#include <memory>
+#include <tuple>
 #include <vector>
-#include <cmath>
-#include <ctime>
+#include <boost/algorithm/string.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 #include <pqxx/pqxx>
+#include <Wt/WAnchor>
 #include <Wt/WApplication>
 #include <Wt/WComboBox>
+#include <Wt/WDate>
+#include <Wt/WDateEdit>
+#include <Wt/WFileUpload>
+#include <Wt/WLineEdit>
+#include <Wt/WLink>
+#include <Wt/WProgressBar>
 #include <Wt/WPushButton>
+#include <Wt/WServer>
 #include <Wt/WSignalMapper>
 #include <Wt/WString>
-#include <Wt/WTable>
+#include <Wt/WTableView>
 #include <Wt/WTemplate>
 #include <Wt/WText>
+#include <Wt/WTimer>
 #include <Wt/WWidget>
 #include <CoreLib/CDate.hpp>
 #include <CoreLib/Crypto.hpp>
@@ -60,6 +71,15 @@
 #include "CmsSubscribers.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "SubscribersExport.hpp"
+#include "SubscribersImport.hpp"
+#include "SubscribersModel.hpp"
+#include "WorkerPool.hpp"
+
+#define     PAGINATION_LETTERS      "abcdefghijklmnopqrstuvwxyz"
+#define     SEARCH_DEBOUNCE_MSEC    400
+#define     UNIX_EPOCH_JULIAN_DAY   2440588
+#define     SECONDS_PER_DAY         86400
 
 using namespace std;
 using namespace boost;
@@ -79,8 +99,18 @@ public:
         Inactive
     };
 
+    enum class Seek : unsigned char {
+        First,
+        Previous,
+        Next,
+        Last,
+        Letter,
+        Current
+    };
+
 public:
-    WContainerWidget *SubscribersTableContainer;
+    Wt::WTableView *SubscribersTableView;
+    SubscribersModel *SubscribersTableModel;
 
     std::vector<std::pair<Wt::WString, int>> PaginationOptions;
     int PaginationOptionsDefaultIndex;
@@ -88,8 +118,46 @@ public:
     int PaginationItemsPerPageLimit;
     uint_fast64_t PaginationTotalItems;
     uint_fast64_t PaginationItemOffset;
-    uint_fast64_t PaginationPageOffset;
+    uint_fast64_t PaginationPageItems;
+    /// A jump to a letter lands at an offset nobody has counted
+    bool PaginationItemOffsetKnown;
+
+    /// Keyset (seek) pagination boundaries of the current page
+    std::string PaginationFirstInbox;
+    std::string PaginationLastInbox;
+    bool PaginationHasPrevious;
+    bool PaginationHasNext;
+
     Div *PaginationButtonsContainer;
+    Wt::WPushButton *PaginationFirstButton;
+    Wt::WPushButton *PaginationPreviousButton;
+    Wt::WPushButton *PaginationNextButton;
+    Wt::WPushButton *PaginationLastButton;
+    Wt::WText *PaginationRangeText;
+
+    /// Search and filters; the filtered total gets counted off the UI thread
+    /// while the rows themselves get fetched page by page, or block by block
+    Wt::WLineEdit *SearchLineEdit;
+    Wt::WComboBox *SearchStateComboBox;
+    Wt::WComboBox *SearchDateFieldComboBox;
+    Wt::WDateEdit *SearchDateFromEdit;
+    Wt::WDateEdit *SearchDateToEdit;
+    Wt::WTimer *SearchTimer;
+    std::string SearchFilter;
+    uint_fast64_t SearchTotalItems;
+    uint_fast64_t SearchGeneration;
+
+    /// Export whatever the admin is currently looking at
+    std::vector<SubscribersExport *> Exports;
+    Div *ExportLinksContainer;
+
+    /// Bulk import; the heavy lifting happens off the UI thread
+    Wt::WFileUpload *ImportFileUpload;
+    Wt::WPushButton *ImportPushButton;
+    Wt::WText *ImportStatusText;
+
+    /// Lets background work find out whether we are still around
+    std::shared_ptr<bool> LifeToken;
 
 public:
     Impl();
@@ -103,13 +171,43 @@ public:
     void OnInactiveButtonPressed();
 
     void OnItemsPerPageComboBoxChanged(Wt::WComboBox *comboBox);
-    void OnPaginiationButtonPressed(Wt::WPushButton *button);
+    void OnFirstPageButtonPressed();
+    void OnPreviousPageButtonPressed();
+    void OnNextPageButtonPressed();
+    void OnLastPageButtonPressed();
+    void OnLetterButtonPressed(Wt::WPushButton *button);
+
+    void CreatePaginationButtons();
+    void CreateSearchControls();
+    void CreateExportLinks();
+    void CreateImportControls();
+
+    void OnSearchChanged();
+    void ApplyFilters();
+    void OnSearchCounted(const uint_fast64_t generation, const std::string &filter,
+                         const uint_fast64_t total, const bool succeeded);
+
+    void OnImportButtonPressed();
+    void OnImportUploaded();
+    void OnImportFileTooLarge();
+    void OnImportProgress(const SubscribersImport::Stage &stage,
+                          const uint_fast64_t done, const uint_fast64_t total);
+    void OnImportFinished(const bool succeeded, const SubscribersImport::Result &result);
 
 private:
-    void GetDate(const std::string &timeSinceEpoch, Wt::WString &out_date);
-    void GetSubscriptionTypeName(const std::string &type, Wt::WString &out_name);
+    static bool CountRows(const std::string &where, uint_fast64_t &out_count);
+
+    std::string GetSearchFilter();
+    std::string GetSegmentFilter(const CmsSubscribers::Impl::Table &table);
+
+    void GetNumber(const uint_fast64_t number, Wt::WString &out_number);
+
+    std::string GetTableFilter(const CmsSubscribers::Impl::Table &table);
+    std::string GetCounterFilter(const CmsSubscribers::Impl::Table &table);
 
-    void FillDataTable(const CmsSubscribers::Impl::Table &table);
+    void FillDataTable(const CmsSubscribers::Impl::Table &table,
+                       const CmsSubscribers::Impl::Seek &seek = Seek::First,
+                       const std::string &key = "");
 
     void ReEvaluatePaginationButtons();
 };
@@ -192,12 +290,32 @@ WWidget *CmsSubscribers::Layout()
             itemsPerPageSignalMapper->mapConnect(itemsPerPageComboBox->changed(), itemsPerPageComboBox);
 
             m_pimpl->PaginationButtonsContainer = new Div("PaginationButtonsContainer", "pagination-buttons-container");
-
-            m_pimpl->SubscribersTableContainer = new Div("SubscribersTableContainer", "subscribers-table-container");
+            m_pimpl->CreatePaginationButtons();
+            m_pimpl->CreateSearchControls();
+            m_pimpl->CreateExportLinks();
+            m_pimpl->CreateImportControls();
+
+            /// Search results get pushed into the page once they are counted
+            cgiRoot->enableUpdates(true);
+
+            /// Only the rows inside the viewport get fetched and rendered
+            m_pimpl->SubscribersTableView = new WTableView();
+            m_pimpl->SubscribersTableModel = new SubscribersModel(m_pimpl->SubscribersTableView);
+            m_pimpl->SubscribersTableView->setStyleClass("subscribers-table-view");
+            m_pimpl->SubscribersTableView->setAlternatingRowColors(true);
+            m_pimpl->SubscribersTableView->setSortingEnabled(false);
+            m_pimpl->SubscribersTableView->setColumnResizeEnabled(true);
+            m_pimpl->SubscribersTableView->setSelectionMode(NoSelection);
+            m_pimpl->SubscribersTableView->setRowHeight(WLength(32.0, WLength::Pixel));
+            m_pimpl->SubscribersTableView->setHeight(WLength(600.0, WLength::Pixel));
+            m_pimpl->SubscribersTableView->setModel(m_pimpl->SubscribersTableModel);
+            m_pimpl->SubscribersTableView->setColumnWidth(static_cast<int>(SubscribersModel::Column::No), WLength(64.0, WLength::Pixel));
+            m_pimpl->SubscribersTableView->setColumnWidth(static_cast<int>(SubscribersModel::Column::Inbox), WLength(256.0, WLength::Pixel));
+            m_pimpl->SubscribersTableView->setColumnWidth(static_cast<int>(SubscribersModel::Column::Uuid), WLength(300.0, WLength::Pixel));
 
             tmpl->bindWidget("subscribers-title", new WText(tr("cms-subscribers-page-title")));
 
-            tmpl->bindWidget("subscribers-table", m_pimpl->SubscribersTableContainer);
+            tmpl->bindWidget("subscribers-table", m_pimpl->SubscribersTableView);
 
             tmpl->bindWidget("all-subscribers-button", allSubscribersPushButton);
             tmpl->bindWidget("english-farsi-subscribers-button", englishFarsiSubscribersPushButton);
@@ -210,6 +328,19 @@ WWidget *CmsSubscribers::Layout()
             tmpl->bindString("items-per-page-select-id", itemsPerPageComboBox->id());
             tmpl->bindWidget("pagination-buttons", m_pimpl->PaginationButtonsContainer);
 
+            tmpl->bindWidget("export-links", m_pimpl->ExportLinksContainer);
+
+            tmpl->bindWidget("import-file", m_pimpl->ImportFileUpload);
+            tmpl->bindWidget("import-button", m_pimpl->ImportPushButton);
+            tmpl->bindWidget("import-hint", new WText(tr("cms-subscribers-import-hint")));
+            tmpl->bindWidget("import-status", m_pimpl->ImportStatusText);
+
+            tmpl->bindWidget("search-input", m_pimpl->SearchLineEdit);
+            tmpl->bindWidget("search-state-select", m_pimpl->SearchStateComboBox);
+            tmpl->bindWidget("search-date-field-select", m_pimpl->SearchDateFieldComboBox);
+            tmpl->bindWidget("search-date-from", m_pimpl->SearchDateFromEdit);
+            tmpl->bindWidget("search-date-to", m_pimpl->SearchDateToEdit);
+
             allSubscribersPushButton->clicked().connect(m_pimpl.get(), &CmsSubscribers::Impl::OnAllButtonPressed);
             englishFarsiSubscribersPushButton->clicked().connect(m_pimpl.get(), &CmsSubscribers::Impl::OnEnFaButtonPressed);
             englishSubscribersPushButton->clicked().connect(m_pimpl.get(), &CmsSubscribers::Impl::OnEnButtonPressed);
@@ -250,7 +381,13 @@ CmsSubscribers::Impl::Impl()
       PaginationItemsPerPageLimit(-1),
       PaginationTotalItems(0),
       PaginationItemOffset(0),
-      PaginationPageOffset(0)
+      PaginationPageItems(0),
+      PaginationItemOffsetKnown(true),
+      PaginationHasPrevious(false),
+      PaginationHasNext(false),
+      SearchTotalItems(0),
+      SearchGeneration(0),
+      LifeToken(std::make_shared<bool>(true))
 {
 
 }
@@ -259,47 +396,32 @@ CmsSubscribers::Impl::~Impl() = default;
 
 void CmsSubscribers::Impl::OnAllButtonPressed()
 {
-    this->PaginationTotalItems = 0;
-    this->PaginationItemOffset = 0;
-    this->PaginationPageOffset = 0;
-
-    FillDataTable(Table::All);
+    this->PaginationTableType = Table::All;
+    this->ApplyFilters();
 }
 
 void CmsSubscribers::Impl::OnEnFaButtonPressed()
 {
-    this->PaginationTotalItems = 0;
-    this->PaginationItemOffset = 0;
-    this->PaginationPageOffset = 0;
-
-    FillDataTable(Table::EnFa);
+    this->PaginationTableType = Table::EnFa;
+    this->ApplyFilters();
 }
 
 void CmsSubscribers::Impl::OnEnButtonPressed()
 {
-    this->PaginationTotalItems = 0;
-    this->PaginationItemOffset = 0;
-    this->PaginationPageOffset = 0;
-
-    FillDataTable(Table::En);
+    this->PaginationTableType = Table::En;
+    this->ApplyFilters();
 }
 
 void CmsSubscribers::Impl::OnFaButtonPressed()
 {
-    this->PaginationTotalItems = 0;
-    this->PaginationItemOffset = 0;
-    this->PaginationPageOffset = 0;
-
-    FillDataTable(Table::Fa);
+    this->PaginationTableType = Table::Fa;
+    this->ApplyFilters();
 }
 
 void CmsSubscribers::Impl::OnInactiveButtonPressed()
 {
-    this->PaginationTotalItems = 0;
-    this->PaginationItemOffset = 0;
-    this->PaginationPageOffset = 0;
-
-    FillDataTable(Table::Inactive);
+    this->PaginationTableType = Table::Inactive;
+    this->ApplyFilters();
 }
 
 void CmsSubscribers::Impl::OnItemsPerPageComboBoxChanged(Wt::WComboBox *comboBox)
@@ -322,23 +444,225 @@ void CmsSubscribers::Impl::OnItemsPerPageComboBoxChanged(Wt::WComboBox *comboBox
             return;
         }
 
-        if (this->PaginationItemsPerPageLimit < 0) {
-            this->PaginationTotalItems = 0;
-            this->PaginationPageOffset = 0;
-            this->PaginationItemOffset = 0;
-
+        if (this->PaginationItemsPerPageLimit < 0
+                || this->PaginationFirstInbox.empty()) {
             this->FillDataTable(this->PaginationTableType);
+            return;
+        }
+
+        /// Stay where we are, only the page size changes
+        this->FillDataTable(this->PaginationTableType, Seek::Current, this->PaginationFirstInbox);
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
+    }
+}
+
+void CmsSubscribers::Impl::OnFirstPageButtonPressed()
+{
+    this->FillDataTable(this->PaginationTableType, Seek::First);
+}
+
+void CmsSubscribers::Impl::OnPreviousPageButtonPressed()
+{
+    this->FillDataTable(this->PaginationTableType, Seek::Previous, this->PaginationFirstInbox);
+}
+
+void CmsSubscribers::Impl::OnNextPageButtonPressed()
+{
+    this->FillDataTable(this->PaginationTableType, Seek::Next, this->PaginationLastInbox);
+}
+
+void CmsSubscribers::Impl::OnLastPageButtonPressed()
+{
+    this->FillDataTable(this->PaginationTableType, Seek::Last);
+}
+
+void CmsSubscribers::Impl::OnLetterButtonPressed(Wt::WPushButton *button)
+{
+    this->FillDataTable(this->PaginationTableType, Seek::Letter,
+                        button->attributeValue("seek-key").toUTF8());
+}
+
+void CmsSubscribers::Impl::CreatePaginationButtons()
+{
+    /// A fixed set of navigation buttons, no matter how many pages there are
+    PaginationFirstButton = new WPushButton(tr("cms-subscribers-pagination-first"), PaginationButtonsContainer);
+    PaginationFirstButton->setStyleClass("btn btn-default");
+
+    PaginationPreviousButton = new WPushButton(tr("cms-subscribers-pagination-previous"), PaginationButtonsContainer);
+    PaginationPreviousButton->setStyleClass("btn btn-default");
+
+    PaginationRangeText = new WText(PaginationButtonsContainer);
+
+    PaginationNextButton = new WPushButton(tr("cms-subscribers-pagination-next"), PaginationButtonsContainer);
+    PaginationNextButton->setStyleClass("btn btn-default");
+
+    PaginationLastButton = new WPushButton(tr("cms-subscribers-pagination-last"), PaginationButtonsContainer);
+    PaginationLastButton->setStyleClass("btn btn-default");
+
+    PaginationFirstButton->clicked().connect(this, &CmsSubscribers::Impl::OnFirstPageButtonPressed);
+    PaginationPreviousButton->clicked().connect(this, &CmsSubscribers::Impl::OnPreviousPageButtonPressed);
+    PaginationNextButton->clicked().connect(this, &CmsSubscribers::Impl::OnNextPageButtonPressed);
+    PaginationLastButton->clicked().connect(this, &CmsSubscribers::Impl::OnLastPageButtonPressed);
+
+    Div *lettersContainer = new Div(PaginationButtonsContainer, "PaginationLettersContainer", "pagination-letters-container");
 
+    WSignalMapper<WPushButton *> *letterSignalMapper = new WSignalMapper<WPushButton *>(this);
+    letterSignalMapper->mapped().connect(this, &CmsSubscribers::Impl::OnLetterButtonPressed);
+
+    for (const char *letter = PAGINATION_LETTERS; *letter != '\0'; ++letter) {
+        const string key(1, *letter);
+
+        WPushButton *button = new WPushButton(WString::fromUTF8(boost::algorithm::to_upper_copy(key)), lettersContainer);
+        button->setStyleClass("btn btn-default btn-xs");
+        button->setAttributeValue("seek-key", WString::fromUTF8(key));
+
+        letterSignalMapper->mapConnect(button->clicked(), button);
+    }
+
+    PaginationButtonsContainer->hide();
+}
+
+void CmsSubscribers::Impl::CreateSearchControls()
+{
+    SearchLineEdit = new WLineEdit();
+    SearchLineEdit->setPlaceholderText(tr("cms-subscribers-search-placeholder"));
+
+    SearchStateComboBox = new WComboBox();
+    SearchStateComboBox->addItem(tr("cms-subscribers-search-state-any"));
+    SearchStateComboBox->addItem(tr("cms-subscribers-search-state-pending-confirm"));
+    SearchStateComboBox->addItem(tr("cms-subscribers-search-state-pending-cancel"));
+
+    SearchDateFieldComboBox = new WComboBox();
+    SearchDateFieldComboBox->addItem(tr("cms-subscribers-search-date-join"));
+    SearchDateFieldComboBox->addItem(tr("cms-subscribers-search-date-update"));
+
+    SearchDateFromEdit = new WDateEdit();
+    SearchDateFromEdit->setPlaceholderText(tr("cms-subscribers-search-date-from"));
+
+    SearchDateToEdit = new WDateEdit();
+    SearchDateToEdit->setPlaceholderText(tr("cms-subscribers-search-date-to"));
+
+    /// Do not hit the database on every single keystroke
+    SearchTimer = new WTimer(this);
+    SearchTimer->setSingleShot(true);
+    SearchTimer->setInterval(SEARCH_DEBOUNCE_MSEC);
+    SearchTimer->timeout().connect(this, &CmsSubscribers::Impl::ApplyFilters);
+
+    SearchLineEdit->textInput().connect(this, &CmsSubscribers::Impl::OnSearchChanged);
+    SearchStateComboBox->changed().connect(this, &CmsSubscribers::Impl::OnSearchChanged);
+    SearchDateFieldComboBox->changed().connect(this, &CmsSubscribers::Impl::OnSearchChanged);
+    SearchDateFromEdit->changed().connect(this, &CmsSubscribers::Impl::OnSearchChanged);
+    SearchDateToEdit->changed().connect(this, &CmsSubscribers::Impl::OnSearchChanged);
+}
+
+void CmsSubscribers::Impl::CreateExportLinks()
+{
+    ExportLinksContainer = new Div("ExportLinksContainer", "export-links-container");
+
+    const std::vector<std::tuple<SubscribersExport::Format, bool, std::string>> exports {
+        std::make_tuple(SubscribersExport::Format::Csv, false, "cms-subscribers-export-csv"),
+        std::make_tuple(SubscribersExport::Format::Csv, true, "cms-subscribers-export-csv-gzip"),
+        std::make_tuple(SubscribersExport::Format::NdJson, false, "cms-subscribers-export-ndjson"),
+        std::make_tuple(SubscribersExport::Format::NdJson, true, "cms-subscribers-export-ndjson-gzip")
+    };
+
+    for (const auto &e : exports) {
+        SubscribersExport *resource = new SubscribersExport(std::get<0>(e), std::get<1>(e), this);
+        resource->SetFilter(GetTableFilter(PaginationTableType));
+        Exports.push_back(resource);
+
+        WAnchor *anchor = new WAnchor(WLink(resource), tr(std::get<2>(e).c_str()), ExportLinksContainer);
+        anchor->setStyleClass("btn btn-link");
+        anchor->setTarget(TargetNewWindow);
+    }
+}
+
+void CmsSubscribers::Impl::CreateImportControls()
+{
+    ImportFileUpload = new WFileUpload();
+    ImportFileUpload->setFilters(".csv,.txt,.gz");
+    ImportFileUpload->setProgressBar(new WProgressBar());
+
+    ImportPushButton = new WPushButton(tr("cms-subscribers-import-button"));
+    ImportPushButton->setStyleClass("btn btn-default");
+
+    ImportStatusText = new WText();
+
+    ImportPushButton->clicked().connect(this, &CmsSubscribers::Impl::OnImportButtonPressed);
+    ImportFileUpload->uploaded().connect(this, &CmsSubscribers::Impl::OnImportUploaded);
+    ImportFileUpload->fileTooLarge().connect(this, &CmsSubscribers::Impl::OnImportFileTooLarge);
+}
+
+void CmsSubscribers::Impl::OnImportButtonPressed()
+{
+    if (ImportFileUpload->canUpload()) {
+        ImportPushButton->setDisabled(true);
+        ImportStatusText->setText(tr("cms-subscribers-import-uploading"));
+        ImportFileUpload->upload();
+    }
+}
+
+void CmsSubscribers::Impl::OnImportUploaded()
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    try {
+        if (ImportFileUpload->empty()) {
+            ImportPushButton->setDisabled(false);
+            ImportStatusText->setText("");
             return;
         }
 
-        this->PaginationPageOffset = static_cast<uint_fast64_t>(
-                    std::floor(this->PaginationItemOffset
-                               / static_cast<double>(this->PaginationItemsPerPageLimit)));
-        this->PaginationItemOffset = this->PaginationPageOffset
-                * static_cast<uint_fast64_t>(this->PaginationItemsPerPageLimit);
+        /// From now on the file is ours to delete, not the upload widget's
+        const string filePath(ImportFileUpload->spoolFileName());
+        ImportFileUpload->stealSpooledFile();
+
+        const string sessionId(cgiRoot->sessionId());
+        const std::weak_ptr<bool> lifeToken(LifeToken);
+        CmsSubscribers::Impl *self = this;
+
+        const SubscribersImport::ProgressCallback progress =
+                [=](const SubscribersImport::Stage &stage, const uint_fast64_t done, const uint_fast64_t total) {
+            WServer::instance()->post(sessionId, [=]() {
+                if (lifeToken.expired())
+                    return;
+
+                self->OnImportProgress(stage, done, total);
+                WApplication::instance()->triggerUpdate();
+            });
+        };
+
+        const bool queued = Pool::Background().Post([=]() {
+            SubscribersImport::Result result;
+            const bool succeeded = SubscribersImport::Run(filePath, progress, result);
+
+            FileSystem::Erase(filePath, false);
 
-        this->FillDataTable(this->PaginationTableType);
+            WServer::instance()->post(sessionId, [=]() {
+                if (lifeToken.expired())
+                    return;
+
+                self->OnImportFinished(succeeded, result);
+                WApplication::instance()->triggerUpdate();
+            });
+        });
+
+        if (!queued) {
+            FileSystem::Erase(filePath, false);
+            OnImportFinished(false, SubscribersImport::Result());
+        }
     }
 
     catch (const boost::exception &ex) {
@@ -354,20 +678,116 @@ void CmsSubscribers::Impl::OnItemsPerPageComboBoxChanged(Wt::WComboBox *comboBox
     }
 }
 
-void CmsSubscribers::Impl::OnPaginiationButtonPressed(Wt::WPushButton *button)
+void CmsSubscribers::Impl::OnImportFileTooLarge()
+{
+    ImportPushButton->setDisabled(false);
+    ImportStatusText->setText(tr("cms-subscribers-import-file-too-large"));
+}
+
+void CmsSubscribers::Impl::OnImportProgress(const SubscribersImport::Stage &stage,
+                                            const uint_fast64_t done, const uint_fast64_t total)
+{
+    WString doneText;
+    WString totalText;
+    GetNumber(done, doneText);
+    GetNumber(total, totalText);
+
+    switch (stage) {
+    case SubscribersImport::Stage::Reading:
+        ImportStatusText->setText(tr("cms-subscribers-import-reading"));
+        break;
+    case SubscribersImport::Stage::Validating:
+        ImportStatusText->setText(tr("cms-subscribers-import-validating").arg(doneText).arg(totalText));
+        break;
+    case SubscribersImport::Stage::Loading:
+        ImportStatusText->setText(tr("cms-subscribers-import-loading").arg(doneText).arg(totalText));
+        break;
+    case SubscribersImport::Stage::Merging:
+        ImportStatusText->setText(tr("cms-subscribers-import-merging").arg(totalText));
+        break;
+    case SubscribersImport::Stage::Done:
+    case SubscribersImport::Stage::Failed:
+        /// Reported by OnImportFinished
+        break;
+    }
+}
+
+void CmsSubscribers::Impl::OnImportFinished(const bool succeeded, const SubscribersImport::Result &result)
+{
+    ImportPushButton->setDisabled(false);
+
+    if (!succeeded) {
+        ImportStatusText->setText(tr("cms-subscribers-import-failed"));
+        return;
+    }
+
+    WString inserted;
+    WString total;
+    WString invalid;
+    WString duplicates;
+    GetNumber(result.Inserted, inserted);
+    GetNumber(result.Total, total);
+    GetNumber(result.Invalid, invalid);
+    GetNumber(result.Duplicates, duplicates);
+
+    ImportStatusText->setText(tr("cms-subscribers-import-done")
+                              .arg(inserted).arg(total).arg(invalid).arg(duplicates));
+
+    /// Counters and rows have changed underneath us
+    ApplyFilters();
+}
+
+void CmsSubscribers::Impl::OnSearchChanged()
+{
+    SearchTimer->stop();
+    SearchTimer->start();
+}
+
+void CmsSubscribers::Impl::ApplyFilters()
 {
     CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        const string pageOffset = button->attributeValue("page-offset").toUTF8();
+        SearchTimer->stop();
+
+        /// Invalidates any count still in flight
+        const uint_fast64_t generation = ++SearchGeneration;
 
-        this->PaginationPageOffset =
-                boost::lexical_cast<uint_fast64_t>(pageOffset);
-        this->PaginationItemOffset = this->PaginationPageOffset
-                * static_cast<uint_fast64_t>(this->PaginationItemsPerPageLimit);
+        const string filter(GetSearchFilter());
 
-        this->FillDataTable(this->PaginationTableType);
+        if (filter.empty()) {
+            SearchFilter.clear();
+            SearchTotalItems = 0;
+            FillDataTable(PaginationTableType);
+            return;
+        }
+
+        PaginationRangeText->setText(tr("cms-subscribers-search-searching"));
+
+        const string where((format("%1% AND %2%") % GetSegmentFilter(PaginationTableType) % filter).str());
+        const string sessionId(cgiRoot->sessionId());
+        const std::weak_ptr<bool> lifeToken(LifeToken);
+        CmsSubscribers::Impl *self = this;
+
+        /// Counting a filtered set may take a while, so keep it off the Wt
+        /// threads and push the outcome back into the session
+        const bool queued = Pool::Background().Post([=]() {
+            uint_fast64_t total = 0;
+            const bool succeeded = CountRows(where, total);
+
+            WServer::instance()->post(sessionId, [=]() {
+                if (lifeToken.expired())
+                    return;
+
+                self->OnSearchCounted(generation, filter, total, succeeded);
+                WApplication::instance()->triggerUpdate();
+            });
+        });
+
+        if (!queued) {
+            OnSearchCounted(generation, filter, 0, false);
+        }
     }
 
     catch (const boost::exception &ex) {
@@ -383,170 +803,360 @@ void CmsSubscribers::Impl::OnPaginiationButtonPressed(Wt::WPushButton *button)
     }
 }
 
-void CmsSubscribers::Impl::GetDate(const std::string &timeSinceEpoch, Wt::WString &out_date)
+void CmsSubscribers::Impl::OnSearchCounted(const uint_fast64_t generation, const std::string &filter,
+                                           const uint_fast64_t total, const bool succeeded)
+{
+    /// The filters have changed in the meantime
+    if (generation != SearchGeneration)
+        return;
+
+    if (!succeeded) {
+        PaginationRangeText->setText(tr("cms-subscribers-search-failed"));
+        return;
+    }
+
+    SearchFilter = filter;
+    SearchTotalItems = total;
+
+    FillDataTable(PaginationTableType);
+}
+
+void CmsSubscribers::Impl::GetNumber(const uint_fast64_t number, Wt::WString &out_number)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    if (cgiEnv->GetInformation().Client.Language.Code
+            != CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
+        out_number = WString(lexical_cast<wstring>(number));
+    } else {
+        out_number = WString(CDate::DateConv::FormatToPersianNums(lexical_cast<wstring>(number)));
+    }
+}
+
+bool CmsSubscribers::Impl::CountRows(const std::string &where, uint_fast64_t &out_count)
 {
+    /// Runs outside of any session, so there is no CgiEnv to log with
     try {
-        time_t tt = lexical_cast<time_t>(timeSinceEpoch);
+        auto conn = Pool::Database().Connection(CoreLib::Database::Intent::ReadOnly);
+        conn->activate();
+        pqxx::work txn(*conn.get());
 
-        struct tm *utc_tm = gmtime(&tt);
+        string query((format("SELECT count(*) AS count FROM \"%1%\" WHERE %2%;")
+                      % txn.esc(Pool::Database().GetTableName("SUBSCRIBERS"))
+                      % where).str());
+        LOG_INFO("Running query...", query);
 
-        int year = utc_tm->tm_year + 1900;
-        int month = utc_tm->tm_mon + 1;
-        int day = utc_tm->tm_mday;
+        result r = txn.exec(query);
+        txn.commit();
 
-        CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
-        CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+        out_count = r.empty() ? 0 : r[0]["count"].as<uint_fast64_t>();
 
-        if (cgiEnv->GetInformation().Client.Language.Code
-                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::En) {
-            out_date = (boost::wformat(L"%1%/%2%/%3%")
-                        % lexical_cast<wstring>(year)
-                        % lexical_cast<wstring>(month)
-                        % lexical_cast<wstring>(day)).str();
-        } else {
-            out_date = CDate::DateConv::FormatToPersianNums(CDate::DateConv::ToJalali(year, month, day));
-        }
-    } catch (...) {
-        out_date = L"-";
+        return true;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+std::string CmsSubscribers::Impl::GetSearchFilter()
+{
+    std::vector<std::string> conditions;
+
+    string term(boost::algorithm::trim_copy(SearchLineEdit->text().toUTF8()));
+    if (!term.empty()) {
+        /// Matches both prefixes and substrings through the trigram index
+        boost::algorithm::replace_all(term, "\\", "\\\\");
+        boost::algorithm::replace_all(term, "%", "\\%");
+        boost::algorithm::replace_all(term, "_", "\\_");
+        conditions.push_back((format("inbox ILIKE '%%%1%%%'") % Database::Escape(term)).str());
+    }
+
+    /// Served by the partial indexes on the pending states
+    switch (SearchStateComboBox->currentIndex()) {
+    case 1:
+        conditions.push_back("pending_confirm <> 'none'");
+        break;
+    case 2:
+        conditions.push_back("pending_cancel <> 'none'");
+        break;
+    default:
+        break;
+    }
+
+    const string dateField(SearchDateFieldComboBox->currentIndex() == 1 ? "update_date" : "join_date");
+
+    const WDate from(SearchDateFromEdit->date());
+    if (from.isValid()) {
+        const int_fast64_t epoch = static_cast<int_fast64_t>(from.toJulianDay() - UNIX_EPOCH_JULIAN_DAY) * SECONDS_PER_DAY;
+        conditions.push_back((format("%1% >= TO_TIMESTAMP(%2%)") % dateField % epoch).str());
+    }
+
+    const WDate to(SearchDateToEdit->date());
+    if (to.isValid()) {
+        const int_fast64_t epoch = static_cast<int_fast64_t>(to.toJulianDay() + 1 - UNIX_EPOCH_JULIAN_DAY) * SECONDS_PER_DAY;
+        conditions.push_back((format("%1% < TO_TIMESTAMP(%2%)") % dateField % epoch).str());
+    }
+
+    return boost::algorithm::join(conditions, " AND ");
+}
+
+std::string CmsSubscribers::Impl::GetSegmentFilter(const CmsSubscribers::Impl::Table &table)
+{
+    switch (table) {
+    case Table::All:
+        return "TRUE";
+    case Table::EnFa:
+        return "subscription = 'en_fa'";
+    case Table::En:
+        return "subscription = 'en'";
+    case Table::Fa:
+        return "subscription = 'fa'";
+    case Table::Inactive:
+        return "subscription = 'none'";
     }
+
+    return "FALSE";
 }
 
-void CmsSubscribers::Impl::GetSubscriptionTypeName(const std::string &type, Wt::WString &out_name)
+std::string CmsSubscribers::Impl::GetTableFilter(const CmsSubscribers::Impl::Table &table)
 {
-    static const std::string EN_FA_TYPE("en_fa");
-    static const std::string EN_TYPE("en");
-    static const std::string FA_TYPE("fa");
-    static const std::string NONE_TYPE("none");
+    if (SearchFilter.empty())
+        return GetSegmentFilter(table);
 
-    static const std::string EN_FA_NAME(tr("cms-subscribers-subscription-en-fa").toUTF8());
-    static const std::string EN_NAME(tr("cms-subscribers-subscription-en").toUTF8());
-    static const std::string FA_NAME(tr("cms-subscribers-subscription-fa").toUTF8());
-    static const std::string NONE_NAME(tr("cms-subscribers-subscription-none").toUTF8());
+    return (format("%1% AND %2%") % GetSegmentFilter(table) % SearchFilter).str();
+}
 
-    if (type == EN_FA_TYPE) {
-        out_name = WString::fromUTF8(EN_FA_NAME);
-    } else if (type == EN_TYPE) {
-        out_name = WString::fromUTF8(EN_NAME);
-    } else if (type == FA_TYPE) {
-        out_name = WString::fromUTF8(FA_NAME);
-    } else if (type == NONE_TYPE) {
-        out_name = WString::fromUTF8(NONE_NAME);
+std::string CmsSubscribers::Impl::GetCounterFilter(const CmsSubscribers::Impl::Table &table)
+{
+    switch (table) {
+    case Table::All:
+        return "TRUE";
+    default:
+        return GetSegmentFilter(table);
     }
 }
 
-void CmsSubscribers::Impl::FillDataTable(const CmsSubscribers::Impl::Table &tableType)
+void CmsSubscribers::Impl::FillDataTable(const CmsSubscribers::Impl::Table &tableType,
+                                         const CmsSubscribers::Impl::Seek &seek,
+                                         const std::string &key)
 {
     CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
+        const bool paginated = this->PaginationItemsPerPageLimit > -1;
+
         this->PaginationTableType = tableType;
 
-        SubscribersTableContainer->clear();
-
-        WTable *table = new WTable(SubscribersTableContainer);
-        table->setStyleClass("table table-striped table-hover");
-        table->setHeaderCount(1, Orientation::Horizontal);
-
-        table->elementAt(0, 0)->addWidget(new WText(tr("cms-subscribers-no")));
-        table->elementAt(0, 1)->addWidget(new WText(tr("cms-subscribers-inbox")));
-        table->elementAt(0, 2)->addWidget(new WText(tr("cms-subscribers-subscription")));
-        table->elementAt(0, 3)->addWidget(new WText(tr("cms-subscribers-pending-confirm")));
-        table->elementAt(0, 4)->addWidget(new WText(tr("cms-subscribers-pending-cancel")));
-        table->elementAt(0, 5)->addWidget(new WText(tr("cms-subscribers-join-date")));
-        table->elementAt(0, 6)->addWidget(new WText(tr("cms-subscribers-update-date")));
-        table->elementAt(0, 7)->addWidget(new WText(tr("cms-subscribers-uuid")));
-
-        std::string paginationPhrase;
-        if (this->PaginationItemsPerPageLimit > -1) {
-            paginationPhrase = (format("LIMIT %1% OFFSET %2%")
-                                % boost::lexical_cast<std::string>(this->PaginationItemsPerPageLimit)
-                                % boost::lexical_cast<std::string>(this->PaginationItemOffset)).str();
+        auto conn = Pool::Database().Connection(CoreLib::Database::Intent::ReadOnly);
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        const string tableName(txn.esc(Pool::Database().GetTableName("SUBSCRIBERS")));
+        const string filter(GetTableFilter(tableType));
+
+        for (SubscribersExport *e : this->Exports) {
+            e->SetFilter(filter);
         }
 
         string query;
-        switch (tableType) {
-        case Table::All:
-            query.assign((format("SELECT count(*) over(), inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date"
-                                 " FROM \"%1%\" ORDER BY inbox ASC %2%;")
-                          % Pool::Database().GetTableName("SUBSCRIBERS") % paginationPhrase).str());
+        result r;
+
+        if (this->SearchFilter.empty()) {
+            /// The maintained counter is way cheaper than count(*) over()
+            query.assign((format("SELECT COALESCE(sum(count), 0) AS count FROM \"%1%\" WHERE %2%;")
+                          % txn.esc(Pool::Database().GetTableName("SUBSCRIBER_COUNTS"))
+                          % GetCounterFilter(tableType)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+
+            r = txn.exec(query);
+            this->PaginationTotalItems = r.empty() ? 0 : r[0]["count"].as<uint_fast64_t>();
+        } else {
+            /// Counted off the UI thread once, whenever the filters change
+            this->PaginationTotalItems = this->SearchTotalItems;
+        }
+
+        if (!paginated) {
+            txn.commit();
+
+            this->PaginationItemOffset = 0;
+            this->PaginationItemOffsetKnown = true;
+            this->PaginationPageItems = this->PaginationTotalItems;
+            this->PaginationFirstInbox.clear();
+            this->PaginationLastInbox.clear();
+            this->PaginationHasPrevious = false;
+            this->PaginationHasNext = false;
+
+            /// Let the view pull in whatever it's about to show, block by block
+            this->SubscribersTableModel->SetLazy(filter, this->PaginationTotalItems);
+            this->SubscribersTableView->scrollTo(this->SubscribersTableModel->index(0, 0));
+
+            this->ReEvaluatePaginationButtons();
+
+            return;
+        }
+
+        /// Fetch one extra row in order to find out whether there is another
+        /// page in the direction we are moving to
+        const string limitPhrase((format("LIMIT %1%")
+                                  % boost::lexical_cast<std::string>(this->PaginationItemsPerPageLimit + 1)).str());
+
+        string seekPhrase;
+        string orderPhrase("ASC");
+        Seek effectiveSeek = seek;
+        if (effectiveSeek != Seek::First && effectiveSeek != Seek::Last && key.empty()) {
+            effectiveSeek = Seek::First;
+        }
+
+        switch (effectiveSeek) {
+        case Seek::First:
             break;
-        case Table::EnFa:
-            query.assign((format("SELECT count(*) over(), inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date"
-                                 " FROM \"%1%\" WHERE subscription = 'en_fa' ORDER BY inbox ASC %2%;")
-                          % Pool::Database().GetTableName("SUBSCRIBERS") % paginationPhrase).str());
+        case Seek::Previous:
+            seekPhrase = (format(" AND inbox < %1%") % txn.quote(key)).str();
+            orderPhrase = "DESC";
             break;
-        case Table::En:
-            query.assign((format("SELECT count(*) over(), inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date"
-                                 " FROM \"%1%\" WHERE subscription = 'en' ORDER BY inbox ASC %2%;")
-                          % Pool::Database().GetTableName("SUBSCRIBERS") % paginationPhrase).str());
+        case Seek::Next:
+            seekPhrase = (format(" AND inbox > %1%") % txn.quote(key)).str();
             break;
-        case Table::Fa:
-            query.assign((format("SELECT count(*) over(), inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date"
-                                 " FROM \"%1%\" WHERE subscription = 'fa' ORDER BY inbox ASC %2%;")
-                          % Pool::Database().GetTableName("SUBSCRIBERS") % paginationPhrase).str());
+        case Seek::Last:
+            orderPhrase = "DESC";
             break;
-        case Table::Inactive:
-            query.assign((format("SELECT count(*) over(), inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date"
-                                 " FROM \"%1%\" WHERE subscription = 'none' ORDER BY inbox ASC %2%;")
-                          % Pool::Database().GetTableName("SUBSCRIBERS") % paginationPhrase).str());
+        case Seek::Letter:
+        case Seek::Current:
+            seekPhrase = (format(" AND inbox >= %1%") % txn.quote(key)).str();
             break;
         }
 
+        query.assign((format("SELECT %1%"
+                             " FROM \"%2%\" WHERE %3%%4% ORDER BY inbox %5% %6%;")
+                      % SubscribersModel::SelectColumns()
+                      % tableName % filter % seekPhrase % orderPhrase % limitPhrase).str());
         LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        result r = txn.exec(query);
-
-        int i = 0;
-        for (const auto & row : r) {
-            ++i;
-
-            this->PaginationTotalItems = boost::lexical_cast<uint_fast64_t>(row["count"].c_str());
-
-            const string inbox(row["inbox"].c_str());
-            const string uuid(row["uuid"].c_str());
-            const string subscription(row["subscription"].c_str());
-            const string pendingConfirm(row["pending_confirm"].c_str());
-            const string pendingCancel(row["pending_cancel"].c_str());
-            const string joinDate(row["join_date"].c_str());
-            const string updateDate(row["update_date"].c_str());
+        r = txn.exec(query);
+
+        std::vector<SubscribersModel::Row> rows;
+        rows.reserve(r.size());
+        for (const auto &row : r) {
+            SubscribersModel::Row s;
+            s.Inbox.assign(row["inbox"].c_str());
+            s.Uuid.assign(row["uuid"].c_str());
+            s.Subscription.assign(row["subscription"].c_str());
+            s.PendingConfirm.assign(row["pending_confirm"].c_str());
+            s.PendingCancel.assign(row["pending_cancel"].c_str());
+            s.JoinDate = row["join_date"].as<std::time_t>();
+            s.UpdateDate = row["update_date"].as<std::time_t>();
+            rows.push_back(std::move(s));
+        }
 
-            WString subscriptionTypeName;
-            WString pendingConfirmTypeName;
-            WString pendingCancelTypeName;
+        bool more = false;
+        if (rows.size() > static_cast<size_t>(this->PaginationItemsPerPageLimit)) {
+            rows.pop_back();
+            more = true;
+        }
 
-            this->GetSubscriptionTypeName(subscription, subscriptionTypeName);
-            this->GetSubscriptionTypeName(pendingConfirm, pendingConfirmTypeName);
-            this->GetSubscriptionTypeName(pendingCancel, pendingCancelTypeName);
+        if (orderPhrase == "DESC") {
+            std::reverse(rows.begin(), rows.end());
+        }
 
-            WString joinDateFormatted;
-            WString updateDateFormatted;
+        /// Someone has removed the rows we were about to seek past
+        if (rows.empty() && (effectiveSeek == Seek::Next || effectiveSeek == Seek::Previous)) {
+            txn.commit();
+            this->FillDataTable(tableType, effectiveSeek == Seek::Next ? Seek::Last : Seek::First);
+            return;
+        }
 
-            this->GetDate(joinDate, joinDateFormatted);
-            this->GetDate(updateDate, updateDateFormatted);
+        const uint_fast64_t pageItems = static_cast<uint_fast64_t>(rows.size());
 
-            WString rowNumber;
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    != CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                rowNumber = WString(lexical_cast<wstring>(this->PaginationItemOffset + static_cast<uint_fast64_t>(i)));
-            } else {
-                rowNumber = WString(CDate::DateConv::FormatToPersianNums(lexical_cast<wstring>(this->PaginationItemOffset + static_cast<uint_fast64_t>(i))));
+        switch (effectiveSeek) {
+        case Seek::First:
+            this->PaginationItemOffset = 0;
+            this->PaginationItemOffsetKnown = true;
+            this->PaginationHasPrevious = false;
+            this->PaginationHasNext = more;
+            break;
+        case Seek::Previous:
+            if (!more) {
+                /// Back at the very beginning, wherever we came from
+                this->PaginationItemOffset = 0;
+                this->PaginationItemOffsetKnown = true;
+            } else if (this->PaginationItemOffsetKnown) {
+                this->PaginationItemOffset = this->PaginationItemOffset > pageItems
+                        ? this->PaginationItemOffset - pageItems : 0;
+            }
+            this->PaginationHasPrevious = more;
+            this->PaginationHasNext = true;
+            break;
+        case Seek::Next:
+            if (this->PaginationItemOffsetKnown) {
+                this->PaginationItemOffset += this->PaginationPageItems;
+            } else if (!more) {
+                /// At the very end, the same as the last page
+                this->PaginationItemOffset = this->PaginationTotalItems > pageItems
+                        ? this->PaginationTotalItems - pageItems : 0;
+                this->PaginationItemOffsetKnown = true;
+            }
+            this->PaginationHasPrevious = true;
+            this->PaginationHasNext = more;
+            break;
+        case Seek::Last:
+            this->PaginationItemOffset = this->PaginationTotalItems > pageItems
+                    ? this->PaginationTotalItems - pageItems : 0;
+            this->PaginationItemOffsetKnown = true;
+            this->PaginationHasPrevious = more;
+            this->PaginationHasNext = false;
+            break;
+        case Seek::Letter:
+            /// Counting everything before the letter would visit each of
+            /// those rows on every jump; a single probe on the inbox index
+            /// tells whether there is anything before it at all
+            query.assign((format("SELECT EXISTS ( SELECT 1 FROM \"%1%\" WHERE %2% AND inbox < %3% ) AS previous;")
+                          % tableName % filter % txn.quote(key)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+            {
+                result c = txn.exec(query);
+                this->PaginationHasPrevious = !c.empty() && c[0]["previous"].as<bool>();
             }
+            this->PaginationItemOffset = 0;
+            this->PaginationItemOffsetKnown = !this->PaginationHasPrevious;
+            this->PaginationHasNext = more;
+            break;
+        case Seek::Current:
+            this->PaginationHasPrevious = this->PaginationItemOffset > 0;
+            this->PaginationHasNext = more;
+            break;
+        }
 
-            table->elementAt(i, 0)->addWidget(new WText(rowNumber));
-            table->elementAt(i, 1)->addWidget(new WText(WString::fromUTF8(inbox)));
-            table->elementAt(i, 2)->addWidget(new WText(subscriptionTypeName));
-            table->elementAt(i, 3)->addWidget(new WText(pendingConfirmTypeName));
-            table->elementAt(i, 4)->addWidget(new WText(pendingCancelTypeName));
-            table->elementAt(i, 5)->addWidget(new WText(joinDateFormatted));
-            table->elementAt(i, 6)->addWidget(new WText(updateDateFormatted));
-            table->elementAt(i, 7)->addWidget(new WText(WString::fromUTF8(uuid)));
+        txn.commit();
+
+        this->PaginationPageItems = pageItems;
+        if (!rows.empty()) {
+            this->PaginationFirstInbox.assign(rows.front().Inbox);
+            this->PaginationLastInbox.assign(rows.back().Inbox);
+        } else {
+            this->PaginationFirstInbox.clear();
+            this->PaginationLastInbox.clear();
         }
 
+        this->SubscribersTableModel->SetRows(std::move(rows), this->PaginationItemOffset,
+                                             this->PaginationItemOffsetKnown);
+
         this->ReEvaluatePaginationButtons();
     }
 
@@ -573,40 +1183,37 @@ void CmsSubscribers::Impl::ReEvaluatePaginationButtons()
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        this->PaginationButtonsContainer->clear();
-
         if (this->PaginationItemsPerPageLimit < 0) {
+            this->PaginationButtonsContainer->hide();
             return;
         }
 
-        uint_fast64_t numberOfPages = static_cast<uint_fast64_t>(
-                    std::ceil(this->PaginationTotalItems
-                              / static_cast<double>(this->PaginationItemsPerPageLimit)));
-        for (uint_fast64_t i = 0; i < numberOfPages; ++i) {
-            WString pageNumber;
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    != CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                pageNumber = WString(lexical_cast<wstring>(i + 1));
-            } else {
-                pageNumber = WString(CDate::DateConv::FormatToPersianNums(lexical_cast<wstring>(i +1)));
-            }
+        this->PaginationButtonsContainer->show();
 
-            WPushButton *button = new WPushButton(pageNumber);
-            button->setAttributeValue(
-                        "page-offset", WString::fromUTF8(lexical_cast<string>(i)));
+        this->PaginationFirstButton->setDisabled(!this->PaginationHasPrevious);
+        this->PaginationPreviousButton->setDisabled(!this->PaginationHasPrevious);
+        this->PaginationNextButton->setDisabled(!this->PaginationHasNext);
+        this->PaginationLastButton->setDisabled(!this->PaginationHasNext);
 
-            if (i != this->PaginationPageOffset) {
-                button->setStyleClass("btn btn-default");
-            } else {
-                button->setStyleClass("btn btn-primary");
-            }
+        WString from;
+        WString to;
+        WString total;
 
-            this->PaginationButtonsContainer->addWidget(button);
+        this->GetNumber(this->PaginationTotalItems, total);
 
-            WSignalMapper<WPushButton *> *buttonSignalMapper = new WSignalMapper<WPushButton *>(this);
-            buttonSignalMapper->mapped().connect(this, &CmsSubscribers::Impl::OnPaginiationButtonPressed);
-            buttonSignalMapper->mapConnect(button->clicked(), button);
+        if (!this->PaginationItemOffsetKnown && this->PaginationPageItems > 0) {
+            /// Tell where we are by the inboxes instead
+            this->PaginationRangeText->setText(tr("cms-subscribers-pagination-range-inboxes")
+                                               .arg(WString::fromUTF8(this->PaginationFirstInbox))
+                                               .arg(WString::fromUTF8(this->PaginationLastInbox))
+                                               .arg(total));
+            return;
         }
+
+        this->GetNumber(this->PaginationPageItems > 0 ? this->PaginationItemOffset + 1 : 0, from);
+        this->GetNumber(this->PaginationItemOffset + this->PaginationPageItems, to);
+
+        this->PaginationRangeText->setText(tr("cms-subscribers-pagination-range").arg(from).arg(to).arg(total));
     }
 
     catch (const boost::exception &ex) {
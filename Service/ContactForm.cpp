@@ -499,9 +499,7 @@ void ContactForm::Impl::SendUserMessageEmail(const std::string &to, const CDate:
         replace_all(htmlData, "${client-referer}",
                     cgiEnv->GetInformation().Client.Referer);
         replace_all(htmlData, "${time}",
-                    (format("%1% ~ %2%")
-                     % WString(DateConv::FormatToPersianNums(DateConv::ToJalali(n))).toUTF8()
-                     % algorithm::trim_copy(DateConv::DateTimeString(n))).str());
+                    DateConv::PersianTimeStamp(n));
         replace_all(htmlData, "${client-location-country-code}",
                     cgiEnv->GetInformation().Client.GeoLocation.CountryCode);
         replace_all(htmlData, "${client-location-country-name}",
@@ -0,0 +1,238 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Periodically purges expired root sessions, stale credentials recovery
+ * tokens and never-confirmed subscribers, in small batches, on a single
+ * instance elected through a PostgreSQL advisory lock.
+ */
+
+
+#include <boost/chrono/chrono.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <pqxx/pqxx>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "Janitor.hpp"
+#include "Pool.hpp"
+
+#define     JANITOR_LOCK_KEY            1784770162
+#define     JANITOR_BATCH_PAUSE_MSEC    50
+
+using namespace std;
+using namespace boost;
+using namespace Service;
+
+struct Janitor::Impl
+{
+public:
+    std::unique_ptr<boost::thread> Thread;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    void Run();
+    void Sweep();
+
+    uint_fast64_t Purge(pqxx::connection_base &conn, const std::string &tableId, const std::string &condition);
+};
+
+Janitor::Janitor()
+    : m_pimpl(make_unique<Janitor::Impl>())
+{
+
+}
+
+Janitor::~Janitor()
+{
+    Stop();
+}
+
+void Janitor::Start()
+{
+    if (m_pimpl->Thread)
+        return;
+
+    LOG_INFO("Starting Service::Janitor...");
+
+    m_pimpl->Thread = make_unique<boost::thread>(&Janitor::Impl::Run, m_pimpl.get());
+}
+
+void Janitor::Stop()
+{
+    if (!m_pimpl->Thread)
+        return;
+
+    m_pimpl->Thread->interrupt();
+    m_pimpl->Thread->join();
+    m_pimpl->Thread.reset();
+}
+
+Janitor::Impl::Impl()
+{
+
+}
+
+Janitor::Impl::~Impl() = default;
+
+void Janitor::Impl::Run()
+{
+    LOG_INFO("Janitor thread started");
+
+    for (;;) {
+        try {
+            Sweep();
+        }
+
+        catch (const boost::thread_interrupted &) {
+            break;
+        }
+
+        catch (const pqxx::sql_error &ex) {
+            LOG_ERROR(ex.what(), ex.query());
+        }
+
+        catch (const boost::exception &ex) {
+            LOG_ERROR(boost::diagnostic_information(ex));
+        }
+
+        catch (const std::exception &ex) {
+            LOG_ERROR(ex.what());
+        }
+
+        catch (...) {
+            LOG_ERROR(UNKNOWN_ERROR);
+        }
+
+        try {
+            boost::this_thread::sleep_for(boost::chrono::seconds(Pool::Storage().JanitorInterval()));
+        } catch (const boost::thread_interrupted &) {
+            break;
+        }
+    }
+
+    LOG_INFO("Janitor thread stopped");
+}
+
+void Janitor::Impl::Sweep()
+{
+    /// A dedicated connection, since the advisory lock is bound to the
+    /// session; it goes away along with the connection no matter what, so a
+    /// pooled connection never gets handed out while still holding it.
+    pqxx::connection conn(Pool::Database().GetConnectionString());
+
+    {
+        pqxx::nontransaction txn(conn);
+        pqxx::result r = txn.exec((boost::format("SELECT pg_try_advisory_lock( %1% ) AS elected;")
+                                   % JANITOR_LOCK_KEY).str());
+
+        if (r.empty() || !r[0]["elected"].as<bool>()) {
+            /// Some other instance is taking care of it
+            return;
+        }
+    }
+
+    const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    /// Temporary sessions carry expiry == login_time and stay valid for as
+    /// long as the browser keeps them, so they get a far longer grace period
+    /// counted from login; recurring and force-exited ones go after expiry.
+    const uint_fast64_t sessions = Purge(
+                conn, "ROOT_SESSIONS",
+                (boost::format("( expiry <> login_time AND expiry < NOW() - INTERVAL '%1% seconds' )"
+                               " OR ( expiry = login_time AND login_time < NOW() - INTERVAL '%2% seconds' )")
+                 % Pool::Storage().ExpiredRootSessionRetention()
+                 % Pool::Storage().TemporaryRootSessionRetention()).str());
+
+    const uint_fast64_t recoveryTokens = Purge(
+                conn, "ROOT_CREDENTIALS_RECOVERY",
+                (boost::format("expiry < NOW() - INTERVAL '%1% seconds'")
+                 % Pool::Storage().ExpiredRecoveryTokenRetention()).str());
+
+    /// Never confirmed a single subscription; the counters follow through
+    /// the subscribers' delete trigger
+    const uint_fast64_t subscribers = Purge(
+                conn, "SUBSCRIBERS",
+                (boost::format("subscription = 'none' AND pending_confirm <> 'none'"
+                               " AND update_date < NOW() - INTERVAL '%1% seconds'")
+                 % Pool::Storage().UnconfirmedSubscriberRetention()).str());
+
+    const boost::chrono::milliseconds elapsed =
+            boost::chrono::duration_cast<boost::chrono::milliseconds>(boost::chrono::steady_clock::now() - start);
+
+    LOG_INFO("Janitor sweep completed",
+             (boost::format("root sessions: %1%") % sessions).str(),
+             (boost::format("credentials recovery tokens: %1%") % recoveryTokens).str(),
+             (boost::format("unconfirmed subscribers: %1%") % subscribers).str(),
+             (boost::format("elapsed: %1% ms") % elapsed.count()).str());
+
+    pqxx::nontransaction txn(conn);
+    txn.exec((boost::format("SELECT pg_advisory_unlock( %1% );") % JANITOR_LOCK_KEY).str());
+}
+
+uint_fast64_t Janitor::Impl::Purge(pqxx::connection_base &conn, const std::string &tableId, const std::string &condition)
+{
+    uint_fast64_t purged = 0;
+
+    for (;;) {
+        boost::this_thread::interruption_point();
+
+        pqxx::work txn(conn);
+
+        /// Small batches keep row locks short-lived and never block the
+        /// service; rows somebody else is holding get their turn next time.
+        string query((boost::format("DELETE FROM \"%1%\" WHERE ctid = ANY ( ARRAY ("
+                                    " SELECT ctid FROM \"%1%\" WHERE %2%"
+                                    " LIMIT %3% FOR UPDATE SKIP LOCKED"
+                                    " ) );")
+                      % txn.esc(Pool::Database().GetTableName(tableId))
+                      % condition
+                      % Pool::Storage().JanitorBatchSize()).str());
+
+        pqxx::result r = txn.exec(query);
+
+        txn.commit();
+
+        const pqxx::result::size_type affected = r.affected_rows();
+        purged += affected;
+
+        if (affected < static_cast<pqxx::result::size_type>(Pool::Storage().JanitorBatchSize()))
+            break;
+
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(JANITOR_BATCH_PAUSE_MSEC));
+    }
+
+    return purged;
+}
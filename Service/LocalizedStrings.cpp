@@ -0,0 +1,386 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A process-wide, pre-parsed copy of the i18n message bundles for code that
+ * runs outside of a Wt session.
+ */
+
+
+#include <atomic>
+#include <cstdlib>
+#include <boost/exception/diagnostic_information.hpp>
+#include <CoreLib/FileSystem.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "LocalizedStrings.hpp"
+
+using namespace std;
+using namespace boost;
+using namespace Service;
+
+struct LocalizedStrings::Impl
+{
+public:
+    /// Always accessed through std::atomic_load / std::atomic_store
+    SnapshotPtr Strings;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    static bool Parse(const std::string &file, Messages &out_messages);
+    static bool ParseValue(const std::string &data, std::string::size_type &pos, std::string &out_value);
+    static void AppendCodePoint(const unsigned long codePoint, std::string &out_value);
+    static const Messages *Find(const Snapshot &snapshot, const std::string &locale);
+};
+
+LocalizedStrings::LocalizedStrings()
+    : m_pimpl(make_unique<LocalizedStrings::Impl>())
+{
+
+}
+
+LocalizedStrings::~LocalizedStrings() = default;
+
+bool LocalizedStrings::Load(const std::string &path, const std::vector<std::string> &locales)
+{
+    LOG_INFO("Loading the localized strings...", path);
+
+    try {
+        auto strings = std::make_shared<Snapshot>();
+
+        if (!Impl::Parse(path + ".xml", strings->Default))
+            return false;
+
+        for (const auto &locale : locales) {
+            Messages messages;
+            if (!Impl::Parse(path + "_" + locale + ".xml", messages))
+                return false;
+            strings->Locales.emplace(locale, std::move(messages));
+        }
+
+        std::atomic_store(&m_pimpl->Strings, SnapshotPtr(strings));
+
+        LOG_INFO("Localized strings loaded successfully!", path);
+
+        return true;
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+LocalizedStrings::SnapshotPtr LocalizedStrings::Get() const
+{
+    SnapshotPtr strings(std::atomic_load(&m_pimpl->Strings));
+
+    if (!strings) {
+        /// Load() has not been called yet or has never succeeded
+        strings = std::make_shared<Snapshot>();
+    }
+
+    return strings;
+}
+
+bool LocalizedStrings::Resolve(const std::string &locale, const std::string &key, std::string &out_value) const
+{
+    SnapshotPtr strings(std::atomic_load(&m_pimpl->Strings));
+
+    if (!strings)
+        return false;
+
+    const Messages *messages = Impl::Find(*strings, locale);
+
+    if (messages) {
+        auto it = messages->find(key);
+        if (it != messages->end()) {
+            out_value.assign(it->second);
+            return true;
+        }
+    }
+
+    auto it = strings->Default.find(key);
+    if (it != strings->Default.end()) {
+        out_value.assign(it->second);
+        return true;
+    }
+
+    return false;
+}
+
+std::string LocalizedStrings::Resolve(const std::string &locale, const std::string &key) const
+{
+    string value;
+
+    if (!Resolve(locale, key, value))
+        value = "??" + key + "??";
+
+    return value;
+}
+
+LocalizedStrings::Impl::Impl()
+{
+
+}
+
+LocalizedStrings::Impl::~Impl() = default;
+
+bool LocalizedStrings::Impl::Parse(const std::string &file, Messages &out_messages)
+{
+    static const string OPEN_TAG("<message");
+    static const string CLOSE_TAG("</message>");
+    static const string COMMENT_BEGIN("<!--");
+    static const string COMMENT_END("-->");
+
+    string data;
+    if (!CoreLib::FileSystem::Read(file, data) || data.empty()) {
+        LOG_ERROR("Failed to read the message bundle!", file);
+        return false;
+    }
+
+    out_messages.clear();
+
+    /// The bundles are plain <message id="...">...</message> lists; values
+    /// come out as XHTML, just like WMessageResources hands them out
+    string::size_type pos = 0;
+    while ((pos = data.find('<', pos)) != string::npos) {
+        if (data.compare(pos, COMMENT_BEGIN.size(), COMMENT_BEGIN) == 0) {
+            pos = data.find(COMMENT_END, pos + COMMENT_BEGIN.size());
+            if (pos == string::npos) {
+                LOG_ERROR("Malformed message bundle!", file);
+                return false;
+            }
+            pos += COMMENT_END.size();
+            continue;
+        }
+
+        if (data.compare(pos, OPEN_TAG.size(), OPEN_TAG) != 0
+                || (data[pos + OPEN_TAG.size()] != ' ' && data[pos + OPEN_TAG.size()] != '\t'
+                    && data[pos + OPEN_TAG.size()] != '\r' && data[pos + OPEN_TAG.size()] != '\n')) {
+            ++pos;
+            continue;
+        }
+
+        const string::size_type tagEnd = data.find('>', pos);
+        string::size_type idBegin = data.find("id=", pos);
+
+        if (tagEnd == string::npos || idBegin == string::npos || idBegin > tagEnd
+                || (data[idBegin + 3] != '"' && data[idBegin + 3] != '\'')) {
+            LOG_ERROR("Malformed message bundle!", file);
+            return false;
+        }
+
+        const char quote = data[idBegin + 3];
+        idBegin += 4;
+        const string::size_type idEnd = data.find(quote, idBegin);
+
+        if (idEnd == string::npos || idEnd > tagEnd) {
+            LOG_ERROR("Malformed message bundle!", file);
+            return false;
+        }
+
+        string id(data, idBegin, idEnd - idBegin);
+        string &value = out_messages[id];
+        value.clear();
+
+        pos = tagEnd + 1;
+
+        if (data[tagEnd - 1] == '/')
+            continue;
+
+        if (!ParseValue(data, pos, value)) {
+            LOG_ERROR("Malformed message bundle!", file, id);
+            return false;
+        }
+
+        pos += CLOSE_TAG.size();
+    }
+
+    if (out_messages.empty()) {
+        LOG_ERROR("Empty message bundle!", file);
+        return false;
+    }
+
+    return true;
+}
+
+bool LocalizedStrings::Impl::ParseValue(const std::string &data, std::string::size_type &pos,
+                                        std::string &out_value)
+{
+    static const string CLOSE_TAG("</message>");
+    static const string COMMENT_BEGIN("<!--");
+    static const string COMMENT_END("-->");
+    static const string CDATA_BEGIN("<![CDATA[");
+    static const string CDATA_END("]]>");
+
+    /// Markup is kept as is, comments are dropped, CDATA sections and
+    /// character references are turned into text; &lt; &gt; and &amp; stay
+    /// escaped, since the value is XHTML
+    while (pos < data.size()) {
+        const char c = data[pos];
+
+        if (c == '<') {
+            if (data.compare(pos, CLOSE_TAG.size(), CLOSE_TAG) == 0) {
+                return true;
+            }
+
+            if (data.compare(pos, COMMENT_BEGIN.size(), COMMENT_BEGIN) == 0) {
+                const string::size_type end = data.find(COMMENT_END, pos + COMMENT_BEGIN.size());
+                if (end == string::npos)
+                    return false;
+                pos = end + COMMENT_END.size();
+                continue;
+            }
+
+            if (data.compare(pos, CDATA_BEGIN.size(), CDATA_BEGIN) == 0) {
+                const string::size_type begin = pos + CDATA_BEGIN.size();
+                const string::size_type end = data.find(CDATA_END, begin);
+                if (end == string::npos)
+                    return false;
+                for (string::size_type i = begin; i < end; ++i) {
+                    if (data[i] == '<' || data[i] == '>' || data[i] == '&') {
+                        AppendCodePoint(static_cast<unsigned long>(data[i]), out_value);
+                    } else {
+                        out_value.push_back(data[i]);
+                    }
+                }
+                pos = end + CDATA_END.size();
+                continue;
+            }
+
+            const string::size_type end = data.find('>', pos);
+            if (end == string::npos)
+                return false;
+            out_value.append(data, pos, end - pos + 1);
+            pos = end + 1;
+            continue;
+        }
+
+        if (c == '&') {
+            const string::size_type end = data.find(';', pos);
+            if (end == string::npos || end - pos > 10)
+                return false;
+
+            const string name(data, pos + 1, end - pos - 1);
+            unsigned long codePoint = 0;
+
+            if (name == "lt" || name == "gt" || name == "amp") {
+                codePoint = name == "lt" ? '<' : name == "gt" ? '>' : '&';
+            } else if (name == "quot") {
+                codePoint = '"';
+            } else if (name == "apos") {
+                codePoint = '\'';
+            } else if (name.size() > 1 && name[0] == '#') {
+                const bool hex = name[1] == 'x' || name[1] == 'X';
+                const string digits(name, hex ? 2 : 1);
+                char *digitsEnd = nullptr;
+                codePoint = std::strtoul(digits.c_str(), &digitsEnd, hex ? 16 : 10);
+                if (digits.empty() || *digitsEnd != '\0' || codePoint == 0 || codePoint > 0x10FFFF)
+                    return false;
+            } else {
+                return false;
+            }
+
+            AppendCodePoint(codePoint, out_value);
+            pos = end + 1;
+            continue;
+        }
+
+        out_value.push_back(c);
+        ++pos;
+    }
+
+    return false;
+}
+
+void LocalizedStrings::Impl::AppendCodePoint(const unsigned long codePoint, std::string &out_value)
+{
+    switch (codePoint) {
+    case '<':
+        out_value.append("&lt;");
+        return;
+    case '>':
+        out_value.append("&gt;");
+        return;
+    case '&':
+        out_value.append("&amp;");
+        return;
+    default:
+        break;
+    }
+
+    if (codePoint < 0x80) {
+        out_value.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out_value.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out_value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out_value.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out_value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out_value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out_value.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out_value.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out_value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out_value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+const LocalizedStrings::Messages *LocalizedStrings::Impl::Find(const Snapshot &snapshot, const std::string &locale)
+{
+    if (locale.empty())
+        return nullptr;
+
+    auto it = snapshot.Locales.find(locale);
+    if (it != snapshot.Locales.end())
+        return &it->second;
+
+    const string::size_type separator = locale.find_first_of("-_");
+    if (separator != string::npos) {
+        it = snapshot.Locales.find(locale.substr(0, separator));
+        if (it != snapshot.Locales.end())
+            return &it->second;
+    }
+
+    return nullptr;
+}
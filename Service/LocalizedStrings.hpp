@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A process-wide, pre-parsed copy of the i18n message bundles for code that
+ * runs outside of a Wt session; sessions use SharedLocalizedStrings.
+ */
+
+
+#ifndef SERVICE_LOCALIZED_STRINGS_HPP
+#define SERVICE_LOCALIZED_STRINGS_HPP
+
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Service {
+class LocalizedStrings;
+}
+
+class Service::LocalizedStrings
+{
+public:
+    typedef std::unordered_map<std::string, std::string> Messages;
+
+    struct Snapshot
+    {
+        Messages Default;
+        std::unordered_map<std::string, Messages> Locales;
+    };
+
+    typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    LocalizedStrings();
+    virtual ~LocalizedStrings();
+
+public:
+    /// Parses <path>.xml and <path>_<locale>.xml for each of the locales, the
+    /// same files Wt::WMessageResourceBundle::use(path) would pick up; on
+    /// failure the previously loaded bundle stays in effect
+    bool Load(const std::string &path, const std::vector<std::string> &locales);
+
+    SnapshotPtr Get() const;
+
+    /// Falls back to the language part of the locale (fa-IR -> fa), then to
+    /// the default bundle
+    bool Resolve(const std::string &locale, const std::string &key, std::string &out_value) const;
+
+    /// Same as above, but returns ??key?? for a missing key, just like Wt does
+    std::string Resolve(const std::string &locale, const std::string &key) const;
+};
+
+
+#endif /* SERVICE_LOCALIZED_STRINGS_HPP */
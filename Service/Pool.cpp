@@ -33,6 +33,9 @@
  */
 
 
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
 #include <boost/thread/once.hpp>
@@ -40,12 +43,40 @@
 #include <CoreLib/Crypto.hpp>
 #include <CoreLib/Database.hpp>
 #include <CoreLib/Log.hpp>
+#include "Argon2Executor.hpp"
+#include "Janitor.hpp"
+#include "LocalizedStrings.hpp"
 #include "Pool.hpp"
+#include "SessionCache.hpp"
+#include "SettingsCache.hpp"
+#include "WorkerPool.hpp"
 
 using namespace std;
 using namespace boost;
 using namespace Service;
 
+const std::string &Pool::StorageStruct::ServiceUrl() const
+{
+    static const string URL(trim_right_copy_if(string(SERVICE_URL), is_any_of("/")));
+    return URL;
+}
+
+const std::string &Pool::StorageStruct::ServiceHostname() const
+{
+    /// scheme://host[:port][/path]
+    static const string HOSTNAME([this]() {
+        string host(ServiceUrl());
+        string::size_type pos = host.find("://");
+        if (pos != string::npos)
+            host.erase(0, pos + 3);
+        pos = host.find_first_of(":/");
+        if (pos != string::npos)
+            host.erase(pos);
+        return host;
+    }());
+    return HOSTNAME;
+}
+
 const int &Pool::StorageStruct::LanguageCookieLifespan() const
 {
     /// 365 Days * 24 Hours * 60 Minutes * 60 Seconds = Number of Days in Seconds
@@ -223,6 +254,20 @@ const int &Pool::StorageStruct::TokenLifespan() const
     return DURATION;
 }
 
+const int &Pool::StorageStruct::ConfirmLinkLifespan() const
+{
+    // 7 Days * 24 Hours * 60 Minutes * 60 Seconds; as long as unconfirmed subscribers are kept around
+    static constexpr int DURATION = 7 * 24 * 60 * 60;
+    return DURATION;
+}
+
+const int &Pool::StorageStruct::UnsubscribeLinkLifespan() const
+{
+    // 365 Days * 24 Hours * 60 Minutes * 60 Seconds; newsletters get read late
+    static constexpr int DURATION = 365 * 24 * 60 * 60;
+    return DURATION;
+}
+
 
 const int &Pool::StorageStruct::MinHomePageTitleLength() const
 {
@@ -243,6 +288,82 @@ const int &Pool::StorageStruct::ResetPwdLifespan() const
     return DURATION;
 }
 
+const int &Pool::StorageStruct::JanitorInterval() const
+{
+    // 15 Minutes * 60 Seconds
+    static constexpr int DURATION = 15 * 60;
+    return DURATION;
+}
+
+const int &Pool::StorageStruct::JanitorBatchSize() const
+{
+    static constexpr int SIZE = 500;
+    return SIZE;
+}
+
+const int &Pool::StorageStruct::ExpiredRootSessionRetention() const
+{
+    // 1 Day * 24 Hours * 60 Minutes * 60 Seconds, after expiry
+    static constexpr int DURATION = 1 * 24 * 60 * 60;
+    return DURATION;
+}
+
+const int &Pool::StorageStruct::TemporaryRootSessionRetention() const
+{
+    // 30 Days * 24 Hours * 60 Minutes * 60 Seconds, after login
+    static constexpr int DURATION = 30 * 24 * 60 * 60;
+    return DURATION;
+}
+
+const int &Pool::StorageStruct::ExpiredRecoveryTokenRetention() const
+{
+    // 1 Day * 24 Hours * 60 Minutes * 60 Seconds, after expiry
+    static constexpr int DURATION = 1 * 24 * 60 * 60;
+    return DURATION;
+}
+
+const int &Pool::StorageStruct::UnconfirmedSubscriberRetention() const
+{
+    // 7 Days * 24 Hours * 60 Minutes * 60 Seconds; way past TokenLifespan()
+    static constexpr int DURATION = 7 * 24 * 60 * 60;
+    return DURATION;
+}
+
+const int &Pool::StorageStruct::MaxSubscribersImportSize() const
+{
+    // 256 MiB of CSV, after decompression; several million subscribers
+    static constexpr int SIZE = 256 * 1024 * 1024;
+    return SIZE;
+}
+
+const int &Pool::StorageStruct::ApiMaxRequestLength() const
+{
+    // A JSON object with a handful of short fields; anything larger is not ours
+    static constexpr int LENGTH = 4096;
+    return LENGTH;
+}
+
+const int &Pool::StorageStruct::ApiMailRequestsPerWindow() const
+{
+    // Subscribe / unsubscribe requests per client IP address, each one sends an email
+    static constexpr int COUNT = 5;
+    return COUNT;
+}
+
+const int &Pool::StorageStruct::ApiMailRequestsPerInbox() const
+{
+    // Subscribe / unsubscribe requests per inbox, no matter where they come from
+    static constexpr int COUNT = 2;
+    return COUNT;
+}
+
+const int &Pool::StorageStruct::ApiMailRequestsWindow() const
+{
+    // 10 Minutes * 60 Seconds
+    static constexpr int DURATION = 10 * 60;
+    return DURATION;
+}
+
 Pool::StorageStruct &Pool::Storage()
 {
     /// C++11 specifies it to be thread safe.
@@ -275,7 +396,81 @@ CoreLib::Database &Pool::Database()
                  % trim_copy(std::string(PGSQL_USER))
                  % trim_copy(std::string(PGSQL_PASSWORD))).str());
 #endif  // defined ( PGSQL_CONNECTION_STRING )
-    static CoreLib::Database instance(CONNECTION_STRING);
+
+    static const vector<string> REPLICA_CONNECTION_STRINGS = []() {
+        vector<string> replicas;
+        const string raw(PGSQL_REPLICA_CONNECTION_STRINGS);
+        split(replicas, raw, is_any_of("|"));
+        for (auto &r : replicas) {
+            trim(r);
+        }
+        replicas.erase(std::remove_if(replicas.begin(), replicas.end(),
+                                 [](const string &r) { return r.empty(); }),
+                       replicas.end());
+        return replicas;
+    }();
+
+    static CoreLib::Database instance(CONNECTION_STRING, REPLICA_CONNECTION_STRINGS,
+                                      PGSQL_REPLICA_MAX_LAG_SECONDS);
+
+    return instance;
+}
+
+Service::SettingsCache &Pool::Settings()
+{
+    /// The cache's listener thread relies on the database instance, so make
+    /// sure the database gets constructed first and, therefore, destroyed last.
+    Database();
+
+    static Service::SettingsCache instance;
+
+    return instance;
+}
+
+Service::SessionCache &Pool::Sessions()
+{
+    /// Same as above
+    Database();
+
+    static Service::SessionCache instance;
+
+    return instance;
+}
+
+Service::Janitor &Pool::Janitor()
+{
+    /// Same as above
+    Database();
+
+    static Service::Janitor instance;
+
+    return instance;
+}
+
+Service::Argon2Executor &Pool::Argon2()
+{
+    static Service::Argon2Executor instance;
+
+    return instance;
+}
+
+Service::WorkerPool &Pool::Background()
+{
+    static Service::WorkerPool instance;
+
+    return instance;
+}
+
+Service::WorkerPool &Pool::Validation()
+{
+    static Service::WorkerPool instance;
+
+    return instance;
+}
+
+Service::LocalizedStrings &Pool::Localization()
+{
+    static Service::LocalizedStrings instance;
 
     return instance;
 }
@@ -45,7 +45,13 @@ class Database;
 }
 
 namespace Service {
+class Argon2Executor;
+class Janitor;
+class LocalizedStrings;
 class Pool;
+class SessionCache;
+class SettingsCache;
+class WorkerPool;
 }
 
 class Service::Pool
@@ -55,6 +61,10 @@ public:
     {
         const int &LanguageCookieLifespan() const;
 
+        /// SERVICE_URL without the trailing slash, and its host part
+        const std::string &ServiceUrl() const;
+        const std::string &ServiceHostname() const;
+
         const std::string &RootUsername() const;
         const std::string &RootInitialPassword() const;
         const std::string &RootInitialEmail() const;
@@ -81,12 +91,28 @@ public:
         const std::string &RegexLanguageArray() const;
 
         const int &TokenLifespan() const;
+        const int &ConfirmLinkLifespan() const;
+        const int &UnsubscribeLinkLifespan() const;
 
         const int &MinHomePageTitleLength() const;
         const int &MaxHomePageTitleLength() const;
 
         const int &ResetPwdLifespan() const;
 
+        const int &JanitorInterval() const;
+        const int &JanitorBatchSize() const;
+        const int &ExpiredRootSessionRetention() const;
+        const int &TemporaryRootSessionRetention() const;
+        const int &ExpiredRecoveryTokenRetention() const;
+        const int &UnconfirmedSubscriberRetention() const;
+
+        const int &MaxSubscribersImportSize() const;
+
+        const int &ApiMaxRequestLength() const;
+        const int &ApiMailRequestsPerWindow() const;
+        const int &ApiMailRequestsPerInbox() const;
+        const int &ApiMailRequestsWindow() const;
+
         std::string AppPath;
     };
 
@@ -94,6 +120,13 @@ public:
     static StorageStruct &Storage();
     static CoreLib::Crypto &Crypto();
     static CoreLib::Database &Database();
+    static Service::SettingsCache &Settings();
+    static Service::SessionCache &Sessions();
+    static Service::Janitor &Janitor();
+    static Service::Argon2Executor &Argon2();
+    static Service::WorkerPool &Background();
+    static Service::WorkerPool &Validation();
+    static Service::LocalizedStrings &Localization();
 };
 
 
@@ -61,13 +61,16 @@
 #include <CoreLib/Mail.hpp>
 #include <CoreLib/make_unique.hpp>
 #include <CoreLib/Random.hpp>
+#include "Argon2Executor.hpp"
 #include "Captcha.hpp"
 #include "CgiEnv.hpp"
 #include "CgiRoot.hpp"
 #include "Cms.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "SessionCache.hpp"
 #include "RootLogin.hpp"
+#include "SettingsCache.hpp"
 
 using namespace std;
 using namespace boost;
@@ -97,16 +100,37 @@ public:
     WText *LoginMessageArea;
     WText *PasswordRecoveryMessageArea;
 
+private:
+    struct LoginAttempt
+    {
+        std::string UserId;
+        std::string Username;
+        std::string Email;
+        std::string Password;
+        std::string HashedPwd;
+        std::string HashedRecoveryPwd;
+        std::string EncryptedRecoveryPwd;
+        bool RecoveryPwdValid;
+    };
+
 private:
     RootLogin *m_parent;
 
+    /// Lets the hashing callbacks know whether we are still around
+    std::shared_ptr<bool> LifeToken;
+
 public:
     explicit Impl(RootLogin *parent);
     ~Impl();
 
 public:
     void OnLoginFormSubmitted();
+    void VerifyLoginPassword(const LoginAttempt &attempt, const bool recoveryPwd);
+    void OnLoginPasswordVerified(const LoginAttempt &attempt, const bool recoveryPwd, const bool verified);
+    void OnLoginFailed(const std::string &username);
     void OnPasswordRecoveryFormSubmitted();
+    void OnRecoveryPasswordHashed(const std::string &email, const std::string &pwd,
+                                  const bool succeeded, const std::string &hashedPwd);
 
     void OnGoToHomePageButtonPressed();
     void OnSignInAgainButtonPressed();
@@ -134,6 +158,15 @@ RootLogin::RootLogin()
 
     try {
         if (cgiEnv->GetInformation().Client.Request.Root.Logout) {
+            try {
+                /// Throws if there is no such cookie
+                string token;
+                if (Pool::Crypto().OpenToken(cgiRoot->environment().getCookie("cms-session-token"), token))
+                    Pool::Sessions().Terminate(token);
+            } catch (...) {
+                /// Nothing to terminate
+            }
+
             try {
                 cgiRoot->removeCookie("cms-session-token");
                 LOG_INFO("Root logout request succeed!", cgiEnv->GetInformation().ToJson());
@@ -142,117 +175,108 @@ RootLogin::RootLogin()
             }
             hasValidSession = false;
         } else {
-            string token(cgiRoot->environment().getCookie("cms-session-token"));
-            Pool::Crypto().Decrypt(token, token);
-
-            try {
-                auto conn = Pool::Database().Connection();
-                conn->activate();
-                pqxx::work txn(*conn.get());
-
-                string query((boost::format("SELECT EXTRACT ( EPOCH FROM expiry::TIMESTAMPTZ ) as expiry"
-                                            " FROM \"%1%\" WHERE token = %2%;")
-                              % txn.esc(Service::Pool::Database().GetTableName("ROOT_SESSIONS"))
-                              % txn.quote(token)).str());
-                LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-                result r = txn.exec(query);
-
-                string expiry("0");
-                if (!r.empty()) {
-                    const pqxx::row row(r[0]);
-                    expiry = row["expiry"].c_str();
-                }
-
-                time_t rawTime = lexical_cast<time_t>(expiry);
-
-                CDate::Now n(CDate::Timezone::UTC);
-                if (rawTime >= n.RawTime()) {
-                    try {
-                        query.assign((format("SELECT t1.user_id, t1.username, t1.email,"
-                                             " EXTRACT ( EPOCH FROM t2.login_time::TIMESTAMPTZ ) as login_time,"
-                                             " t2.ip_address, t2.location_country_code, t2.location_country_code3,"
-                                             " t2.location_country_name, t2.location_region, t2.location_city,"
-                                             " t2.location_postal_code, t2.location_latitude, t2.location_longitude,"
-                                             " t2.location_metro_code, t2.location_dma_code, t2.location_area_code,"
-                                             " t2.location_charset, t2.location_continent_code, t2.location_netmask,"
-                                             " t2.location_asn, t2.location_aso, t2.location_raw_data, "
-                                             " t2.user_agent, t2.referer"
-                                             " FROM \"%1%\" t1"
-                                             " INNER JOIN \"%2%\" t2 ON t1.user_id = t2.user_id"
-                                             " WHERE t1.username = %3%"
-                                             " ORDER BY t2.login_time DESC LIMIT 1;")
-                                      % txn.esc(Pool::Database().GetTableName("ROOT"))
-                                      % txn.esc(Pool::Database().GetTableName("ROOT_SESSIONS"))
-                                      % txn.quote(Pool::Storage().RootUsername())).str());
-                        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-                        r = txn.exec(query);
-
-                        if (!r.empty()) {
-                            const pqxx::row row(r[0]);
-
-                            CgiEnv::InformationRecord::ClientRecord::SessionRecord record;
-                            record.UserId = row["user_id"].c_str();
-                            record.Username = row["username"].c_str();
-                            record.Email = row["email"].c_str();
-                            record.LastLogin.Time = lexical_cast<time_t>(row["login_time"].c_str());
-                            record.LastLogin.IPAddress = row["ip_address"].c_str();
-                            record.LastLogin.GeoLocation.CountryCode = row["location_country_code"].c_str();
-                            record.LastLogin.GeoLocation.CountryCode3 = row["location_country_code3"].c_str();
-                            record.LastLogin.GeoLocation.CountryName = row["location_country_name"].c_str();
-                            record.LastLogin.GeoLocation.Region = row["location_region"].c_str();
-                            record.LastLogin.GeoLocation.City = row["location_city"].c_str();
-                            record.LastLogin.GeoLocation.PostalCode = row["location_postal_code"].c_str();
-                            record.LastLogin.GeoLocation.Latitude = lexical_cast<float>(row["location_latitude"].c_str());
-                            record.LastLogin.GeoLocation.Longitude = lexical_cast<float>(row["location_longitude"].c_str());
-                            record.LastLogin.GeoLocation.MetroCode = lexical_cast<int>(row["location_metro_code"].c_str());
-                            record.LastLogin.GeoLocation.DmaCode = lexical_cast<int>(row["location_dma_code"].c_str());
-                            record.LastLogin.GeoLocation.AreaCode = lexical_cast<int>(row["location_area_code"].c_str());
-                            record.LastLogin.GeoLocation.Charset = lexical_cast<int>(row["location_charset"].c_str());
-                            record.LastLogin.GeoLocation.ContinentCode = row["location_continent_code"].c_str();
-                            record.LastLogin.GeoLocation.Netmask = lexical_cast<int>(row["location_netmask"].c_str());
-                            record.LastLogin.GeoLocation.ASN = lexical_cast<int>(row["location_asn"].c_str());
-                            record.LastLogin.GeoLocation.ASO = row["location_aso"].c_str();
-                            record.LastLogin.GeoLocation.RawData = row["location_raw_data"].c_str();
-                            record.LastLogin.UserAgent = row["user_agent"].c_str();
-                            record.LastLogin.Referer = row["referer"].c_str();
-
-                            cgiEnv->SetSessionRecord(record);
-
-                            LOG_INFO("Successful login!", cgiEnv->GetInformation().ToJson());
-
-                            txn.abort();
-
-                            m_pimpl->PreserveSessionData(n, true);
-
-                            m_pimpl->SendLoginAlertEmail(n);
-
-                            hasValidSession = true;
+            /// Forged, mangled or expired cookies are turned away right here,
+            /// without ever hitting the session cache or the database
+            string token;
+            if (!Pool::Crypto().OpenToken(cgiRoot->environment().getCookie("cms-session-token"), token)) {
+                LOG_ERROR("Invalid session!", cgiEnv->GetInformation().ToJson());
+            } else {
+                try {
+                    time_t rawTime = 0;
+                    Pool::Sessions().Lookup(token, rawTime);
+
+                    CDate::Now n(CDate::Timezone::UTC);
+                    if (rawTime >= n.RawTime()) {
+                        try {
+                            auto conn = Pool::Database().Connection();
+                            conn->activate();
+                            pqxx::work txn(*conn.get());
+
+                            string query((format("SELECT t1.user_id, t1.username, t1.email,"
+                                                 " EXTRACT ( EPOCH FROM t2.login_time::TIMESTAMPTZ ) as login_time,"
+                                                 " t2.ip_address, t2.location_country_code, t2.location_country_code3,"
+                                                 " t2.location_country_name, t2.location_region, t2.location_city,"
+                                                 " t2.location_postal_code, t2.location_latitude, t2.location_longitude,"
+                                                 " t2.location_metro_code, t2.location_dma_code, t2.location_area_code,"
+                                                 " t2.location_charset, t2.location_continent_code, t2.location_netmask,"
+                                                 " t2.location_asn, t2.location_aso, t2.location_raw_data, "
+                                                 " t2.user_agent, t2.referer"
+                                                 " FROM \"%1%\" t1"
+                                                 " INNER JOIN \"%2%\" t2 ON t1.user_id = t2.user_id"
+                                                 " WHERE t1.username = %3%"
+                                                 " ORDER BY t2.login_time DESC LIMIT 1;")
+                                          % txn.esc(Pool::Database().GetTableName("ROOT"))
+                                          % txn.esc(Pool::Database().GetTableName("ROOT_SESSIONS"))
+                                          % txn.quote(Pool::Storage().RootUsername())).str());
+                            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+
+                            result r = txn.exec(query);
+
+                            if (!r.empty()) {
+                                const pqxx::row row(r[0]);
+
+                                CgiEnv::InformationRecord::ClientRecord::SessionRecord record;
+                                record.UserId = row["user_id"].c_str();
+                                record.Username = row["username"].c_str();
+                                record.Email = row["email"].c_str();
+                                record.LastLogin.Time = lexical_cast<time_t>(row["login_time"].c_str());
+                                record.LastLogin.IPAddress = row["ip_address"].c_str();
+                                record.LastLogin.GeoLocation.CountryCode = row["location_country_code"].c_str();
+                                record.LastLogin.GeoLocation.CountryCode3 = row["location_country_code3"].c_str();
+                                record.LastLogin.GeoLocation.CountryName = row["location_country_name"].c_str();
+                                record.LastLogin.GeoLocation.Region = row["location_region"].c_str();
+                                record.LastLogin.GeoLocation.City = row["location_city"].c_str();
+                                record.LastLogin.GeoLocation.PostalCode = row["location_postal_code"].c_str();
+                                record.LastLogin.GeoLocation.Latitude = lexical_cast<float>(row["location_latitude"].c_str());
+                                record.LastLogin.GeoLocation.Longitude = lexical_cast<float>(row["location_longitude"].c_str());
+                                record.LastLogin.GeoLocation.MetroCode = lexical_cast<int>(row["location_metro_code"].c_str());
+                                record.LastLogin.GeoLocation.DmaCode = lexical_cast<int>(row["location_dma_code"].c_str());
+                                record.LastLogin.GeoLocation.AreaCode = lexical_cast<int>(row["location_area_code"].c_str());
+                                record.LastLogin.GeoLocation.Charset = lexical_cast<int>(row["location_charset"].c_str());
+                                record.LastLogin.GeoLocation.ContinentCode = row["location_continent_code"].c_str();
+                                record.LastLogin.GeoLocation.Netmask = lexical_cast<int>(row["location_netmask"].c_str());
+                                record.LastLogin.GeoLocation.ASN = lexical_cast<int>(row["location_asn"].c_str());
+                                record.LastLogin.GeoLocation.ASO = row["location_aso"].c_str();
+                                record.LastLogin.GeoLocation.RawData = row["location_raw_data"].c_str();
+                                record.LastLogin.UserAgent = row["user_agent"].c_str();
+                                record.LastLogin.Referer = row["referer"].c_str();
+
+                                cgiEnv->SetSessionRecord(record);
+
+                                LOG_INFO("Successful login!", cgiEnv->GetInformation().ToJson());
+
+                                txn.abort();
+
+                                m_pimpl->PreserveSessionData(n, true);
+
+                                m_pimpl->SendLoginAlertEmail(n);
+
+                                hasValidSession = true;
+                            }
                         }
-                    }
 
-                    catch (const pqxx::sql_error &ex) {
-                        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
-                    }
+                        catch (const pqxx::sql_error &ex) {
+                            LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
+                        }
 
-                    catch (const boost::exception &ex) {
-                        LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
-                    }
+                        catch (const boost::exception &ex) {
+                            LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
+                        }
 
-                    catch (const std::exception &ex) {
-                        LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
-                    }
+                        catch (const std::exception &ex) {
+                            LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
+                        }
 
-                    catch (...) {
-                        LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
+                        catch (...) {
+                            LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
+                        }
                     }
                 }
-            }
 
-            catch (...) {
-                /// Invalid session!
-                LOG_ERROR("Invalid session!", cgiEnv->GetInformation().ToJson());
+                catch (...) {
+                    /// Invalid session!
+                    LOG_ERROR("Invalid session!", cgiEnv->GetInformation().ToJson());
+                }
             }
         }
     }
@@ -402,7 +426,8 @@ WWidget *RootLogin::Layout()
 }
 
 RootLogin::Impl::Impl(RootLogin *parent)
-    : m_parent(parent)
+    : m_parent(parent),
+      LifeToken(std::make_shared<bool>(true))
 {
     PasswordRecoveryFormFlag = false;
 }
@@ -422,38 +447,44 @@ void RootLogin::Impl::OnLoginFormSubmitted()
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
+        LoginAttempt attempt;
+        attempt.Username = UsernameLineEdit->text().toUTF8();
+        attempt.Password = PasswordLineEdit->text().toUTF8();
+        attempt.RecoveryPwdValid = false;
+
+        {
+            auto conn = Pool::Database().Connection();
+            conn->activate();
+            pqxx::work txn(*conn.get());
+
+            string query((format("SELECT t1.user_id, t1.username, t1.email, t2.pwd, t3.new_pwd,"
+                                 " EXTRACT ( EPOCH FROM t3.expiry::TIMESTAMPTZ ) as expiry"
+                                 " FROM \"%1%\" t1"
+                                 " INNER JOIN \"%2%\" t2 ON t1.user_id = t2.user_id"
+                                 " LEFT OUTER JOIN \"%3%\" t3 ON t1.user_id = t3.user_id"
+                                 " WHERE t1.username = %4%"
+                                 " ORDER BY t3.request_time DESC LIMIT 1;")
+                          % txn.esc(Pool::Database().GetTableName("ROOT"))
+                          % txn.esc(Pool::Database().GetTableName("ROOT_CREDENTIALS"))
+                          % txn.esc(Pool::Database().GetTableName("ROOT_CREDENTIALS_RECOVERY"))
+                          % txn.quote(attempt.Username)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        string userId;
-        string username = UsernameLineEdit->text().toUTF8();
-        string email;
-        bool success = false;
-
-        string query((format("SELECT t1.user_id, t1.username, t1.email, t2.pwd, t3.new_pwd,"
-                             " EXTRACT ( EPOCH FROM t3.expiry::TIMESTAMPTZ ) as expiry"
-                             " FROM \"%1%\" t1"
-                             " INNER JOIN \"%2%\" t2 ON t1.user_id = t2.user_id"
-                             " LEFT OUTER JOIN \"%3%\" t3 ON t1.user_id = t3.user_id"
-                             " WHERE t1.username = %4%"
-                             " ORDER BY t3.request_time DESC LIMIT 1;")
-                      % txn.esc(Pool::Database().GetTableName("ROOT"))
-                      % txn.esc(Pool::Database().GetTableName("ROOT_CREDENTIALS"))
-                      % txn.esc(Pool::Database().GetTableName("ROOT_CREDENTIALS_RECOVERY"))
-                      % txn.quote(username)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+            result r = txn.exec(query);
 
-        result r = txn.exec(query);
+            if (r.empty()) {
+                LOG_ERROR("Login query does not match!", attempt.Username, cgiEnv->GetInformation().ToJson());
+                OnLoginFailed(attempt.Username);
+                return;
+            }
 
-        if (!r.empty()) {
             const pqxx::row row(r[0]);
 
-            userId = row["user_id"].c_str();
-            username = row["username"].c_str();
-            email = row["email"].c_str();
+            attempt.UserId = row["user_id"].c_str();
+            attempt.Username = row["username"].c_str();
+            attempt.Email = row["email"].c_str();
             string encryptedPwd(row["pwd"].c_str());
-            string encryptedRecoveryPwd(row["new_pwd"].c_str());
+            attempt.EncryptedRecoveryPwd = row["new_pwd"].c_str();
 
             time_t expiry = 0;
             try {
@@ -461,85 +492,144 @@ void RootLogin::Impl::OnLoginFormSubmitted()
             } catch (...) {
             }
 
-            string hashedPwd;
-            string hashedRecoveryPwd;
-            Pool::Crypto().Decrypt(encryptedPwd, hashedPwd);
-            Pool::Crypto().Decrypt(encryptedRecoveryPwd, hashedRecoveryPwd);
+            Pool::Crypto().Decrypt(encryptedPwd, attempt.HashedPwd);
+            Pool::Crypto().Decrypt(attempt.EncryptedRecoveryPwd, attempt.HashedRecoveryPwd);
 
             CDate::Now n(CDate::Timezone::UTC);
-
-            if (Pool::Crypto().Argon2iVerify(PasswordLineEdit->text().toUTF8(), hashedPwd)) {
-                success = true;
-                LOG_INFO("Legit login password!", username, cgiEnv->GetInformation().ToJson());
-            } else if (expiry >= n.RawTime() && Pool::Crypto().Argon2iVerify(PasswordLineEdit->text().toUTF8(), hashedRecoveryPwd)) {
-                success = true;
-                LOG_INFO("Legit recovery password!", username, cgiEnv->GetInformation().ToJson());
-
-                query.assign((boost::format("UPDATE ONLY \"%1%\""
-                                            " SET expiry = '19700101'::TIMESTAMPTZ,"
-                                            " utilization_time = TO_TIMESTAMP( %2% )::TIMESTAMPTZ, utilization_ip_address = %3%,"
-                                            " utilization_location_country_code = %4%, utilization_location_country_code3 = %5%,"
-                                            " utilization_location_country_name = %6%, utilization_location_region = %7%,"
-                                            " utilization_location_city = %8%, utilization_location_postal_code = %9%,"
-                                            " utilization_location_latitude = %10%, utilization_location_longitude = %11%,"
-                                            " utilization_location_metro_code = %12%, utilization_location_dma_code = %13%,"
-                                            " utilization_location_area_code = %14%, utilization_location_charset = %15%,"
-                                            " utilization_location_continent_code = %16%, utilization_location_netmask = %17%,"
-                                            " utilization_location_asn = %18%, utilization_location_aso = %19%,"
-                                            " utilization_location_raw_data = %20%,"
-                                            " utilization_user_agent = %21%, utilization_referer = %22%"
-                                            " WHERE user_id = %23%;")
-                              % txn.esc(Service::Pool::Database().GetTableName("ROOT_CREDENTIALS_RECOVERY"))
-                              % txn.esc(lexical_cast<string>(n.RawTime()))
-                              % txn.quote(cgiEnv->GetInformation().Client.IPAddress)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.CountryCode)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.CountryCode3)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.CountryName)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.Region)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.City)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.PostalCode)
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Latitude))
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Longitude))
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.MetroCode))
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.DmaCode))
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.AreaCode))
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Charset))
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.ContinentCode)
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Netmask))
-                              % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.ASN))
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.ASO)
-                              % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.RawData)
-                              % txn.quote(cgiEnv->GetInformation().Client.UserAgent)
-                              % txn.quote(cgiEnv->GetInformation().Client.Referer)
-                              % txn.quote(userId)).str());
-                LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-                r = txn.exec(query);
-
-                Pool::Database().Update("ROOT_CREDENTIALS",
-                                         "user_id", userId,
-                                         "pwd=?",
-                                        { encryptedRecoveryPwd });
-            }
-        } else {
-            LOG_ERROR("Login query does not match!", username, cgiEnv->GetInformation().ToJson());
+            attempt.RecoveryPwdValid = expiry >= n.RawTime();
         }
 
-        if (!success) {
-            LOG_ERROR("Login failed!", username, cgiEnv->GetInformation().ToJson());
-            txn.abort();
-            m_parent->HtmlError(tr("root-login-fail"), LoginMessageArea);
-            UsernameLineEdit->setFocus();
-            GenerateCaptcha();
+        VerifyLoginPassword(attempt, false);
+
+        return;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
+    }
+
+    LOG_ERROR("Internal server error!", cgiEnv->GetInformation().ToJson());
+    m_parent->HtmlError(tr("internal-server-error"), LoginMessageArea);
+    ForgotPassword_EmailLineEdit->setFocus();
+    GenerateCaptcha();
+}
+
+void RootLogin::Impl::VerifyLoginPassword(const LoginAttempt &attempt, const bool recoveryPwd)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    const std::weak_ptr<bool> lifeToken(LifeToken);
+    RootLogin::Impl *self = this;
+
+    if (!Pool::Argon2().Verify(attempt.Password,
+                               recoveryPwd ? attempt.HashedRecoveryPwd : attempt.HashedPwd,
+                               [=](const bool verified) {
+                                   if (!lifeToken.expired())
+                                       self->OnLoginPasswordVerified(attempt, recoveryPwd, verified);
+                               })) {
+        LOG_ERROR("Password hashing is too busy!", attempt.Username, cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("password-hashing-busy-error"), LoginMessageArea);
+        GenerateCaptcha();
+    }
+}
+
+void RootLogin::Impl::OnLoginPasswordVerified(const LoginAttempt &attempt, const bool recoveryPwd,
+                                              const bool verified)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    if (!verified) {
+        if (!recoveryPwd && attempt.RecoveryPwdValid) {
+            VerifyLoginPassword(attempt, true);
             return;
         }
 
+        OnLoginFailed(attempt.Username);
+        return;
+    }
+
+    if (!recoveryPwd) {
+        LOG_INFO("Legit login password!", attempt.Username, cgiEnv->GetInformation().ToJson());
+    } else {
+        LOG_INFO("Legit recovery password!", attempt.Username, cgiEnv->GetInformation().ToJson());
+    }
+
+    try {
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
         CDate::Now n(CDate::Timezone::UTC);
 
+        string query;
+        result r;
+
+        if (recoveryPwd) {
+            query.assign((boost::format("UPDATE ONLY \"%1%\""
+                                        " SET expiry = '19700101'::TIMESTAMPTZ,"
+                                        " utilization_time = TO_TIMESTAMP( %2% )::TIMESTAMPTZ, utilization_ip_address = %3%,"
+                                        " utilization_location_country_code = %4%, utilization_location_country_code3 = %5%,"
+                                        " utilization_location_country_name = %6%, utilization_location_region = %7%,"
+                                        " utilization_location_city = %8%, utilization_location_postal_code = %9%,"
+                                        " utilization_location_latitude = %10%, utilization_location_longitude = %11%,"
+                                        " utilization_location_metro_code = %12%, utilization_location_dma_code = %13%,"
+                                        " utilization_location_area_code = %14%, utilization_location_charset = %15%,"
+                                        " utilization_location_continent_code = %16%, utilization_location_netmask = %17%,"
+                                        " utilization_location_asn = %18%, utilization_location_aso = %19%,"
+                                        " utilization_location_raw_data = %20%,"
+                                        " utilization_user_agent = %21%, utilization_referer = %22%"
+                                        " WHERE user_id = %23%;")
+                          % txn.esc(Service::Pool::Database().GetTableName("ROOT_CREDENTIALS_RECOVERY"))
+                          % txn.esc(lexical_cast<string>(n.RawTime()))
+                          % txn.quote(cgiEnv->GetInformation().Client.IPAddress)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.CountryCode)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.CountryCode3)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.CountryName)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.Region)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.City)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.PostalCode)
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Latitude))
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Longitude))
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.MetroCode))
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.DmaCode))
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.AreaCode))
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Charset))
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.ContinentCode)
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Netmask))
+                          % txn.quote(lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.ASN))
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.ASO)
+                          % txn.quote(cgiEnv->GetInformation().Client.GeoLocation.RawData)
+                          % txn.quote(cgiEnv->GetInformation().Client.UserAgent)
+                          % txn.quote(cgiEnv->GetInformation().Client.Referer)
+                          % txn.quote(attempt.UserId)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+
+            r = txn.exec(query);
+
+            Pool::Database().Update("ROOT_CREDENTIALS",
+                                    "user_id", attempt.UserId,
+                                    "pwd=?",
+                                    { attempt.EncryptedRecoveryPwd });
+        }
+
         CgiEnv::InformationRecord::ClientRecord::SessionRecord record;
-        record.UserId = userId;
-        record.Username = username;
-        record.Email = email;
+        record.UserId = attempt.UserId;
+        record.Username = attempt.Username;
+        record.Email = attempt.Email;
 
         try {
             query.assign((format("SELECT t1.email,"
@@ -557,7 +647,7 @@ void RootLogin::Impl::OnLoginFormSubmitted()
                                  " ORDER BY t2.login_time DESC LIMIT 1;")
                           % txn.esc(Pool::Database().GetTableName("ROOT"))
                           % txn.esc(Pool::Database().GetTableName("ROOT_SESSIONS"))
-                          % txn.quote(userId)).str());
+                          % txn.quote(attempt.UserId)).str());
             LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
             r = txn.exec(query);
@@ -644,6 +734,17 @@ void RootLogin::Impl::OnLoginFormSubmitted()
     GenerateCaptcha();
 }
 
+void RootLogin::Impl::OnLoginFailed(const std::string &username)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    LOG_ERROR("Login failed!", username, cgiEnv->GetInformation().ToJson());
+    m_parent->HtmlError(tr("root-login-fail"), LoginMessageArea);
+    UsernameLineEdit->setFocus();
+    GenerateCaptcha();
+}
+
 void RootLogin::Impl::OnPasswordRecoveryFormSubmitted()
 {
     if (!m_parent->Validate(ForgotPassword_CaptchaLineEdit)
@@ -655,13 +756,49 @@ void RootLogin::Impl::OnPasswordRecoveryFormSubmitted()
     CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
+    const string email(ForgotPassword_EmailLineEdit->text().toUTF8());
+
+    LOG_INFO("Generating a new password...", email, cgiEnv->GetInformation().ToJson());
+
+    string pwd;
+    Random::Characters(Random::Character::Alphanumeric,
+                       static_cast<size_t>(Pool::Storage().MaxPasswordLength()), pwd);
+
+    const std::weak_ptr<bool> lifeToken(LifeToken);
+    RootLogin::Impl *self = this;
+
+    if (!Pool::Argon2().Hash(pwd,
+                             CoreLib::Crypto::Argon2iOpsLimit::Interactive,
+                             CoreLib::Crypto::Argon2iMemLimit::Interactive,
+                             [=](const bool succeeded, const std::string &hashedPwd) {
+                                 if (!lifeToken.expired())
+                                     self->OnRecoveryPasswordHashed(email, pwd, succeeded, hashedPwd);
+                             })) {
+        LOG_ERROR("Password hashing is too busy!", email, cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("password-hashing-busy-error"), PasswordRecoveryMessageArea);
+        GenerateCaptcha();
+    }
+}
+
+void RootLogin::Impl::OnRecoveryPasswordHashed(const std::string &email, const std::string &pwd,
+                                               const bool succeeded, const std::string &hashedPwd)
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    if (!succeeded) {
+        LOG_ERROR("Password hashing failed!", email, cgiEnv->GetInformation().ToJson());
+        m_parent->HtmlError(tr("internal-server-error"), PasswordRecoveryMessageArea);
+        ForgotPassword_EmailLineEdit->setFocus();
+        GenerateCaptcha();
+        return;
+    }
+
     auto conn = Pool::Database().Connection();
     conn->activate();
     pqxx::work txn(*conn.get());
 
     try {
-        string email(ForgotPassword_EmailLineEdit->text().toUTF8());
-
         string query((boost::format("SELECT user_id, username FROM \"%1%\" WHERE email = %2%;")
                       % txn.esc(Service::Pool::Database().GetTableName("ROOT"))
                       % txn.quote(email)).str());
@@ -684,16 +821,8 @@ void RootLogin::Impl::OnPasswordRecoveryFormSubmitted()
         string userId(row["user_id"].c_str());
         string username(row["username"].c_str());
 
-        LOG_INFO("Generating a new password...", email, username, cgiEnv->GetInformation().ToJson());
-
-        string pwd;
         string encryptedPwd;
-        Random::Characters(Random::Character::Alphanumeric,
-                           static_cast<size_t>(Pool::Storage().MaxPasswordLength()), pwd);
-        Pool::Crypto().Argon2i(pwd, encryptedPwd,
-                                CoreLib::Crypto::Argon2iOpsLimit::Interactive,
-                                CoreLib::Crypto::Argon2iMemLimit::Interactive);
-        Pool::Crypto().Encrypt(encryptedPwd, encryptedPwd);
+        Pool::Crypto().Encrypt(hashedPwd, encryptedPwd);
 
         string token;
         while (true) {
@@ -791,31 +920,14 @@ void RootLogin::Impl::OnGoToHomePageButtonPressed()
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        string homePageFields;
+        SettingsCache::SnapshotPtr settings(Pool::Settings().Get());
 
+        string homePageUrl;
         if (cgiEnv->GetInformation().Client.Language.Code
                 == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-            homePageFields = "homepage_url_fa";
+            homePageUrl.assign(settings->HomePageUrlFa);
         } else {
-            homePageFields = "homepage_url_en";
-        }
-
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        string query((boost::format("SELECT %1% FROM \"%2%\""
-                                    " WHERE pseudo_id = '0';")
-                      % homePageFields
-                      % txn.esc(Service::Pool::Database().GetTableName("SETTINGS"))).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-        result r = txn.exec(query);
-
-        string homePageUrl;
-        if (!r.empty()) {
-            const pqxx::row row(r[0]);
-            homePageUrl.assign(row[0].c_str());
+            homePageUrl.assign(settings->HomePageUrlEn);
         }
 
         cgiRoot->Exit(homePageUrl);
@@ -1004,12 +1116,15 @@ void RootLogin::Impl::PreserveSessionData(const CDate::Now &n, const bool saveLo
 
         txn.commit();
 
+        Pool::Sessions().Put(token, expiry);
+
         if (saveLocally) {
-            Pool::Crypto().Encrypt(token, token);
+            string cookie;
+            Pool::Crypto().SealToken(token, expiry, cookie);
 
             if (cgiRoot->environment().supportsCookies()) {
                 cgiRoot->setCookie("cms-session-token",
-                                   token,
+                                   cookie,
                                    Pool::Storage().RootSessionLifespan());
                 LOG_ERROR("Saved session token on client!", cgiEnv->GetInformation().ToJson(););
             } else {
@@ -1058,9 +1173,7 @@ void RootLogin::Impl::SendLoginAlertEmail(const CDate::Now &n)
         replace_all(htmlData, "${client-referer}",
                     cgiEnv->GetInformation().Client.Referer);
         replace_all(htmlData, "${time}",
-                    (format("%1% ~ %2%")
-                     % WString(DateConv::FormatToPersianNums(DateConv::ToJalali(n))).toUTF8()
-                     % algorithm::trim_copy(DateConv::DateTimeString(n))).str());
+                    DateConv::PersianTimeStamp(n));
         replace_all(htmlData, "${client-location-country-code}",
                     cgiEnv->GetInformation().Client.GeoLocation.CountryCode);
         replace_all(htmlData, "${client-location-country-name}",
@@ -1127,7 +1240,7 @@ void RootLogin::Impl::SendPasswordRecoveryEmail(const std::string &email,
         replace_all(htmlData, "${client-referer}",
                     cgiEnv->GetInformation().Client.Referer);
         replace_all(htmlData, "${time}",
-                    algorithm::trim_copy(DateConv::DateTimeString(n)));
+                    DateConv::TimeStamp(n));
         replace_all(htmlData, "${client-location-country-code}",
                     cgiEnv->GetInformation().Client.GeoLocation.CountryCode);
         replace_all(htmlData, "${client-location-country-name}",
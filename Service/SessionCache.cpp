@@ -0,0 +1,291 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A process-wide cache of root session expiries keyed by session token,
+ * kept coherent across all service processes through PostgreSQL
+ * LISTEN/NOTIFY.
+ */
+
+
+#include <cstdint>
+#include <unordered_map>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <pqxx/pqxx>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "Pool.hpp"
+#include "SessionCache.hpp"
+
+#define     MAX_CACHED_SESSIONS     4096
+
+using namespace std;
+using namespace boost;
+using namespace Service;
+
+struct SessionCache::Impl
+{
+public:
+    typedef std::unordered_map<std::string, std::time_t> ExpiriesHashTable;
+
+public:
+    ExpiriesHashTable Expiries;
+    boost::mutex ExpiriesMutex;
+
+    /// Bumped on every drop; a lookup that raced with one must not put back
+    /// what it read before the session got killed
+    uint_fast64_t Generation;
+
+    bool Listening;
+    CoreLib::Database::ListenerId ListenerId;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    void Store(const std::string &token, const std::time_t expiry);
+    void Store(const std::string &token, const std::time_t expiry, const uint_fast64_t generation);
+    void Drop(const std::string &token);
+};
+
+const std::string &SessionCache::Channel()
+{
+    static const string CHANNEL("root_sessions_changed");
+    return CHANNEL;
+}
+
+SessionCache::SessionCache()
+    : m_pimpl(make_unique<SessionCache::Impl>())
+{
+
+}
+
+SessionCache::~SessionCache()
+{
+    if (m_pimpl->Listening) {
+        Pool::Database().Unlisten(m_pimpl->ListenerId);
+    }
+}
+
+bool SessionCache::Initialize()
+{
+    LOG_INFO("Initializing Service::SessionCache...");
+
+    if (!m_pimpl->Listening) {
+        /// An empty payload also arrives once the channel has been
+        /// (re-)subscribed, so anything missed in the meantime gets dropped
+        m_pimpl->ListenerId = Pool::Database().Listen(
+                    SessionCache::Channel(),
+                    [this](const std::string &channel, const std::string &payload) {
+            (void)channel;
+            m_pimpl->Drop(payload);
+        });
+        m_pimpl->Listening = true;
+    }
+
+    LOG_INFO("Service::SessionCache initialized successfully!");
+
+    return true;
+}
+
+bool SessionCache::Lookup(const std::string &token, std::time_t &out_expiry)
+{
+    uint_fast64_t generation;
+
+    {
+        boost::lock_guard<boost::mutex> lock(m_pimpl->ExpiriesMutex);
+        (void)lock;
+
+        auto it = m_pimpl->Expiries.find(token);
+        if (it != m_pimpl->Expiries.end()) {
+            out_expiry = it->second;
+            return true;
+        }
+
+        generation = m_pimpl->Generation;
+    }
+
+    try {
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        string query((boost::format("SELECT EXTRACT ( EPOCH FROM expiry::TIMESTAMPTZ )::BIGINT AS expiry FROM \"%1%\""
+                                    " WHERE token = %2%;")
+                      % txn.esc(Pool::Database().GetTableName("ROOT_SESSIONS"))
+                      % txn.quote(token)).str());
+
+        pqxx::result r = txn.exec(query);
+
+        txn.commit();
+
+        if (r.empty()) {
+            /// Not worth caching; tokens come from cookies, anyone can make
+            /// them up
+            out_expiry = 0;
+            return true;
+        }
+
+        out_expiry = r[0]["expiry"].as<std::time_t>();
+
+        m_pimpl->Store(token, out_expiry, generation);
+
+        return true;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+void SessionCache::Put(const std::string &token, const std::time_t expiry)
+{
+    m_pimpl->Store(token, expiry);
+}
+
+bool SessionCache::Terminate(const std::string &token)
+{
+    try {
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        /// expiry == 0 --> force exit the session
+        string query((boost::format("UPDATE ONLY \"%1%\""
+                                    " SET expiry = '19700101'::TIMESTAMPTZ"
+                                    " WHERE token = %2% AND expiry > '19700101'::TIMESTAMPTZ;")
+                      % txn.esc(Pool::Database().GetTableName("ROOT_SESSIONS"))
+                      % txn.quote(token)).str());
+        LOG_INFO("Running query...", query);
+
+        txn.exec(query);
+
+        Invalidate(txn, token);
+
+        txn.commit();
+
+        return true;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+void SessionCache::Invalidate(pqxx::transaction_base &txn, const std::string &token)
+{
+    Pool::Database().Notify(txn, SessionCache::Channel(), token);
+}
+
+SessionCache::Impl::Impl()
+    : Generation(0),
+      Listening(false),
+      ListenerId(0)
+{
+
+}
+
+SessionCache::Impl::~Impl() = default;
+
+void SessionCache::Impl::Store(const std::string &token, const std::time_t expiry)
+{
+    boost::lock_guard<boost::mutex> lock(ExpiriesMutex);
+    (void)lock;
+
+    if (Expiries.size() >= MAX_CACHED_SESSIONS) {
+        Expiries.clear();
+    }
+
+    Expiries[token] = expiry;
+}
+
+void SessionCache::Impl::Store(const std::string &token, const std::time_t expiry, const uint_fast64_t generation)
+{
+    boost::lock_guard<boost::mutex> lock(ExpiriesMutex);
+    (void)lock;
+
+    /// Whatever got dropped in the meantime may well be this very session;
+    /// the next lookup reads it again
+    if (generation != Generation)
+        return;
+
+    if (Expiries.size() >= MAX_CACHED_SESSIONS) {
+        Expiries.clear();
+    }
+
+    Expiries[token] = expiry;
+}
+
+void SessionCache::Impl::Drop(const std::string &token)
+{
+    boost::lock_guard<boost::mutex> lock(ExpiriesMutex);
+    (void)lock;
+
+    ++Generation;
+
+    if (token.empty()) {
+        Expiries.clear();
+    } else {
+        Expiries.erase(token);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A process-wide cache of root session expiries keyed by session token,
+ * kept coherent across all service processes through PostgreSQL
+ * LISTEN/NOTIFY.
+ */
+
+
+#ifndef SERVICE_SESSION_CACHE_HPP
+#define SERVICE_SESSION_CACHE_HPP
+
+
+#include <memory>
+#include <string>
+#include <ctime>
+
+namespace pqxx {
+class transaction_base;
+}
+
+namespace Service {
+class SessionCache;
+}
+
+class Service::SessionCache
+{
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    static const std::string &Channel();
+
+public:
+    SessionCache();
+    virtual ~SessionCache();
+
+public:
+    bool Initialize();
+
+    /// An expiry of 0 means either an unknown token or a session that has
+    /// been forcefully terminated; returns false if the lookup itself failed
+    bool Lookup(const std::string &token, std::time_t &out_expiry);
+
+    /// Primes the cache with a freshly created session
+    void Put(const std::string &token, const std::time_t expiry);
+
+    /// Terminates a single session, e.g. on logout
+    bool Terminate(const std::string &token);
+
+    /// Drops the given token, or every token if empty, in every process once
+    /// the transaction commits
+    void Invalidate(pqxx::transaction_base &txn, const std::string &token = "");
+};
+
+
+#endif /* SERVICE_SESSION_CACHE_HPP */
@@ -0,0 +1,185 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * An in-process cache of the settings table which gets invalidated across
+ * all service processes through PostgreSQL LISTEN/NOTIFY.
+ */
+
+
+#include <atomic>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <pqxx/pqxx>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "Pool.hpp"
+#include "SettingsCache.hpp"
+
+using namespace std;
+using namespace boost;
+using namespace Service;
+
+struct SettingsCache::Impl
+{
+public:
+    /// Always accessed through std::atomic_load / std::atomic_store
+    SnapshotPtr Settings;
+
+    bool Listening;
+    CoreLib::Database::ListenerId ListenerId;
+
+public:
+    Impl();
+    ~Impl();
+};
+
+const std::string &SettingsCache::Channel()
+{
+    static const string CHANNEL("settings_changed");
+    return CHANNEL;
+}
+
+SettingsCache::SettingsCache()
+    : m_pimpl(make_unique<SettingsCache::Impl>())
+{
+
+}
+
+SettingsCache::~SettingsCache()
+{
+    if (m_pimpl->Listening) {
+        Pool::Database().Unlisten(m_pimpl->ListenerId);
+    }
+}
+
+bool SettingsCache::Initialize()
+{
+    LOG_INFO("Initializing Service::SettingsCache...");
+
+    bool rc = Refresh();
+
+    if (!m_pimpl->Listening) {
+        /// Also fires once the channel has been (re-)subscribed, which covers
+        /// whatever we have missed while we were not listening.
+        m_pimpl->ListenerId = Pool::Database().Listen(
+                    SettingsCache::Channel(),
+                    [this](const std::string &channel, const std::string &payload) {
+            (void)channel;
+            (void)payload;
+            this->Refresh();
+        });
+        m_pimpl->Listening = true;
+    }
+
+    LOG_INFO("Service::SettingsCache initialized successfully!");
+
+    return rc;
+}
+
+SettingsCache::SnapshotPtr SettingsCache::Get() const
+{
+    SnapshotPtr settings(std::atomic_load(&m_pimpl->Settings));
+
+    if (!settings) {
+        /// Initialize() has not been called yet or the database is unreachable
+        auto defaults = std::make_shared<Snapshot>();
+        defaults->HomePageUrlEn.assign(INITAL_EN_HOME_PAGE_URL);
+        defaults->HomePageUrlFa.assign(INITAL_FA_HOME_PAGE_URL);
+        defaults->HomePageTitleEn.assign(INITAL_EN_HOME_PAGE_TITLE);
+        defaults->HomePageTitleFa.assign(INITAL_FA_HOME_PAGE_TITLE);
+        settings = defaults;
+    }
+
+    return settings;
+}
+
+bool SettingsCache::Refresh()
+{
+    try {
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        string query((boost::format("SELECT homepage_url_en, homepage_url_fa, homepage_title_en, homepage_title_fa"
+                                    " FROM \"%1%\" WHERE pseudo_id = '0';")
+                      % txn.esc(Pool::Database().GetTableName("SETTINGS"))).str());
+        LOG_INFO("Running query...", query);
+
+        pqxx::result r = txn.exec(query);
+
+        auto settings = std::make_shared<Snapshot>();
+
+        if (!r.empty()) {
+            const pqxx::row row(r[0]);
+            settings->HomePageUrlEn.assign(row["homepage_url_en"].c_str());
+            settings->HomePageUrlFa.assign(row["homepage_url_fa"].c_str());
+            settings->HomePageTitleEn.assign(row["homepage_title_en"].c_str());
+            settings->HomePageTitleFa.assign(row["homepage_title_fa"].c_str());
+        } else {
+            settings->HomePageUrlEn.assign(INITAL_EN_HOME_PAGE_URL);
+            settings->HomePageUrlFa.assign(INITAL_FA_HOME_PAGE_URL);
+            settings->HomePageTitleEn.assign(INITAL_EN_HOME_PAGE_TITLE);
+            settings->HomePageTitleFa.assign(INITAL_FA_HOME_PAGE_TITLE);
+        }
+
+        std::atomic_store(&m_pimpl->Settings, SnapshotPtr(settings));
+
+        return true;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+SettingsCache::Impl::Impl()
+    : Listening(false),
+      ListenerId(0)
+{
+
+}
+
+SettingsCache::Impl::~Impl() = default;
@@ -0,0 +1,81 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * An in-process cache of the settings table which gets invalidated across
+ * all service processes through PostgreSQL LISTEN/NOTIFY.
+ */
+
+
+#ifndef SERVICE_SETTINGS_CACHE_HPP
+#define SERVICE_SETTINGS_CACHE_HPP
+
+
+#include <memory>
+#include <string>
+
+namespace Service {
+class SettingsCache;
+}
+
+class Service::SettingsCache
+{
+public:
+    struct Snapshot
+    {
+        std::string HomePageUrlEn;
+        std::string HomePageUrlFa;
+        std::string HomePageTitleEn;
+        std::string HomePageTitleFa;
+    };
+
+    typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    static const std::string &Channel();
+
+public:
+    SettingsCache();
+    virtual ~SettingsCache();
+
+public:
+    bool Initialize();
+
+    SnapshotPtr Get() const;
+
+    bool Refresh();
+};
+
+
+#endif /* SERVICE_SETTINGS_CACHE_HPP */
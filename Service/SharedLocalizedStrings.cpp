@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A single Wt::WMessageResourceBundle shared by all sessions, so the message
+ * bundles are parsed once per process rather than once per session, and
+ * resolve exactly the way a per-session bundle would.
+ */
+
+
+#include <atomic>
+#include <Wt/WMessageResourceBundle>
+#include <CoreLib/make_unique.hpp>
+#include "SharedLocalizedStrings.hpp"
+
+using namespace std;
+using namespace Wt;
+using namespace Service;
+
+struct SharedLocalizedStrings::Impl
+{
+public:
+    std::string Path;
+
+    /// Always accessed through std::atomic_load / std::atomic_store;
+    /// WMessageResourceBundle serializes its own lookups
+    std::shared_ptr<Wt::WMessageResourceBundle> Bundle;
+
+public:
+    Impl();
+    ~Impl();
+};
+
+SharedLocalizedStrings::SharedLocalizedStrings(const std::string &path)
+    : WLocalizedStrings(),
+      m_pimpl(make_unique<SharedLocalizedStrings::Impl>())
+{
+    m_pimpl->Path = path;
+    Reload();
+}
+
+SharedLocalizedStrings::~SharedLocalizedStrings() = default;
+
+void SharedLocalizedStrings::Reload()
+{
+    auto bundle = std::make_shared<WMessageResourceBundle>();
+    bundle->use(m_pimpl->Path);
+
+    std::atomic_store(&m_pimpl->Bundle, bundle);
+}
+
+bool SharedLocalizedStrings::resolveKey(const std::string &key, std::string &result)
+{
+    std::shared_ptr<WMessageResourceBundle> bundle(std::atomic_load(&m_pimpl->Bundle));
+
+    return bundle->resolveKey(key, result);
+}
+
+SharedLocalizedStrings::Impl::Impl()
+{
+
+}
+
+SharedLocalizedStrings::Impl::~Impl() = default;
@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A single Wt::WMessageResourceBundle shared by all sessions, so the message
+ * bundles are parsed once per process rather than once per session, and
+ * resolve exactly the way a per-session bundle would.
+ */
+
+
+#ifndef SERVICE_SHARED_LOCALIZED_STRINGS_HPP
+#define SERVICE_SHARED_LOCALIZED_STRINGS_HPP
+
+
+#include <memory>
+#include <string>
+#include <Wt/WLocalizedStrings>
+
+namespace Service {
+class SharedLocalizedStrings;
+}
+
+class Service::SharedLocalizedStrings : public Wt::WLocalizedStrings
+{
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    /// Takes the same path as Wt::WMessageResourceBundle::use()
+    explicit SharedLocalizedStrings(const std::string &path);
+    virtual ~SharedLocalizedStrings();
+
+public:
+    /// Starts over with a fresh bundle; lookups already in flight finish on
+    /// the previous one
+    void Reload();
+
+    /// Called concurrently from all sessions, in the locale of the current
+    /// application
+    virtual bool resolveKey(const std::string &key, std::string &result) override;
+};
+
+
+#endif /* SERVICE_SHARED_LOCALIZED_STRINGS_HPP */
@@ -0,0 +1,570 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * The subscribe, unsubscribe, confirm and cancel operations along with their
+ * notification emails; shared by the subscription pages and the JSON API.
+ */
+
+
+#include <boost/algorithm/string.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <pqxx/pqxx>
+#include <CoreLib/CDate.hpp>
+#include <CoreLib/Crypto.hpp>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/FileSystem.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/Mail.hpp>
+#include <CoreLib/Random.hpp>
+#include <CoreLib/Validate.hpp>
+#include "LocalizedStrings.hpp"
+#include "Pool.hpp"
+#include "SettingsCache.hpp"
+#include "Subscriber.hpp"
+#include "SubscriptionLink.hpp"
+#include "SubscriptionLinkPage.hpp"
+
+using namespace std;
+using namespace boost;
+using namespace pqxx;
+using namespace CoreLib;
+using namespace CoreLib::CDate;
+using namespace Service;
+
+Subscriber::Result Subscriber::Subscribe(const CgiEnv::InformationRecord &info, const std::string &inbox,
+                                         const std::string &languages)
+{
+    try {
+        CDate::Now n(CDate::Timezone::UTC);
+        string date(lexical_cast<std::string>(n.RawTime()));
+
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+
+        string uuid;
+
+        /// The inbox conflict is resolved by the upsert itself, so the only
+        /// unique violation left to be handled is a (very unlikely) duplicate UUID.
+        for (;;) {
+            CoreLib::Random::Uuid(uuid);
+
+            pqxx::work txn(*conn.get());
+
+            string query((boost::format("INSERT INTO \"%1%\""
+                                        " ( inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date )"
+                                        " VALUES ( %2%, %3%, 'none', %4%, 'none', TO_TIMESTAMP(%5%)::TIMESTAMPTZ, TO_TIMESTAMP(%5%)::TIMESTAMPTZ )"
+                                        " ON CONFLICT ( inbox ) DO UPDATE"
+                                        " SET pending_confirm = EXCLUDED.pending_confirm, pending_cancel = 'none',"
+                                        " update_date = EXCLUDED.update_date"
+                                        " RETURNING uuid;")
+                          % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
+                          % txn.quote(inbox)
+                          % txn.quote(uuid)
+                          % txn.quote(languages)
+                          % txn.esc(date)).str());
+            LOG_INFO("Running query...", query, info.ToJson());
+
+            try {
+                result r = txn.exec(query);
+                txn.commit();
+
+                uuid.assign(r[0]["uuid"].c_str());
+
+                break;
+            } catch (const pqxx::unique_violation &ex) {
+                LOG_WARNING("UUID collision detected! Retrying...", ex.what(), info.ToJson());
+            }
+        }
+
+        SendMessage(info, Message::Confirm, uuid, inbox);
+
+        return Result::Done;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), info.ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+
+    return Result::Failed;
+}
+
+Subscriber::Result Subscriber::Unsubscribe(const CgiEnv::InformationRecord &info, const std::string &inbox,
+                                           const std::string &languages)
+{
+    try {
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        string query((boost::format("UPDATE ONLY \"%1%\""
+                                    " SET pending_cancel = %2%"
+                                    " WHERE inbox = %3%"
+                                    " RETURNING uuid;")
+                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
+                      % txn.quote(languages)
+                      % txn.quote(inbox)).str());
+        LOG_INFO("Running query...", query, info.ToJson());
+
+        result r = txn.exec(query);
+        txn.commit();
+
+        if (r.empty()) {
+            return Result::InvalidRecipient;
+        }
+
+        const string uuid(r[0]["uuid"].c_str());
+
+        SendMessage(info, Message::Cancel, uuid, inbox);
+
+        return Result::Done;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), info.ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+
+    return Result::Failed;
+}
+
+Subscriber::Result Subscriber::Confirm(const CgiEnv::InformationRecord &info,
+                                       std::string &out_inbox, std::string &out_subscription)
+{
+    try {
+        if (!CoreLib::Validate::Uuid(info.Subscription.Uuid)) {
+            return Result::InvalidRecipient;
+        }
+
+        CDate::Now n(CDate::Timezone::UTC);
+        string date(lexical_cast<std::string>(n.RawTime()));
+
+        if (info.Subscription.Timestamp < n.RawTime()) {
+            return Result::Expired;
+        }
+
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        /// Lock the subscriber and confirm any pending subscription in one round trip
+        string query((boost::format("WITH target AS ("
+                                    " SELECT inbox, subscription, pending_confirm FROM \"%1%\""
+                                    " WHERE uuid = %2% FOR UPDATE"
+                                    " ), confirmed AS ("
+                                    " UPDATE ONLY \"%1%\" AS s"
+                                    " SET subscription = ( CASE"
+                                    " WHEN target.subscription = 'none' THEN target.pending_confirm"
+                                    " WHEN target.subscription = 'en' AND target.pending_confirm = 'fa' THEN 'en_fa'"
+                                    " WHEN target.subscription = 'fa' AND target.pending_confirm = 'en' THEN 'en_fa'"
+                                    " WHEN target.subscription IN ( 'en', 'fa' ) THEN target.subscription"
+                                    " ELSE 'en_fa' END )::SUBSCRIPTION,"
+                                    " pending_confirm = 'none', pending_cancel = 'none', update_date = TO_TIMESTAMP(%3%)::TIMESTAMPTZ"
+                                    " FROM target"
+                                    " WHERE s.inbox = target.inbox AND target.pending_confirm <> 'none'"
+                                    " RETURNING s.inbox"
+                                    " )"
+                                    " SELECT target.inbox, target.subscription, target.pending_confirm"
+                                    " FROM ( SELECT 1 ) AS one"
+                                    " LEFT JOIN target ON TRUE;")
+                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
+                      % txn.quote(info.Subscription.Uuid)
+                      % txn.esc(date)).str());
+        LOG_INFO("Running query...", query, info.ToJson());
+
+        pqxx::result r = txn.exec(query);
+        txn.commit();
+
+        const pqxx::row row(r[0]);
+
+        if (row["inbox"].is_null()) {
+            return Result::InvalidRecipient;
+        }
+
+        out_inbox.assign(row["inbox"].c_str());
+        out_subscription.assign(row["subscription"].c_str());
+        const string pendingConfirm(row["pending_confirm"].c_str());
+
+        if (pendingConfirm == "none" && out_subscription == "none") {
+            return Result::NothingPending;
+        } else if (pendingConfirm == "none") {
+            return Result::AlreadyDone;
+        }
+
+        SendMessage(info, Message::Confirmed, info.Subscription.Uuid, out_inbox);
+
+        return Result::Done;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), info.ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+
+    return Result::Failed;
+}
+
+Subscriber::Result Subscriber::Cancel(const CgiEnv::InformationRecord &info,
+                                      std::string &out_inbox, std::string &out_subscription)
+{
+    try {
+        if (!CoreLib::Validate::Uuid(info.Subscription.Uuid)) {
+            return Result::InvalidRecipient;
+        }
+
+        CDate::Now n(CDate::Timezone::UTC);
+        string date(lexical_cast<std::string>(n.RawTime()));
+
+        /// A missing, forged or expired token never makes it to the database
+        if (info.Subscription.Timestamp < n.RawTime()) {
+            return Result::Expired;
+        }
+
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        /// Lock the subscriber and apply any pending cancellation in one round trip
+        string query((boost::format("WITH target AS ("
+                                    " SELECT inbox, subscription, pending_cancel FROM \"%1%\""
+                                    " WHERE uuid = %2% FOR UPDATE"
+                                    " ), cancelled AS ("
+                                    " UPDATE ONLY \"%1%\" AS s"
+                                    " SET subscription = ( CASE"
+                                    " WHEN target.pending_cancel = 'en' AND target.subscription IN ( 'en_fa', 'fa' ) THEN 'fa'"
+                                    " WHEN target.pending_cancel = 'fa' AND target.subscription IN ( 'en_fa', 'en' ) THEN 'en'"
+                                    " ELSE 'none' END )::SUBSCRIPTION,"
+                                    " pending_cancel = 'none', update_date = TO_TIMESTAMP(%3%)::TIMESTAMPTZ"
+                                    " FROM target"
+                                    " WHERE s.inbox = target.inbox AND target.pending_cancel <> 'none'"
+                                    " RETURNING s.inbox"
+                                    " )"
+                                    " SELECT target.inbox, target.subscription, target.pending_cancel"
+                                    " FROM ( SELECT 1 ) AS one"
+                                    " LEFT JOIN target ON TRUE;")
+                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
+                      % txn.quote(info.Subscription.Uuid)
+                      % txn.esc(date)).str());
+        LOG_INFO("Running query...", query, info.ToJson());
+
+        pqxx::result r = txn.exec(query);
+        txn.commit();
+
+        const pqxx::row row(r[0]);
+
+        if (row["inbox"].is_null()) {
+            return Result::InvalidRecipient;
+        }
+
+        out_inbox.assign(row["inbox"].c_str());
+        out_subscription.assign(row["subscription"].c_str());
+        const string pendingCancel(row["pending_cancel"].c_str());
+
+        if (pendingCancel == "none" && out_subscription == "none") {
+            return Result::AlreadyDone;
+        } else if (pendingCancel == "none") {
+            return Result::NothingPending;
+        }
+
+        SendMessage(info, Message::Cancelled, info.Subscription.Uuid, out_inbox);
+
+        return Result::Done;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query(), info.ToJson());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+
+    return Result::Failed;
+}
+
+void Subscriber::GetHomePage(const CgiEnv::InformationRecord &info,
+                             std::string &out_url, std::string &out_title)
+{
+    SettingsCache::SnapshotPtr settings(Pool::Settings().Get());
+
+    if (info.Client.Language.Code
+            == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
+        out_url.assign(settings->HomePageUrlFa);
+        out_title.assign(settings->HomePageTitleFa);
+    } else {
+        out_url.assign(settings->HomePageUrlEn);
+        out_title.assign(settings->HomePageTitleEn);
+    }
+}
+
+std::string Subscriber::GetLocale(const CgiEnv::InformationRecord &info)
+{
+    return info.Client.Language.Code
+            == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa
+            ? "fa" : "en";
+}
+
+void Subscriber::SendMessage(const CgiEnv::InformationRecord &info, const Message &type,
+                             const std::string &uuid, const std::string &inbox)
+{
+    try {
+        CDate::Now n(CDate::Timezone::UTC);
+
+        string htmlData;
+        string file;
+        if (info.Client.Language.Code
+                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
+            switch (type) {
+            case Message::Confirm:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-confirm-subscription-fa-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-confirm-subscription-fa.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            case Message::Confirmed:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-subscription-confirmed-fa-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-subscription-confirmed-fa.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            case Message::Cancel:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-cancel-subscription-fa-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-cancel-subscription-fa.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            case Message::Cancelled:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-subscription-cancelled-fa-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-subscription-cancelled-fa.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            }
+        } else {
+            switch (type) {
+            case Message::Confirm:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-confirm-subscription-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-confirm-subscription.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            case Message::Confirmed:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-subscription-confirmed-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-subscription-confirmed.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            case Message::Cancel:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-cancel-subscription-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-cancel-subscription.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            case Message::Cancelled:
+#if GDPR_COMPLIANCE
+                file = "../templates/email-subscription-cancelled-gdpr-compliant.wtml";
+#else
+                file = "../templates/email-subscription-cancelled.wtml";
+#endif // GDPR_COMPLIANCE
+                break;
+            }
+        }
+
+        if (CoreLib::FileSystem::Read(file, htmlData)) {
+            /// No Wt session to tr() in, which is why the subjects come
+            /// straight out of the process-wide bundle
+            const string locale(GetLocale(info));
+            string subject;
+
+            switch (type) {
+            case Message::Confirm:
+                subject = (format(Pool::Localization().Resolve(locale, "email-subject-confirm-subscription"))
+                           % info.Server.Hostname).str();
+                break;
+            case Message::Confirmed:
+                subject = (format(Pool::Localization().Resolve(locale, "email-subject-subscription-confirmed"))
+                           % info.Server.Hostname).str();
+                break;
+            case Message::Cancel:
+                subject = (format(Pool::Localization().Resolve(locale, "email-subject-cancel-subscription"))
+                           % info.Server.Hostname).str();
+                break;
+            case Message::Cancelled:
+                subject = (format(Pool::Localization().Resolve(locale, "email-subject-subscription-cancelled"))
+                           % info.Server.Hostname).str();
+                break;
+            }
+
+#if !(GDPR_COMPLIANCE)
+            replace_all(htmlData, "${client-ip}",
+                        info.Client.IPAddress);
+            replace_all(htmlData, "${client-user-agent}",
+                        info.Client.UserAgent);
+            replace_all(htmlData, "${client-referer}",
+                        info.Client.Referer);
+
+            if (info.Client.Language.Code
+                    == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
+                replace_all(htmlData, "${time}",
+                            DateConv::PersianTimeStamp(n));
+            } else {
+                replace_all(htmlData, "${time}",
+                            DateConv::TimeStamp(n));
+            }
+
+            replace_all(htmlData, "${client-location-country-code}",
+                        info.Client.GeoLocation.CountryCode);
+            replace_all(htmlData, "${client-location-country-name}",
+                        info.Client.GeoLocation.CountryName);
+            replace_all(htmlData, "${client-location-region}",
+                        info.Client.GeoLocation.Region);
+            replace_all(htmlData, "${client-location-city}",
+                        info.Client.GeoLocation.City);
+            replace_all(htmlData, "${client-location-postal-code}",
+                        info.Client.GeoLocation.PostalCode);
+            replace_all(htmlData, "${client-location-latitude}",
+                        lexical_cast<string>(info.Client.GeoLocation.Latitude));
+            replace_all(htmlData, "${client-location-longitude}",
+                        lexical_cast<string>(info.Client.GeoLocation.Longitude));
+            replace_all(htmlData, "${client-location-metro-code}",
+                        lexical_cast<string>(info.Client.GeoLocation.MetroCode));
+            replace_all(htmlData, "${client-location-continent-code}",
+                        info.Client.GeoLocation.ContinentCode);
+            replace_all(htmlData, "${client-location-asn}",
+                        lexical_cast<string>(info.Client.GeoLocation.ASN));
+            replace_all(htmlData, "${client-location-aso}",
+                        lexical_cast<string>(info.Client.GeoLocation.ASO));
+            replace_all(htmlData, "${client-location-raw-data}",
+                        lexical_cast<string>(info.Client.GeoLocation.RawData));
+#endif // !(GDPR_COMPLIANCE)
+
+            string homePageUrl;
+            string homePageTitle;
+            GetHomePage(info, homePageUrl, homePageTitle);
+
+            replace_all(htmlData, "${home-page-url}", homePageUrl);
+            replace_all(htmlData, "${home-page-title}", homePageTitle);
+
+            string link(info.Server.Url);
+
+            if (!ends_with(link, "/"))
+                link += "/";
+
+            /// Served by SubscriptionLinkPage without spinning up a session;
+            /// lang only picks the page language and is not signed
+            link += SubscriptionLinkPage::Path() + "?lang=" + locale + "&";
+
+            if (type == Message::Confirm) {
+                SubscriptionLink::Sign("2", uuid, "", n.RawTime() + Pool::Storage().ConfirmLinkLifespan(), link);
+
+                replace_all(htmlData, "${confirm-link}", link);
+            } else if (type == Message::Cancel) {
+                /// Bound to the recipient and expires on its own
+                std::string token;
+                Pool::Crypto().SealToken(uuid, n.RawTime() + Pool::Storage().TokenLifespan(), token);
+
+                link += (format("subscribe=-2&recipient=%1%&token=%2%")
+                         % uuid
+                         % token).str();
+
+                replace_all(htmlData, "${cancel-link}", link);
+            }
+
+            CoreLib::Mail *mail = new CoreLib::Mail(
+                        info.Server.NoReplyAddress,
+                        inbox, subject, htmlData);
+            mail->SetDeleteLater(true);
+            mail->SendAsync();
+        }
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+}
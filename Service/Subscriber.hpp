@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * The subscribe, unsubscribe, confirm and cancel operations along with their
+ * notification emails; shared by the subscription pages and the JSON API.
+ */
+
+
+#ifndef SERVICE_SUBSCRIBER_HPP
+#define SERVICE_SUBSCRIBER_HPP
+
+
+#include <string>
+#include "CgiEnv.hpp"
+
+namespace Service {
+class Subscriber;
+}
+
+class Service::Subscriber
+{
+public:
+    enum class Result : unsigned char {
+        Done,
+        InvalidRecipient,
+        Expired,
+        AlreadyDone,
+        NothingPending,
+        Failed
+    };
+
+private:
+    enum class Message : unsigned char {
+        Confirm,
+        Confirmed,
+        Cancel,
+        Cancelled
+    };
+
+public:
+    /// The languages are one of en, fa or en_fa; sends the confirmation email
+    static Result Subscribe(const CgiEnv::InformationRecord &info, const std::string &inbox,
+                            const std::string &languages);
+
+    /// The languages are one of en, fa or en_fa; sends the cancellation email
+    static Result Unsubscribe(const CgiEnv::InformationRecord &info, const std::string &inbox,
+                              const std::string &languages);
+
+    /// Applies the pending subscription of info.Subscription.Uuid, provided
+    /// that info.Subscription.Timestamp has not expired yet. NothingPending
+    /// means there is neither a subscription nor a pending one.
+    static Result Confirm(const CgiEnv::InformationRecord &info,
+                          std::string &out_inbox, std::string &out_subscription);
+
+    /// Applies the pending cancellation of info.Subscription.Uuid, provided
+    /// that info.Subscription.Timestamp has not expired yet. AlreadyDone means
+    /// there is neither a subscription nor a pending cancellation.
+    static Result Cancel(const CgiEnv::InformationRecord &info,
+                         std::string &out_inbox, std::string &out_subscription);
+
+    static void GetHomePage(const CgiEnv::InformationRecord &info,
+                            std::string &out_url, std::string &out_title);
+
+    /// The locale to look the messages up in, either fa or en
+    static std::string GetLocale(const CgiEnv::InformationRecord &info);
+
+private:
+    static void SendMessage(const CgiEnv::InformationRecord &info, const Message &type,
+                            const std::string &uuid, const std::string &inbox);
+};
+
+
+#endif /* SERVICE_SUBSCRIBER_HPP */
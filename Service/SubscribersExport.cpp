@@ -0,0 +1,304 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Streams the subscribers list as CSV or NDJSON, chunk by chunk, through
+ * response continuations; optionally gzip-compressed on the fly.
+ */
+
+
+#include <ctime>
+#include <boost/any.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <pqxx/pqxx>
+#include <Wt/Http/Request>
+#include <Wt/Http/Response>
+#include <Wt/Http/ResponseContinuation>
+#include <CoreLib/Compression.hpp>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include <CoreLib/Utility.hpp>
+#include "Pool.hpp"
+#include "SubscribersExport.hpp"
+
+/// Rows per continuation; bounds both the memory and the time a single
+/// request holds on to a pooled database connection
+#define     EXPORT_CHUNK_ROWS           1000
+
+using namespace std;
+using namespace boost;
+using namespace Wt;
+using namespace CoreLib;
+using namespace Service;
+
+struct SubscribersExport::Impl
+{
+public:
+    struct State
+    {
+        std::string Filter;
+        std::string LastInbox;
+        bool Started;
+
+        State() : Started(false) { }
+    };
+
+    typedef std::shared_ptr<State> StatePtr;
+
+public:
+    Format ExportFormat;
+    bool Gzip;
+
+    std::string Filter;
+    boost::mutex FilterMutex;
+
+public:
+    Impl(const Format &format, const bool gzip);
+    ~Impl();
+
+public:
+    bool FetchChunk(State &state, std::string &out_chunk);
+
+    void AppendCsvField(const std::string &value, std::string &out_chunk, const bool last = false);
+};
+
+SubscribersExport::SubscribersExport(const Format &format, const bool gzip, Wt::WObject *parent)
+    : WResource(parent),
+      m_pimpl(make_unique<SubscribersExport::Impl>(format, gzip))
+{
+    string fileName(format == Format::Csv ? "subscribers.csv" : "subscribers.ndjson");
+    if (gzip)
+        fileName += ".gz";
+
+    this->suggestFileName(fileName);
+}
+
+SubscribersExport::~SubscribersExport()
+{
+    beingDeleted();
+}
+
+void SubscribersExport::SetFilter(const std::string &filter)
+{
+    boost::lock_guard<boost::mutex> lock(m_pimpl->FilterMutex);
+    (void)lock;
+
+    m_pimpl->Filter = filter;
+}
+
+void SubscribersExport::handleRequest(const Wt::Http::Request &request,
+                                      Wt::Http::Response &response)
+{
+    try {
+        Impl::StatePtr state;
+
+        if (request.continuation()) {
+            state = boost::any_cast<Impl::StatePtr>(request.continuation()->data());
+        } else {
+            state = std::make_shared<Impl::State>();
+
+            {
+                boost::lock_guard<boost::mutex> lock(m_pimpl->FilterMutex);
+                (void)lock;
+
+                state->Filter = m_pimpl->Filter.empty() ? "TRUE" : m_pimpl->Filter;
+            }
+
+            if (m_pimpl->Gzip) {
+                response.setMimeType("application/gzip");
+            } else if (m_pimpl->ExportFormat == Format::Csv) {
+                response.setMimeType("text/csv; charset=utf-8");
+            } else {
+                response.setMimeType("application/x-ndjson; charset=utf-8");
+            }
+        }
+
+        string chunk;
+        const bool more = m_pimpl->FetchChunk(*state, chunk);
+
+        if (!chunk.empty()) {
+            if (m_pimpl->Gzip) {
+                /// Concatenated gzip members still make up a valid gzip stream,
+                /// so there is no need to keep a compressor alive between chunks
+                Compression::Buffer compressed;
+                Compression::Compress(chunk, compressed, Compression::Algorithm::Gzip);
+                response.out().write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+            } else {
+                response.out().write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            }
+        }
+
+        if (more) {
+            Http::ResponseContinuation *continuation = response.createContinuation();
+            continuation->setData(state);
+        }
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+}
+
+SubscribersExport::Impl::Impl(const Format &format, const bool gzip)
+    : ExportFormat(format),
+      Gzip(gzip)
+{
+
+}
+
+SubscribersExport::Impl::~Impl() = default;
+
+bool SubscribersExport::Impl::FetchChunk(State &state, std::string &out_chunk)
+{
+    out_chunk.clear();
+
+    if (!state.Started && ExportFormat == Format::Csv) {
+        out_chunk.assign("inbox,uuid,subscription,pending_confirm,pending_cancel,join_date,update_date\r\n");
+    }
+
+    try {
+        auto conn = Pool::Database().Connection(CoreLib::Database::Intent::ReadOnly);
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        /// Keyset pagination instead of a cursor, so that no connection is
+        /// held between two continuations
+        string seekPhrase;
+        if (state.Started) {
+            seekPhrase = (boost::format(" AND inbox > %1%") % txn.quote(state.LastInbox)).str();
+        }
+
+        /// Let the server render the ISO 8601 timestamps straight from the
+        /// TIMESTAMPTZ columns instead of round-tripping through epoch seconds
+        string query((boost::format("SELECT inbox, uuid, subscription, pending_confirm, pending_cancel,"
+                                    " to_char( join_date AT TIME ZONE 'UTC', 'YYYY-MM-DD\"T\"HH24:MI:SS\"Z\"' ) AS join_date,"
+                                    " to_char( update_date AT TIME ZONE 'UTC', 'YYYY-MM-DD\"T\"HH24:MI:SS\"Z\"' ) AS update_date"
+                                    " FROM \"%1%\" WHERE %2%%3% ORDER BY inbox ASC LIMIT %4%;")
+                      % txn.esc(Pool::Database().GetTableName("SUBSCRIBERS"))
+                      % state.Filter
+                      % seekPhrase
+                      % EXPORT_CHUNK_ROWS).str());
+        LOG_INFO("Running query...", query);
+
+        pqxx::result r = txn.exec(query);
+
+        txn.commit();
+
+        state.Started = true;
+
+        for (const auto &row : r) {
+            const string inbox(row["inbox"].c_str());
+            const string uuid(row["uuid"].c_str());
+            const string subscription(row["subscription"].c_str());
+            const string pendingConfirm(row["pending_confirm"].c_str());
+            const string pendingCancel(row["pending_cancel"].c_str());
+            const string joinDate(row["join_date"].c_str());
+            const string updateDate(row["update_date"].c_str());
+
+            if (ExportFormat == Format::Csv) {
+                AppendCsvField(inbox, out_chunk);
+                AppendCsvField(uuid, out_chunk);
+                AppendCsvField(subscription, out_chunk);
+                AppendCsvField(pendingConfirm, out_chunk);
+                AppendCsvField(pendingCancel, out_chunk);
+                AppendCsvField(joinDate, out_chunk);
+                AppendCsvField(updateDate, out_chunk, true);
+            } else {
+                out_chunk.append("{\"inbox\":");
+                CoreLib::Utility::AppendJsonString(inbox, out_chunk);
+                out_chunk.append(",\"uuid\":");
+                CoreLib::Utility::AppendJsonString(uuid, out_chunk);
+                out_chunk.append(",\"subscription\":");
+                CoreLib::Utility::AppendJsonString(subscription, out_chunk);
+                out_chunk.append(",\"pending_confirm\":");
+                CoreLib::Utility::AppendJsonString(pendingConfirm, out_chunk);
+                out_chunk.append(",\"pending_cancel\":");
+                CoreLib::Utility::AppendJsonString(pendingCancel, out_chunk);
+                out_chunk.append(",\"join_date\":");
+                CoreLib::Utility::AppendJsonString(joinDate, out_chunk);
+                out_chunk.append(",\"update_date\":");
+                CoreLib::Utility::AppendJsonString(updateDate, out_chunk);
+                out_chunk.append("}\n");
+            }
+
+            state.LastInbox = inbox;
+        }
+
+        return r.size() == static_cast<pqxx::result::size_type>(EXPORT_CHUNK_ROWS);
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    return false;
+}
+
+void SubscribersExport::Impl::AppendCsvField(const std::string &value, std::string &out_chunk, const bool last)
+{
+    if (value.find_first_of(",\"\r\n") == string::npos) {
+        out_chunk.append(value);
+    } else {
+        out_chunk.push_back('"');
+        for (const char c : value) {
+            if (c == '"')
+                out_chunk.push_back('"');
+            out_chunk.push_back(c);
+        }
+        out_chunk.push_back('"');
+    }
+
+    out_chunk.append(last ? "\r\n" : ",");
+}
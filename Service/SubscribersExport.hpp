@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Streams the subscribers list as CSV or NDJSON, chunk by chunk, through
+ * response continuations; optionally gzip-compressed on the fly.
+ */
+
+
+#ifndef SERVICE_SUBSCRIBERS_EXPORT_HPP
+#define SERVICE_SUBSCRIBERS_EXPORT_HPP
+
+
+#include <memory>
+#include <string>
+#include <Wt/WResource>
+
+namespace Service {
+class SubscribersExport;
+}
+
+class Service::SubscribersExport : public Wt::WResource
+{
+public:
+    enum class Format : unsigned char {
+        Csv,
+        NdJson
+    };
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    SubscribersExport(const Format &format, const bool gzip, Wt::WObject *parent = 0);
+    virtual ~SubscribersExport() override;
+
+public:
+    /// A SQL condition on the subscribers table, e.g. the admin's current view
+    void SetFilter(const std::string &filter);
+
+    virtual void handleRequest(const Wt::Http::Request &request,
+                               Wt::Http::Response &response) override;
+};
+
+
+#endif /* SERVICE_SUBSCRIBERS_EXPORT_HPP */
@@ -0,0 +1,368 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Bulk-imports subscribers from a (possibly gzipped) CSV file through a
+ * parallel validation pipeline, a COPY-loaded staging table and a single
+ * merge statement.
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <unordered_set>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <pqxx/pqxx>
+#include <CoreLib/CDate.hpp>
+#include <CoreLib/Compression.hpp>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/FileSystem.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/Random.hpp>
+#include <CoreLib/Validate.hpp>
+#include "Pool.hpp"
+#include "SubscribersImport.hpp"
+#include "WorkerPool.hpp"
+
+#define     DEFAULT_SUBSCRIPTION        "en_fa"
+#define     PROGRESS_REPORT_ROWS        50000
+
+using namespace std;
+using namespace boost;
+using namespace CoreLib;
+using namespace Service;
+
+struct SubscribersImport::Impl
+{
+    struct Entry
+    {
+        std::string Inbox;
+        std::string Subscription;
+        std::string Uuid;
+    };
+
+    typedef std::vector<Entry> Entries;
+
+    static bool Read(const std::string &filePath, std::string &out_data);
+    static void Split(const std::string &data, std::vector<std::pair<size_t, size_t>> &out_lines);
+    static void Validate(const std::string &data,
+                         const std::vector<std::pair<size_t, size_t>> &lines,
+                         const size_t begin, const size_t end,
+                         Entries &out_entries, uint_fast64_t &out_invalid);
+};
+
+bool SubscribersImport::Run(const std::string &filePath,
+                            const ProgressCallback &progress,
+                            Result &out_result)
+{
+    out_result = Result();
+
+    try {
+        progress(Stage::Reading, 0, 0);
+
+        string data;
+        if (!Impl::Read(filePath, data)) {
+            progress(Stage::Failed, 0, 0);
+            return false;
+        }
+
+        std::vector<std::pair<size_t, size_t>> lines;
+        Impl::Split(data, lines);
+
+        out_result.Total = lines.size();
+
+        progress(Stage::Validating, 0, out_result.Total);
+
+        /// Validate in parallel on the shared validation threads, one
+        /// contiguous range of lines per worker
+        const size_t workers = std::max<size_t>(1, std::min<size_t>(Pool::Validation().GetMetrics().Workers,
+                                                                    lines.size() / PROGRESS_REPORT_ROWS + 1));
+        const size_t linesPerWorker = (lines.size() + workers - 1) / workers;
+
+        std::vector<Impl::Entries> entries(workers);
+        std::vector<uint_fast64_t> invalid(workers, 0);
+
+        std::vector<std::exception_ptr> errors(workers);
+
+        std::atomic<uint_fast64_t> validated(0);
+
+        size_t pending = workers;
+        boost::mutex pendingMutex;
+        boost::condition_variable pendingCondition;
+
+        for (size_t w = 0; w < workers; ++w) {
+            const size_t begin = std::min(lines.size(), w * linesPerWorker);
+            const size_t end = std::min(lines.size(), begin + linesPerWorker);
+
+            const auto validate = [&, w, begin, end]() {
+                /// Has to count down no matter what, or we would wait forever;
+                /// the error is rethrown on this thread once all are done
+                try {
+                    Impl::Validate(data, lines, begin, end, entries[w], invalid[w]);
+                    progress(Stage::Validating, validated += (end - begin), out_result.Total);
+                }
+
+                catch (...) {
+                    errors[w] = std::current_exception();
+                }
+
+                boost::lock_guard<boost::mutex> lock(pendingMutex);
+                (void)lock;
+                --pending;
+                pendingCondition.notify_all();
+            };
+
+            /// The shared queue is full; do our share on this thread instead
+            if (!Pool::Validation().Post(validate)) {
+                validate();
+            }
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(pendingMutex);
+            pendingCondition.wait(lock, [&pending]() { return pending == 0; });
+        }
+
+        for (const auto &e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+
+        /// Keep the first occurrence of each inbox, in file order
+        std::unordered_set<std::string> seen;
+        Impl::Entries unique;
+        for (size_t w = 0; w < workers; ++w) {
+            out_result.Invalid += invalid[w];
+
+            for (auto &e : entries[w]) {
+                if (seen.insert(e.Inbox).second) {
+                    unique.push_back(std::move(e));
+                } else {
+                    ++out_result.Duplicates;
+                }
+            }
+
+            Impl::Entries().swap(entries[w]);
+        }
+
+        std::string().swap(data);
+
+        progress(Stage::Loading, 0, unique.size());
+
+        auto conn = Pool::Database().Connection();
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        const string subscribers(txn.esc(Pool::Database().GetTableName("SUBSCRIBERS")));
+        const string counts(txn.esc(Pool::Database().GetTableName("SUBSCRIBER_COUNTS")));
+
+        txn.exec("CREATE TEMPORARY TABLE \"subscribers_import\" ("
+                 " inbox TEXT NOT NULL,"
+                 " uuid UUID NOT NULL,"
+                 " subscription SUBSCRIPTION NOT NULL"
+                 " ) ON COMMIT DROP;");
+
+        {
+            /// COPY ... FROM STDIN
+            pqxx::tablewriter writer(txn, "subscribers_import");
+
+            uint_fast64_t loaded = 0;
+            for (const auto &e : unique) {
+                /// The email validation rules leave no room for tabs,
+                /// newlines or backslashes, so no COPY escaping is needed
+                writer.write_raw_line(e.Inbox + "\t" + e.Uuid + "\t" + e.Subscription);
+
+                if (++loaded % PROGRESS_REPORT_ROWS == 0) {
+                    progress(Stage::Loading, loaded, unique.size());
+                }
+            }
+
+            writer.complete();
+        }
+
+        progress(Stage::Merging, 0, unique.size());
+
+        CDate::Now n(CDate::Timezone::UTC);
+        const string date(lexical_cast<std::string>(n.RawTime()));
+
+        /// The per-row counting trigger would update the same counter rows
+        /// once per imported subscriber; have it skip this transaction's
+        /// rows (see migration 3) and adjust the counters in one go.
+        /// Everyone else's writes keep going through the trigger.
+        txn.exec("SET LOCAL app.bulk_import = on;");
+
+        string query((boost::format("WITH inserted AS ("
+                                    " INSERT INTO \"%1%\""
+                                    " ( inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date )"
+                                    " SELECT inbox, uuid, subscription, 'none', 'none', TO_TIMESTAMP(%3%)::TIMESTAMPTZ, TO_TIMESTAMP(%3%)::TIMESTAMPTZ"
+                                    " FROM \"subscribers_import\""
+                                    " ON CONFLICT ( inbox ) DO NOTHING"
+                                    " RETURNING subscription"
+                                    " ), grouped AS ("
+                                    " SELECT subscription, count(*) AS n FROM inserted GROUP BY subscription"
+                                    " ), counted AS ("
+                                    " UPDATE \"%2%\" AS c SET count = c.count + grouped.n"
+                                    " FROM grouped WHERE c.subscription = grouped.subscription"
+                                    " )"
+                                    " SELECT COALESCE(sum(n), 0) AS inserted FROM grouped;")
+                      % subscribers
+                      % counts
+                      % txn.esc(date)).str());
+        LOG_INFO("Running query...", query);
+
+        pqxx::result r = txn.exec(query);
+
+        txn.commit();
+
+        out_result.Inserted = r.empty() ? 0 : r[0]["inserted"].as<uint_fast64_t>();
+
+        progress(Stage::Done, out_result.Inserted, unique.size());
+
+        return true;
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+
+    progress(Stage::Failed, 0, 0);
+
+    return false;
+}
+
+bool SubscribersImport::Impl::Read(const std::string &filePath, std::string &out_data)
+{
+    if (!FileSystem::Read(filePath, out_data))
+        return false;
+
+    const std::size_t maxSize = static_cast<std::size_t>(Pool::Storage().MaxSubscribersImportSize());
+
+    /// gzip magic number
+    if (out_data.size() >= 2
+            && static_cast<unsigned char>(out_data[0]) == 0x1f
+            && static_cast<unsigned char>(out_data[1]) == 0x8b) {
+        Compression::Buffer compressed(out_data.begin(), out_data.end());
+        std::string().swap(out_data);
+
+        if (!Compression::Decompress(compressed, out_data, Compression::Algorithm::Gzip, maxSize)) {
+            LOG_ERROR("Rejected the subscribers import: corrupted or decompresses beyond the limit!",
+                      (boost::format("Limit: %1% bytes") % maxSize).str());
+            return false;
+        }
+    } else if (out_data.size() > maxSize) {
+        LOG_ERROR("Rejected the subscribers import: too large!",
+                  (boost::format("Size: %1% bytes") % out_data.size()).str(),
+                  (boost::format("Limit: %1% bytes") % maxSize).str());
+        return false;
+    }
+
+    return true;
+}
+
+void SubscribersImport::Impl::Split(const std::string &data, std::vector<std::pair<size_t, size_t>> &out_lines)
+{
+    out_lines.clear();
+    out_lines.reserve(static_cast<size_t>(std::count(data.begin(), data.end(), '\n')) + 1);
+
+    size_t begin = 0;
+    while (begin < data.size()) {
+        size_t end = data.find('\n', begin);
+        if (end == string::npos)
+            end = data.size();
+
+        size_t last = end;
+        if (last > begin && data[last - 1] == '\r')
+            --last;
+
+        if (last > begin)
+            out_lines.emplace_back(begin, last - begin);
+
+        begin = end + 1;
+    }
+}
+
+void SubscribersImport::Impl::Validate(const std::string &data,
+                                       const std::vector<std::pair<size_t, size_t>> &lines,
+                                       const size_t begin, const size_t end,
+                                       Entries &out_entries, uint_fast64_t &out_invalid)
+{
+    out_entries.reserve(end - begin);
+
+    for (size_t i = begin; i < end; ++i) {
+        const string line(data, lines[i].first, lines[i].second);
+
+        const size_t separator = line.find_first_of(",;\t");
+
+        string inbox(algorithm::trim_copy_if(line.substr(0, separator), algorithm::is_any_of(" \"'")));
+        algorithm::to_lower(inbox);
+
+        string subscription(DEFAULT_SUBSCRIPTION);
+        if (separator != string::npos) {
+            subscription = algorithm::to_lower_copy(
+                        algorithm::trim_copy_if(line.substr(separator + 1), algorithm::is_any_of(" \"'")));
+            if (subscription.empty())
+                subscription = DEFAULT_SUBSCRIPTION;
+        }
+
+        /// Same rules as the subscription form, over the whole field
+        if (!CoreLib::Validate::Email(inbox)
+                || (subscription != "en_fa" && subscription != "en" && subscription != "fa")) {
+            /// A header line ends up here as well
+            ++out_invalid;
+            continue;
+        }
+
+        Entry e;
+        e.Inbox = std::move(inbox);
+        e.Subscription = std::move(subscription);
+        Random::Uuid(e.Uuid);
+        out_entries.push_back(std::move(e));
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Bulk-imports subscribers from a (possibly gzipped) CSV file through a
+ * parallel validation pipeline, a COPY-loaded staging table and a single
+ * merge statement.
+ */
+
+
+#ifndef SERVICE_SUBSCRIBERS_IMPORT_HPP
+#define SERVICE_SUBSCRIBERS_IMPORT_HPP
+
+
+#include <functional>
+#include <string>
+#include <cstdint>
+
+namespace Service {
+class SubscribersImport;
+}
+
+class Service::SubscribersImport
+{
+public:
+    enum class Stage : unsigned char {
+        Reading,
+        Validating,
+        Loading,
+        Merging,
+        Done,
+        Failed
+    };
+
+    struct Result
+    {
+        uint_fast64_t Total;
+        uint_fast64_t Invalid;
+        uint_fast64_t Duplicates;
+        uint_fast64_t Inserted;
+
+        Result() : Total(0), Invalid(0), Duplicates(0), Inserted(0) { }
+    };
+
+    /// Might get called on any thread
+    typedef std::function<void(const Stage &, const uint_fast64_t, const uint_fast64_t)> ProgressCallback;
+
+private:
+    struct Impl;
+
+public:
+    /// Each line holds an email address, optionally followed by a ',', ';'
+    /// or tab separated subscription (en_fa, en or fa; defaults to en_fa).
+    /// Blocks until the import is done, so run it off the UI thread.
+    static bool Run(const std::string &filePath,
+                    const ProgressCallback &progress,
+                    Result &out_result);
+};
+
+
+#endif /* SERVICE_SUBSCRIBERS_IMPORT_HPP */
@@ -0,0 +1,454 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A lazy-loading subscribers table model which only fetches the rows that
+ * are actually visible inside the view, in blocks.
+ */
+
+
+#include <algorithm>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <ctime>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <pqxx/pqxx>
+#include <Wt/WApplication>
+#include <Wt/WString>
+#include <CoreLib/CDate.hpp>
+#include <CoreLib/Database.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "CgiEnv.hpp"
+#include "CgiRoot.hpp"
+#include "Pool.hpp"
+#include "SubscribersModel.hpp"
+
+#define     BLOCK_SIZE              64
+#define     MAX_CACHED_BLOCKS       8
+#define     MAX_CACHED_DATES        4096
+#define     SECONDS_PER_DAY         86400
+
+using namespace std;
+using namespace boost;
+using namespace Wt;
+using namespace CoreLib;
+using namespace Service;
+
+struct SubscribersModel::Impl
+{
+public:
+    typedef std::vector<SubscribersModel::Row> Block;
+    typedef std::unordered_map<uint_fast64_t, Block> BlocksHashTable;
+
+public:
+    bool Farsi;
+
+    bool Lazy;
+    std::string Filter;
+    uint_fast64_t TotalRows;
+
+    /// Page mode
+    Block Rows;
+    uint_fast64_t Offset;
+    bool Numbered;
+
+    /// Lazy mode, least recently used blocks at the back
+    BlocksHashTable Blocks;
+    std::list<uint_fast64_t> BlocksUsage;
+
+    /// Formatted dates by day since epoch; a page of subscribers rarely
+    /// spans more than a handful of distinct days, and the Jalali
+    /// conversion is not something to redo for every cell
+    mutable std::unordered_map<int_fast64_t, Wt::WString> DatesCache;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    const SubscribersModel::Row *GetRow(const uint_fast64_t row);
+    const Block &GetBlock(const uint_fast64_t block);
+    void FetchBlock(const uint_fast64_t block, Block &out_rows);
+
+    void GetDate(const std::time_t timeSinceEpoch, Wt::WString &out_date) const;
+    void GetSubscriptionTypeName(const std::string &type, Wt::WString &out_name) const;
+    void GetNumber(const uint_fast64_t number, Wt::WString &out_number) const;
+};
+
+SubscribersModel::SubscribersModel(Wt::WObject *parent)
+    : WAbstractTableModel(parent),
+      m_pimpl(make_unique<SubscribersModel::Impl>())
+{
+    CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
+    CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
+
+    m_pimpl->Farsi = cgiEnv->GetInformation().Client.Language.Code
+            == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa;
+}
+
+SubscribersModel::~SubscribersModel() = default;
+
+const std::string &SubscribersModel::SelectColumns()
+{
+    static const std::string columns("inbox, uuid, subscription, pending_confirm, pending_cancel,"
+                                     " EXTRACT( EPOCH FROM join_date )::BIGINT AS join_date,"
+                                     " EXTRACT( EPOCH FROM update_date )::BIGINT AS update_date");
+    return columns;
+}
+
+void SubscribersModel::SetRows(std::vector<Row> &&rows, const uint_fast64_t offset, const bool numbered)
+{
+    m_pimpl->Lazy = false;
+    m_pimpl->Filter.clear();
+    m_pimpl->Blocks.clear();
+    m_pimpl->BlocksUsage.clear();
+
+    m_pimpl->Rows = std::move(rows);
+    m_pimpl->Offset = offset;
+    m_pimpl->Numbered = numbered;
+    m_pimpl->TotalRows = static_cast<uint_fast64_t>(m_pimpl->Rows.size());
+
+    this->reset();
+}
+
+void SubscribersModel::SetLazy(const std::string &filter, const uint_fast64_t totalRows)
+{
+    m_pimpl->Lazy = true;
+    m_pimpl->Filter = filter;
+    m_pimpl->Blocks.clear();
+    m_pimpl->BlocksUsage.clear();
+
+    m_pimpl->Rows.clear();
+    m_pimpl->Offset = 0;
+    m_pimpl->Numbered = true;
+    m_pimpl->TotalRows = totalRows;
+
+    this->reset();
+}
+
+int SubscribersModel::columnCount(const Wt::WModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return static_cast<int>(Column::Count);
+}
+
+int SubscribersModel::rowCount(const Wt::WModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return static_cast<int>(m_pimpl->TotalRows);
+}
+
+boost::any SubscribersModel::data(const Wt::WModelIndex &index, int role) const
+{
+    if (role != DisplayRole || !index.isValid())
+        return boost::any();
+
+    const uint_fast64_t r = static_cast<uint_fast64_t>(index.row());
+
+    const Row *row = m_pimpl->GetRow(r);
+    if (!row)
+        return boost::any();
+
+    WString value;
+
+    switch (static_cast<Column>(index.column())) {
+    case Column::No:
+        if (m_pimpl->Numbered)
+            m_pimpl->GetNumber(m_pimpl->Offset + r + 1, value);
+        break;
+    case Column::Inbox:
+        value = WString::fromUTF8(row->Inbox);
+        break;
+    case Column::Subscription:
+        m_pimpl->GetSubscriptionTypeName(row->Subscription, value);
+        break;
+    case Column::PendingConfirm:
+        m_pimpl->GetSubscriptionTypeName(row->PendingConfirm, value);
+        break;
+    case Column::PendingCancel:
+        m_pimpl->GetSubscriptionTypeName(row->PendingCancel, value);
+        break;
+    case Column::JoinDate:
+        m_pimpl->GetDate(row->JoinDate, value);
+        break;
+    case Column::UpdateDate:
+        m_pimpl->GetDate(row->UpdateDate, value);
+        break;
+    case Column::Uuid:
+        value = WString::fromUTF8(row->Uuid);
+        break;
+    case Column::Count:
+        return boost::any();
+    }
+
+    return boost::any(value);
+}
+
+boost::any SubscribersModel::headerData(int section, Wt::Orientation orientation, int role) const
+{
+    if (orientation != Horizontal || role != DisplayRole)
+        return boost::any();
+
+    switch (static_cast<Column>(section)) {
+    case Column::No:
+        return boost::any(tr("cms-subscribers-no"));
+    case Column::Inbox:
+        return boost::any(tr("cms-subscribers-inbox"));
+    case Column::Subscription:
+        return boost::any(tr("cms-subscribers-subscription"));
+    case Column::PendingConfirm:
+        return boost::any(tr("cms-subscribers-pending-confirm"));
+    case Column::PendingCancel:
+        return boost::any(tr("cms-subscribers-pending-cancel"));
+    case Column::JoinDate:
+        return boost::any(tr("cms-subscribers-join-date"));
+    case Column::UpdateDate:
+        return boost::any(tr("cms-subscribers-update-date"));
+    case Column::Uuid:
+        return boost::any(tr("cms-subscribers-uuid"));
+    case Column::Count:
+        break;
+    }
+
+    return boost::any();
+}
+
+SubscribersModel::Impl::Impl()
+    : Farsi(false),
+      Lazy(false),
+      TotalRows(0),
+      Offset(0),
+      Numbered(true)
+{
+
+}
+
+SubscribersModel::Impl::~Impl() = default;
+
+const SubscribersModel::Row *SubscribersModel::Impl::GetRow(const uint_fast64_t row)
+{
+    if (row >= TotalRows)
+        return nullptr;
+
+    if (!Lazy) {
+        return &Rows[row];
+    }
+
+    const Block &block = GetBlock(row / BLOCK_SIZE);
+    const uint_fast64_t index = row % BLOCK_SIZE;
+
+    /// The subscribers table has shrunk since we counted it
+    if (index >= block.size())
+        return nullptr;
+
+    return &block[index];
+}
+
+const SubscribersModel::Block &SubscribersModel::Impl::GetBlock(const uint_fast64_t block)
+{
+    auto it = Blocks.find(block);
+
+    if (it != Blocks.end()) {
+        BlocksUsage.remove(block);
+        BlocksUsage.push_front(block);
+        return it->second;
+    }
+
+    while (Blocks.size() >= MAX_CACHED_BLOCKS && !BlocksUsage.empty()) {
+        Blocks.erase(BlocksUsage.back());
+        BlocksUsage.pop_back();
+    }
+
+    Block &rows = Blocks[block];
+    FetchBlock(block, rows);
+    BlocksUsage.push_front(block);
+
+    return rows;
+}
+
+void SubscribersModel::Impl::FetchBlock(const uint_fast64_t block, Block &out_rows)
+{
+    out_rows.clear();
+
+    try {
+        auto conn = Pool::Database().Connection(CoreLib::Database::Intent::ReadOnly);
+        conn->activate();
+        pqxx::work txn(*conn.get());
+
+        /// Scrolling mostly moves block by block, so seek from a neighbour
+        /// block's boundary key whenever it's around, instead of using OFFSET
+        string seekPhrase;
+        string orderPhrase("ASC");
+        string offsetPhrase;
+
+        auto previous = block > 0 ? Blocks.find(block - 1) : Blocks.end();
+        auto next = Blocks.find(block + 1);
+
+        if (previous != Blocks.end() && previous->second.size() == BLOCK_SIZE) {
+            seekPhrase = (boost::format(" AND inbox > %1%") % txn.quote(previous->second.back().Inbox)).str();
+        } else if (next != Blocks.end() && !next->second.empty()) {
+            seekPhrase = (boost::format(" AND inbox < %1%") % txn.quote(next->second.front().Inbox)).str();
+            orderPhrase = "DESC";
+        } else {
+            offsetPhrase = (boost::format(" OFFSET %1%")
+                            % lexical_cast<string>(block * BLOCK_SIZE)).str();
+        }
+
+        string query((boost::format("SELECT %1%"
+                                    " FROM \"%2%\" WHERE %3%%4% ORDER BY inbox %5% LIMIT %6%%7%;")
+                      % SubscribersModel::SelectColumns()
+                      % txn.esc(Pool::Database().GetTableName("SUBSCRIBERS"))
+                      % Filter
+                      % seekPhrase
+                      % orderPhrase
+                      % lexical_cast<string>(BLOCK_SIZE)
+                      % offsetPhrase).str());
+        LOG_INFO("Running query...", query);
+
+        pqxx::result r = txn.exec(query);
+
+        txn.commit();
+
+        out_rows.reserve(r.size());
+
+        for (const auto &row : r) {
+            SubscribersModel::Row s;
+            s.Inbox.assign(row["inbox"].c_str());
+            s.Uuid.assign(row["uuid"].c_str());
+            s.Subscription.assign(row["subscription"].c_str());
+            s.PendingConfirm.assign(row["pending_confirm"].c_str());
+            s.PendingCancel.assign(row["pending_cancel"].c_str());
+            s.JoinDate = row["join_date"].as<std::time_t>();
+            s.UpdateDate = row["update_date"].as<std::time_t>();
+            out_rows.push_back(std::move(s));
+        }
+
+        if (orderPhrase == "DESC") {
+            std::reverse(out_rows.begin(), out_rows.end());
+        }
+    }
+
+    catch (const pqxx::sql_error &ex) {
+        LOG_ERROR(ex.what(), ex.query());
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex));
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR);
+    }
+}
+
+void SubscribersModel::Impl::GetDate(const std::time_t timeSinceEpoch, Wt::WString &out_date) const
+{
+    /// Floor division, so that pre-epoch dates land on the right day
+    int_fast64_t daysSinceEpoch = static_cast<int_fast64_t>(timeSinceEpoch) / SECONDS_PER_DAY;
+    if (static_cast<int_fast64_t>(timeSinceEpoch) % SECONDS_PER_DAY < 0)
+        --daysSinceEpoch;
+
+    auto it = DatesCache.find(daysSinceEpoch);
+    if (it != DatesCache.end()) {
+        out_date = it->second;
+        return;
+    }
+
+    try {
+        const std::time_t tt = static_cast<std::time_t>(daysSinceEpoch * SECONDS_PER_DAY);
+
+        struct tm utc_tm;
+        if (gmtime_r(&tt, &utc_tm) == nullptr)
+            throw std::runtime_error("gmtime_r");
+
+        int year = utc_tm.tm_year + 1900;
+        int month = utc_tm.tm_mon + 1;
+        int day = utc_tm.tm_mday;
+
+        if (!Farsi) {
+            out_date = (boost::wformat(L"%1%/%2%/%3%")
+                        % lexical_cast<wstring>(year)
+                        % lexical_cast<wstring>(month)
+                        % lexical_cast<wstring>(day)).str();
+        } else {
+            char date[CDate::DateConv::BUFFER_SIZE];
+            char persian[CDate::DateConv::BUFFER_SIZE];
+            out_date = WString::fromUTF8(
+                        std::string(persian, CDate::DateConv::FormatToPersianNums(
+                                        date, CDate::DateConv::ToJalali(year, month, day, date), persian)));
+        }
+    } catch (...) {
+        out_date = L"-";
+    }
+
+    if (DatesCache.size() >= MAX_CACHED_DATES)
+        DatesCache.clear();
+
+    DatesCache.emplace(daysSinceEpoch, out_date);
+}
+
+void SubscribersModel::Impl::GetSubscriptionTypeName(const std::string &type, Wt::WString &out_name) const
+{
+    static const std::string EN_FA_TYPE("en_fa");
+    static const std::string EN_TYPE("en");
+    static const std::string FA_TYPE("fa");
+    static const std::string NONE_TYPE("none");
+
+    if (type == EN_FA_TYPE) {
+        out_name = WString::tr("cms-subscribers-subscription-en-fa");
+    } else if (type == EN_TYPE) {
+        out_name = WString::tr("cms-subscribers-subscription-en");
+    } else if (type == FA_TYPE) {
+        out_name = WString::tr("cms-subscribers-subscription-fa");
+    } else if (type == NONE_TYPE) {
+        out_name = WString::tr("cms-subscribers-subscription-none");
+    }
+}
+
+void SubscribersModel::Impl::GetNumber(const uint_fast64_t number, Wt::WString &out_number) const
+{
+    if (!Farsi) {
+        out_number = WString(lexical_cast<wstring>(number));
+    } else {
+        out_number = WString(CDate::DateConv::FormatToPersianNums(lexical_cast<wstring>(number)));
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A lazy-loading subscribers table model which only fetches the rows that
+ * are actually visible inside the view, in blocks.
+ */
+
+
+#ifndef SERVICE_SUBSCRIBERS_MODEL_HPP
+#define SERVICE_SUBSCRIBERS_MODEL_HPP
+
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+#include <Wt/WAbstractTableModel>
+
+namespace Service {
+class SubscribersModel;
+}
+
+class Service::SubscribersModel : public Wt::WAbstractTableModel
+{
+public:
+    enum class Column : int {
+        No,
+        Inbox,
+        Subscription,
+        PendingConfirm,
+        PendingCancel,
+        JoinDate,
+        UpdateDate,
+        Uuid,
+        Count
+    };
+
+    struct Row
+    {
+        std::string Inbox;
+        std::string Uuid;
+        std::string Subscription;
+        std::string PendingConfirm;
+        std::string PendingCancel;
+        std::time_t JoinDate;
+        std::time_t UpdateDate;
+    };
+
+    /// The select list every reader of the subscribers table should use, so
+    /// that the TIMESTAMPTZ columns come back as seconds since epoch
+    static const std::string &SelectColumns();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    explicit SubscribersModel(Wt::WObject *parent = 0);
+    virtual ~SubscribersModel() override;
+
+public:
+    /// Serves the given rows only, e.g. a single page; rows are left
+    /// unnumbered when the offset of the page is not known
+    void SetRows(std::vector<Row> &&rows, const uint_fast64_t offset, const bool numbered);
+
+    /// Serves every row matching the filter, fetching blocks of rows on demand
+    void SetLazy(const std::string &filter, const uint_fast64_t totalRows);
+
+    virtual int columnCount(const Wt::WModelIndex &parent = Wt::WModelIndex()) const override;
+    virtual int rowCount(const Wt::WModelIndex &parent = Wt::WModelIndex()) const override;
+
+    virtual boost::any data(const Wt::WModelIndex &index, int role = Wt::DisplayRole) const override;
+    virtual boost::any headerData(int section,
+                                  Wt::Orientation orientation = Wt::Horizontal,
+                                  int role = Wt::DisplayRole) const override;
+};
+
+
+#endif /* SERVICE_SUBSCRIBERS_MODEL_HPP */
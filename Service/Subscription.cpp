@@ -36,7 +36,6 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/format.hpp>
-#include <boost/regex.hpp>
 #include <pqxx/pqxx>
 #include <Wt/WApplication>
 #include <Wt/WCheckBox>
@@ -53,18 +52,17 @@
 #include <Wt/WText>
 #include <Wt/WTextArea>
 #include <CoreLib/CDate.hpp>
-#include <CoreLib/Crypto.hpp>
 #include <CoreLib/Database.hpp>
 #include <CoreLib/FileSystem.hpp>
 #include <CoreLib/Log.hpp>
-#include <CoreLib/Mail.hpp>
 #include <CoreLib/make_unique.hpp>
-#include <CoreLib/Random.hpp>
+#include <CoreLib/Validate.hpp>
 #include "Captcha.hpp"
 #include "CgiEnv.hpp"
 #include "CgiRoot.hpp"
 #include "Div.hpp"
 #include "Pool.hpp"
+#include "Subscriber.hpp"
 #include "Subscription.hpp"
 
 using namespace std;
@@ -77,14 +75,6 @@ using namespace Service;
 
 struct Subscription::Impl : public Wt::WObject
 {
-public:
-    enum class Message : unsigned char {
-        Confirm,
-        Confirmed,
-        Cancel,
-        Cancelled
-    };
-
 public:
     Wt::WLineEdit *EmailLineEdit;
     Wt::WCheckBox *EnContentsCheckBox;
@@ -118,8 +108,8 @@ public:
     Wt::WWidget *GetCancellationPage();
 
     void GetMessageTemplate(WTemplate *tmpl, const Wt::WString &title, const Wt::WString &message);
-
-    void SendMessage(const Message &type, const string &uuid, const string &inbox);
+    void GetMessageTemplate(WTemplate *tmpl, const Wt::WString &title, const Wt::WString &message,
+                            const string &homePageUrl, const string &homePageTitle);
 };
 
 Subscription::Subscription() :
@@ -239,8 +229,6 @@ void Subscription::Impl::OnSubscribeFormSubmitted()
             }
         }
 
-        CDate::Now n(CDate::Timezone::UTC);
-        string date(lexical_cast<std::string>(n.RawTime()));
         string inbox(EmailLineEdit->text().trim().toUTF8());
 
         string pendingConfirm;
@@ -254,53 +242,11 @@ void Subscription::Impl::OnSubscribeFormSubmitted()
             pendingConfirm = "none";
         }
 
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        string query((boost::format("SELECT uuid FROM \"%1%\""
-                                    " WHERE inbox = %2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
-                      % txn.quote(inbox)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-        result r = txn.exec(query);
-
-        string uuid;
-
-        if (r.empty()) {
-            while (true) {
-                CoreLib::Random::Uuid(uuid);
-
-                query.assign((boost::format("SELECT inbox FROM \"%1%\""
-                                            " WHERE uuid = %2%;")
-                              % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
-                              % txn.quote(uuid)).str());
-                LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-                r = txn.exec(query);
-
-                if (r.empty()) {
-                    break;
-                }
-            }
-
-            Pool::Database().Insert("SUBSCRIBERS",
-                                    "inbox, uuid, subscription, pending_confirm, pending_cancel, join_date, update_date",
-            { inbox, uuid, "none", pendingConfirm, "none", date, date });
-        } else {
-            const pqxx::row row(r[0]);
-            uuid.assign(row["uuid"].c_str());
-
-            Pool::Database().Update("SUBSCRIBERS",
-                                    "inbox",
-                                    inbox,
-                                    "pending_confirm=?, pending_cancel=?",
-            { pendingConfirm, "none" });
+        if (Subscriber::Subscribe(cgiEnv->GetInformation(), inbox, pendingConfirm)
+                != Subscriber::Result::Done) {
+            return;
         }
 
-        SendMessage(Message::Confirm, uuid, inbox);
-
         MessageBox = std::make_unique<WMessageBox>(tr("home-subscription-subscribe-success-dialog-title"),
                                                    tr("home-subscription-subscribe-success-dialog-message"),
                                                    Information, NoButton);
@@ -365,19 +311,9 @@ void Subscription::Impl::OnUnsubscribeFormSubmitted()
             pending_cancel = "none";
         }
 
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        string query((boost::format("SELECT inbox FROM \"%1%\""
-                                    " WHERE inbox = %2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
-                      % txn.quote(inbox)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-        result r = txn.exec(query);
+        Subscriber::Result rc = Subscriber::Unsubscribe(cgiEnv->GetInformation(), inbox, pending_cancel);
 
-        if (r.empty()) {
+        if (rc == Subscriber::Result::InvalidRecipient) {
             MessageBox = std::make_unique<WMessageBox>(tr("home-subscription-invalid-recipient-id-title"),
                                                        tr("home-subscription-invalid-recipient-id-message"),
                                                        Information, NoButton);
@@ -387,17 +323,11 @@ void Subscription::Impl::OnUnsubscribeFormSubmitted()
 
             this->GenerateCaptcha();
 
+            return;
+        } else if (rc != Subscriber::Result::Done) {
             return;
         }
 
-        Pool::Database().Update("SUBSCRIBERS",
-                                "inbox",
-                                inbox,
-                                "pending_cancel=?",
-        { pending_cancel });
-
-        SendMessage(Message::Cancel, cgiEnv->GetInformation().Subscription.Uuid, inbox);
-
         MessageBox = std::make_unique<WMessageBox>(tr("home-subscription-unsubscribe-success-dialog-title"),
                                                    tr("home-subscription-unsubscribe-success-dialog-message"),
                                                    Information, NoButton);
@@ -471,9 +401,7 @@ Wt::WWidget *Subscription::Impl::GetSubscribeForm()
 
             if (cgiEnv->GetInformation().Subscription.Subscribe
                     == CgiEnv::InformationRecord::SubscriptionRecord::Action::Subscribe) {
-                static const regex REGEX_EMAIL(Pool::Storage().RegexEmail());
-                smatch result;
-                if (regex_search(cgiEnv->GetInformation().Subscription.Inbox, result, REGEX_EMAIL)) {
+                if (CoreLib::Validate::ContainsEmail(cgiEnv->GetInformation().Subscription.Inbox)) {
                     EmailLineEdit->setText(WString::fromUTF8(cgiEnv->GetInformation().Subscription.Inbox));
                 }
             }
@@ -597,46 +525,40 @@ Wt::WWidget *Subscription::Impl::GetConfirmationPage()
     tmpl->setStyleClass("container-table");
 
     try {
-        static const regex REGEX_UUID(Pool::Storage().RegexUuid());
-        smatch result;
-        if (cgiEnv->GetInformation().Subscription.Uuid == ""
-                || !regex_search(cgiEnv->GetInformation().Subscription.Uuid, result, REGEX_UUID)) {
-            cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
-            this->GetMessageTemplate(tmpl,
-                                     tr("home-subscription-invalid-recipient-id-title"),
-                                     tr("home-subscription-invalid-recipient-id-message"));
-            return tmpl;
+        string htmlData;
+        string file;
+        if (cgiEnv->GetInformation().Client.Language.Code
+                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
+            file = "../templates/home-subscription-confirmation-fa.wtml";
+        } else {
+            file = "../templates/home-subscription-confirmation.wtml";
         }
 
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        string query((boost::format("SELECT inbox, subscription, pending_confirm FROM \"%1%\""
-                                    " WHERE uuid = %2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
-                      % txn.quote(cgiEnv->GetInformation().Subscription.Uuid)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+        /// Never act on the link without a page to tell the outcome with
+        if (!CoreLib::FileSystem::Read(file, htmlData)) {
+            LOG_ERROR("Cannot read the template file!", file, cgiEnv->GetInformation().ToJson());
+            return tmpl;
+        }
 
-        pqxx::result r = txn.exec(query);
+        string inbox;
+        string subscription;
 
-        if (r.empty()) {
+        switch (Subscriber::Confirm(cgiEnv->GetInformation(), inbox, subscription)) {
+        case Subscriber::Result::Done:
+            break;
+        case Subscriber::Result::InvalidRecipient:
             cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
             this->GetMessageTemplate(tmpl,
                                      tr("home-subscription-invalid-recipient-id-title"),
                                      tr("home-subscription-invalid-recipient-id-message"));
             return tmpl;
-        }
-
-        CDate::Now n(CDate::Timezone::UTC);
-        string date(lexical_cast<std::string>(n.RawTime()));
-
-        const pqxx::row row(r[0]);
-        const string inbox(row["inbox"].c_str());
-        const string subscription(row["subscription"].c_str());
-        const string pendingConfirm(row["pending_confirm"].c_str());
-
-        if (pendingConfirm == "none" && subscription == "none") {
+        case Subscriber::Result::Expired:
+            cgiRoot->setTitle(tr("home-subscription-token-has-expired-title"));
+            this->GetMessageTemplate(tmpl,
+                                     tr("home-subscription-token-has-expired-title"),
+                                     tr("home-subscription-token-has-expired-message"));
+            return tmpl;
+        case Subscriber::Result::NothingPending:
             cgiEnv->SetSubscriptionAction(CgiEnv::InformationRecord::SubscriptionRecord::Action::Subscribe);
             cgiEnv->SetSubscriptionInbox(inbox);
 
@@ -659,88 +581,28 @@ Wt::WWidget *Subscription::Impl::GetConfirmationPage()
             cgiRoot->setTitle(tr("home-subscription-subscribe-page-title"));
 
             return GetSubscribeForm();
-        } else if (pendingConfirm == "none") {
+        case Subscriber::Result::AlreadyDone:
             cgiRoot->setTitle(tr("home-subscription-confirmation-already-confirmed-title"));
             this->GetMessageTemplate(tmpl,
                                      tr("home-subscription-confirmation-already-confirmed-title"),
                                      tr("home-subscription-confirmation-already-confirmed-message"));
             return tmpl;
+        case Subscriber::Result::Failed:
+            return tmpl;
         }
 
-        string htmlData;
-        string file;
-        if (cgiEnv->GetInformation().Client.Language.Code
-                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-            file = "../templates/home-subscription-confirmation-fa.wtml";
-        } else {
-            file = "../templates/home-subscription-confirmation.wtml";
-        }
-
-        if (CoreLib::FileSystem::Read(file, htmlData)) {
-            /// Fill the template
-            tmpl->setTemplateText(WString::fromUTF8(htmlData), TextFormat::XHTMLUnsafeText);
-
-            string finalSubscription;
-
-            if (subscription == "none") {
-                finalSubscription = pendingConfirm;
-            } else if (subscription == "en_fa") {
-                finalSubscription = subscription;
-            } else if (subscription == "en") {
-                if (pendingConfirm == "fa") {
-                    finalSubscription = "en_fa";
-                } else {
-                    finalSubscription = subscription;
-                }
-            } else if (subscription == "fa") {
-                if (pendingConfirm == "en") {
-                    finalSubscription = "en_fa";
-                } else {
-                    finalSubscription = subscription;
-                }
-            } else {
-                finalSubscription = "en_fa";
-            }
-
-            Pool::Database().Update("SUBSCRIBERS",
-                                    "inbox",
-                                    inbox,
-                                    "subscription=?, pending_confirm=?, pending_cancel=?, update_date=?",
-            { finalSubscription, "none", "none", date });
-
-            SendMessage(Message::Confirmed, cgiEnv->GetInformation().Subscription.Uuid, inbox);
-
-            tmpl->bindString("title", tr("home-subscription-confirmation-congratulation-title"));
-            tmpl->bindString("message", tr("home-subscription-confirmation-congratulation-message"));
-
-            string homePageFields;
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                homePageFields = "homepage_url_fa, homepage_title_fa";
-            } else {
-                homePageFields = "homepage_url_en, homepage_title_en";
-            }
-
-            query.assign((boost::format("SELECT %1% FROM \"%2%\""
-                                        " WHERE pseudo_id = '0';")
-                          % homePageFields
-                          % txn.esc(Service::Pool::Database().GetTableName("SETTINGS"))).str());
-            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+        string homePageUrl;
+        string homePageTitle;
+        Subscriber::GetHomePage(cgiEnv->GetInformation(), homePageUrl, homePageTitle);
 
-            r = txn.exec(query);
+        /// Fill the template
+        tmpl->setTemplateText(WString::fromUTF8(htmlData), TextFormat::XHTMLUnsafeText);
 
-            if (!r.empty()) {
-                const string homePageUrl(r[0][0].c_str());
-                const string homePageTitle(r[0][1].c_str());
+        tmpl->bindString("title", tr("home-subscription-confirmation-congratulation-title"));
+        tmpl->bindString("message", tr("home-subscription-confirmation-congratulation-message"));
 
-                tmpl->bindString("home-page-url", WString::fromUTF8(homePageUrl));
-                tmpl->bindString("home-page-title", WString::fromUTF8(homePageTitle));
-            }
-        }
-    }
-
-    catch (const pqxx::sql_error &ex) {
-        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
+        tmpl->bindString("home-page-url", WString::fromUTF8(homePageUrl));
+        tmpl->bindString("home-page-title", WString::fromUTF8(homePageTitle));
     }
 
     catch (const boost::exception &ex) {
@@ -773,40 +635,45 @@ Wt::WWidget *Subscription::Impl::GetUnsubscribeForm()
     tmpl->setStyleClass("container-table");
 
     try {
-        static const regex REGEX_UUID(Pool::Storage().RegexUuid());
-        smatch result;
-        if (cgiEnv->GetInformation().Subscription.Uuid == ""
-                || !regex_search(cgiEnv->GetInformation().Subscription.Uuid, result, REGEX_UUID)) {
-            cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
-            this->GetMessageTemplate(tmpl,
-                                     tr("home-subscription-invalid-recipient-id-title"),
-                                     tr("home-subscription-invalid-recipient-id-message"));
-            return tmpl;
-        }
+        /// Unsigned links from newsletters sent before links were signed, as
+        /// well as forged or expired ones, still get the form; only with an
+        /// empty recipient. The captcha stands guard and the cancellation
+        /// has to be confirmed from the inbox anyway.
+        CDate::Now n(CDate::Timezone::UTC);
+        const bool anonymous = !CoreLib::Validate::Uuid(cgiEnv->GetInformation().Subscription.Uuid)
+                || cgiEnv->GetInformation().Subscription.Timestamp < n.RawTime();
 
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
+        string inbox;
+        string subscription;
 
-        string query((boost::format("SELECT inbox, subscription FROM \"%1%\""
-                                    " WHERE uuid = %2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
-                      % txn.quote(cgiEnv->GetInformation().Subscription.Uuid)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+        if (!anonymous) {
+            auto conn = Pool::Database().Connection();
+            conn->activate();
+            pqxx::work txn(*conn.get());
 
-        pqxx::result r = txn.exec(query);
+            string query((boost::format("SELECT inbox, subscription FROM \"%1%\""
+                                        " WHERE uuid = %2%;")
+                          % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
+                          % txn.quote(cgiEnv->GetInformation().Subscription.Uuid)).str());
+            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
 
-        if (r.empty()) {
-            cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
-            this->GetMessageTemplate(tmpl,
-                                     tr("home-subscription-invalid-recipient-id-title"),
-                                     tr("home-subscription-invalid-recipient-id-message"));
-            return tmpl;
-        }
+            pqxx::result r = txn.exec(query);
+
+            if (r.empty()) {
+                cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
+                this->GetMessageTemplate(tmpl,
+                                         tr("home-subscription-invalid-recipient-id-title"),
+                                         tr("home-subscription-invalid-recipient-id-message"));
+                return tmpl;
+            }
 
-        const pqxx::row row(r[0]);
-        const string inbox(row["inbox"].c_str());
-        const string subscription(row["subscription"].c_str());
+            const pqxx::row row(r[0]);
+            inbox.assign(row["inbox"].c_str());
+            subscription.assign(row["subscription"].c_str());
+        } else {
+            /// Whatever they are subscribed to, both are on offer
+            subscription.assign("en_fa");
+        }
 
         if (subscription == "none") {
             cgiRoot->setTitle(tr("home-subscription-unsubscribe-already-unsubscribed-title"));
@@ -835,10 +702,9 @@ Wt::WWidget *Subscription::Impl::GetUnsubscribeForm()
             emailValidator->setFlags(MatchCaseInsensitive);
             emailValidator->setMandatory(true);
             EmailLineEdit->setValidator(emailValidator);
-            EmailLineEdit->setReadOnly(true);
+            EmailLineEdit->setReadOnly(!anonymous);
 
-            static const regex REGEX_EMAIL(Pool::Storage().RegexEmail());
-            if (regex_search(inbox, result, REGEX_EMAIL)) {
+            if (CoreLib::Validate::ContainsEmail(inbox)) {
                 EmailLineEdit->setText(WString::fromUTF8(inbox));
             }
 
@@ -997,140 +863,67 @@ Wt::WWidget *Subscription::Impl::GetCancellationPage()
     tmpl->setStyleClass("container-table");
 
     try {
-        static const regex REGEX_UUID(Pool::Storage().RegexUuid());
-        smatch result;
-        if (cgiEnv->GetInformation().Subscription.Uuid == ""
-                || !regex_search(cgiEnv->GetInformation().Subscription.Uuid, result, REGEX_UUID)) {
-            cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
-            this->GetMessageTemplate(tmpl,
-                                     tr("home-subscription-invalid-recipient-id-title"),
-                                     tr("home-subscription-invalid-recipient-id-message"));
-            return tmpl;
+        string htmlData;
+        string file;
+        if (cgiEnv->GetInformation().Client.Language.Code
+                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
+            file = "../templates/home-subscription-cancellation-fa.wtml";
+        } else {
+            file = "../templates/home-subscription-cancellation.wtml";
         }
 
-        auto conn = Pool::Database().Connection();
-        conn->activate();
-        pqxx::work txn(*conn.get());
-
-        string query((boost::format("SELECT inbox, subscription, pending_cancel FROM \"%1%\""
-                                    " WHERE uuid = %2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("SUBSCRIBERS"))
-                      % txn.quote(cgiEnv->GetInformation().Subscription.Uuid)).str());
-        LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+        /// Never act on the link without a page to tell the outcome with
+        if (!CoreLib::FileSystem::Read(file, htmlData)) {
+            LOG_ERROR("Cannot read the template file!", file, cgiEnv->GetInformation().ToJson());
+            return tmpl;
+        }
 
-        pqxx::result r = txn.exec(query);
+        string inbox;
+        string subscription;
 
-        if (r.empty()) {
+        switch (Subscriber::Cancel(cgiEnv->GetInformation(), inbox, subscription)) {
+        case Subscriber::Result::Done:
+            break;
+        case Subscriber::Result::InvalidRecipient:
             cgiRoot->setTitle(tr("home-subscription-invalid-recipient-id-title"));
             this->GetMessageTemplate(tmpl,
                                      tr("home-subscription-invalid-recipient-id-title"),
                                      tr("home-subscription-invalid-recipient-id-message"));
             return tmpl;
-        }
-
-        CDate::Now n(CDate::Timezone::UTC);
-        string date(lexical_cast<std::string>(n.RawTime()));
-
-        if (cgiEnv->GetInformation().Subscription.Timestamp == 0
-                || (n.RawTime() - cgiEnv->GetInformation().Subscription.Timestamp) >= Pool::Storage().TokenLifespan()) {
+        case Subscriber::Result::Expired:
             cgiRoot->setTitle(tr("home-subscription-token-has-expired-title"));
             this->GetMessageTemplate(tmpl,
                                      tr("home-subscription-token-has-expired-title"),
                                      tr("home-subscription-token-has-expired-message"));
             return tmpl;
-        }
-
-        const pqxx::row row(r[0]);
-        const string inbox(row["inbox"].c_str());
-        const string subscription(row["subscription"].c_str());
-        const string pendingCancel(row["pending_cancel"].c_str());
-
-        if (pendingCancel == "none" && subscription == "none") {
+        case Subscriber::Result::AlreadyDone:
             cgiRoot->setTitle(tr("home-subscription-cancellation-cancelled-title"));
             this->GetMessageTemplate(tmpl,
                                      tr("home-subscription-cancellation-already-cancelled-title"),
                                      tr("home-subscription-cancellation-already-cancelled-message"));
             return tmpl;
-        } else if (pendingCancel == "none") {
+        case Subscriber::Result::NothingPending:
             cgiRoot->setTitle(tr("home-subscription-cancellation-invalid-request-title"));
             this->GetMessageTemplate(tmpl,
                                      tr("home-subscription-cancellation-invalid-request-title"),
                                      tr("home-subscription-cancellation-invalid-request-message"));
             return tmpl;
+        case Subscriber::Result::Failed:
+            return tmpl;
         }
 
-        string htmlData;
-        string file;
-        if (cgiEnv->GetInformation().Client.Language.Code
-                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-            file = "../templates/home-subscription-cancellation-fa.wtml";
-        } else {
-            file = "../templates/home-subscription-cancellation.wtml";
-        }
-
-        if (CoreLib::FileSystem::Read(file, htmlData)) {
-            /// Fill the template
-            tmpl->setTemplateText(WString::fromUTF8(htmlData), TextFormat::XHTMLUnsafeText);
-
-            string finalSubscription;
-
-            if (pendingCancel == "en_fa") {
-                finalSubscription = "none";
-            } else if (pendingCancel == "en") {
-                if (subscription == "en_fa" || subscription == "fa") {
-                    finalSubscription = "fa";
-                } else {
-                    finalSubscription = "none";
-                }
-            } else if (pendingCancel == "fa") {
-                if (subscription == "en_fa" || subscription == "en") {
-                    finalSubscription = "en";
-                } else {
-                    finalSubscription = "none";
-                }
-            } else {
-                finalSubscription = "none";
-            }
-
-            Pool::Database().Update("SUBSCRIBERS",
-                                    "inbox",
-                                    inbox,
-                                    "subscription=?, pending_cancel=?, update_date=?",
-            { finalSubscription, "none", date });
-
-            SendMessage(Message::Cancelled, cgiEnv->GetInformation().Subscription.Uuid, inbox);
-
-            tmpl->bindString("title", tr("home-subscription-cancellation-cancelled-title"));
-            tmpl->bindString("message", tr("home-subscription-cancellation-cancelled-message"));
-
-            string homePageFields;
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                homePageFields = "homepage_url_fa, homepage_title_fa";
-            } else {
-                homePageFields = "homepage_url_en, homepage_title_en";
-            }
-
-            query.assign((boost::format("SELECT %1% FROM \"%2%\""
-                                        " WHERE pseudo_id = '0';")
-                          % homePageFields
-                          % txn.esc(Service::Pool::Database().GetTableName("SETTINGS"))).str());
-            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
+        string homePageUrl;
+        string homePageTitle;
+        Subscriber::GetHomePage(cgiEnv->GetInformation(), homePageUrl, homePageTitle);
 
-            r = txn.exec(query);
+        /// Fill the template
+        tmpl->setTemplateText(WString::fromUTF8(htmlData), TextFormat::XHTMLUnsafeText);
 
-            if (!r.empty()) {
-                const string homePageUrl(r[0][0].c_str());
-                const string homePageTitle(r[0][1].c_str());
+        tmpl->bindString("title", tr("home-subscription-cancellation-cancelled-title"));
+        tmpl->bindString("message", tr("home-subscription-cancellation-cancelled-message"));
 
-                tmpl->bindString("home-page-url", WString::fromUTF8(homePageUrl));
-                tmpl->bindString("home-page-title", WString::fromUTF8(homePageTitle));
-            }
-        }
-    }
-
-    catch (const pqxx::sql_error &ex) {
-        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
+        tmpl->bindString("home-page-url", WString::fromUTF8(homePageUrl));
+        tmpl->bindString("home-page-title", WString::fromUTF8(homePageTitle));
     }
 
     catch (const boost::exception &ex) {
@@ -1153,277 +946,41 @@ void Subscription::Impl::GetMessageTemplate(WTemplate *tmpl, const Wt::WString &
     CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
-    try {
-        string htmlData;
-        string file;
-        if (cgiEnv->GetInformation().Client.Language.Code
-                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-            file = "../templates/home-subscription-message-template-fa.wtml";
-        } else {
-            file = "../templates/home-subscription-message-template.wtml";
-        }
-
-        if (CoreLib::FileSystem::Read(file, htmlData)) {
-            /// Fill the template
-            tmpl->setTemplateText(WString::fromUTF8(htmlData), TextFormat::XHTMLUnsafeText);
-
-            tmpl->bindString("title", title);
-            tmpl->bindString("message", message);
-
-            string homePageFields;
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                homePageFields = "homepage_url_fa, homepage_title_fa";
-            } else {
-                homePageFields = "homepage_url_en, homepage_title_en";
-            }
-
-            auto conn = Pool::Database().Connection();
-            conn->activate();
-            pqxx::work txn(*conn.get());
+    string homePageUrl;
+    string homePageTitle;
+    Subscriber::GetHomePage(cgiEnv->GetInformation(), homePageUrl, homePageTitle);
 
-            string query((boost::format("SELECT %1% FROM \"%2%\""
-                                        " WHERE pseudo_id = '0';")
-                          % homePageFields
-                          % txn.esc(Service::Pool::Database().GetTableName("SETTINGS"))).str());
-            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-            result r = txn.exec(query);
-
-            if (!r.empty()) {
-                const pqxx::row row(r[0]);
-                const string homePageUrl(row[0].c_str());
-                const string homePageTitle(row[1].c_str());
-
-                tmpl->bindString("home-page-url", WString::fromUTF8(homePageUrl));
-                tmpl->bindString("home-page-title", WString::fromUTF8(homePageTitle));
-            }
-        }
-    }
-
-    catch (const pqxx::sql_error &ex) {
-        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
-    }
-
-    catch (const boost::exception &ex) {
-        LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
-    }
-
-    catch (const std::exception &ex) {
-        LOG_ERROR(ex.what(), cgiEnv->GetInformation().ToJson());
-    }
-
-    catch (...) {
-        LOG_ERROR(UNKNOWN_ERROR, cgiEnv->GetInformation().ToJson());
-    }
+    GetMessageTemplate(tmpl, title, message, homePageUrl, homePageTitle);
 }
 
-void Subscription::Impl::SendMessage(const Message &type, const string &uuid, const string &inbox)
+void Subscription::Impl::GetMessageTemplate(WTemplate *tmpl, const Wt::WString &title, const Wt::WString &message,
+                                            const string &homePageUrl, const string &homePageTitle)
 {
     CgiRoot *cgiRoot = static_cast<CgiRoot *>(WApplication::instance());
     CgiEnv *cgiEnv = cgiRoot->GetCgiEnvInstance();
 
     try {
-        CDate::Now n(CDate::Timezone::UTC);
-
         string htmlData;
         string file;
         if (cgiEnv->GetInformation().Client.Language.Code
                 == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-            switch (type) {
-            case Message::Confirm:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-confirm-subscription-fa-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-confirm-subscription-fa.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            case Message::Confirmed:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-subscription-confirmed-fa-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-subscription-confirmed-fa.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            case Message::Cancel:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-cancel-subscription-fa-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-cancel-subscription-fa.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            case Message::Cancelled:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-subscription-cancelled-fa-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-subscription-cancelled-fa.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            }
+            file = "../templates/home-subscription-message-template-fa.wtml";
         } else {
-            switch (type) {
-            case Message::Confirm:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-confirm-subscription-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-confirm-subscription.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            case Message::Confirmed:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-subscription-confirmed-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-subscription-confirmed.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            case Message::Cancel:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-cancel-subscription-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-cancel-subscription.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            case Message::Cancelled:
-#if GDPR_COMPLIANCE
-                file = "../templates/email-subscription-cancelled-gdpr-compliant.wtml";
-#else
-                file = "../templates/email-subscription-cancelled.wtml";
-#endif // GDPR_COMPLIANCE                file = "../templates/email-confirm-subscription-fa.wtml";
-                break;
-            }
+            file = "../templates/home-subscription-message-template.wtml";
         }
 
         if (CoreLib::FileSystem::Read(file, htmlData)) {
-            string subject;
-
-            switch (type) {
-            case Message::Confirm:
-                subject = (format(tr("email-subject-confirm-subscription").toUTF8())
-                           % cgiEnv->GetInformation().Server.Hostname).str();
-                break;
-            case Message::Confirmed:
-                subject = (format(tr("email-subject-subscription-confirmed").toUTF8())
-                           % cgiEnv->GetInformation().Server.Hostname).str();
-                break;
-            case Message::Cancel:
-                subject = (format(tr("email-subject-cancel-subscription").toUTF8())
-                           % cgiEnv->GetInformation().Server.Hostname).str();
-                break;
-            case Message::Cancelled:
-                subject = (format(tr("email-subject-subscription-cancelled").toUTF8())
-                           % cgiEnv->GetInformation().Server.Hostname).str();
-                break;
-            }
-
-#if !(GDPR_COMPLIANCE)
-            replace_all(htmlData, "${client-ip}",
-                        cgiEnv->GetInformation().Client.IPAddress);
-            replace_all(htmlData, "${client-user-agent}",
-                        cgiEnv->GetInformation().Client.UserAgent);
-            replace_all(htmlData, "${client-referer}",
-                        cgiEnv->GetInformation().Client.Referer);
-
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                replace_all(htmlData, "${time}",
-                            (format("%1% ~ %2%")
-                             % WString(DateConv::FormatToPersianNums(DateConv::ToJalali(n))).toUTF8()
-                             % algorithm::trim_copy(DateConv::DateTimeString(n))).str());
-            } else {
-                replace_all(htmlData, "${time}",
-                            algorithm::trim_copy(DateConv::DateTimeString(n)));
-            }
-
-            replace_all(htmlData, "${client-location-country-code}",
-                        cgiEnv->GetInformation().Client.GeoLocation.CountryCode);
-            replace_all(htmlData, "${client-location-country-name}",
-                        cgiEnv->GetInformation().Client.GeoLocation.CountryName);
-            replace_all(htmlData, "${client-location-region}",
-                        cgiEnv->GetInformation().Client.GeoLocation.Region);
-            replace_all(htmlData, "${client-location-city}",
-                        cgiEnv->GetInformation().Client.GeoLocation.City);
-            replace_all(htmlData, "${client-location-postal-code}",
-                        cgiEnv->GetInformation().Client.GeoLocation.PostalCode);
-            replace_all(htmlData, "${client-location-latitude}",
-                        lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Latitude));
-            replace_all(htmlData, "${client-location-longitude}",
-                        lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.Longitude));
-            replace_all(htmlData, "${client-location-metro-code}",
-                        lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.MetroCode));
-            replace_all(htmlData, "${client-location-continent-code}",
-                        cgiEnv->GetInformation().Client.GeoLocation.ContinentCode);
-            replace_all(htmlData, "${client-location-asn}",
-                        lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.ASN));
-            replace_all(htmlData, "${client-location-aso}",
-                        lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.ASO));
-            replace_all(htmlData, "${client-location-raw-data}",
-                        lexical_cast<string>(cgiEnv->GetInformation().Client.GeoLocation.RawData));
-#endif // !(GDPR_COMPLIANCE)
-
-            string homePageFields;
-            if (cgiEnv->GetInformation().Client.Language.Code
-                    == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa) {
-                homePageFields = "homepage_url_fa, homepage_title_fa";
-            } else {
-                homePageFields = "homepage_url_en, homepage_title_en";
-            }
-
-            auto conn = Pool::Database().Connection();
-            conn->activate();
-            pqxx::work txn(*conn.get());
-
-            string query((boost::format("SELECT %1% FROM \"%2%\""
-                                        " WHERE pseudo_id = '0';")
-                          % homePageFields
-                          % txn.esc(Service::Pool::Database().GetTableName("SETTINGS"))).str());
-            LOG_INFO("Running query...", query, cgiEnv->GetInformation().ToJson());
-
-            result r = txn.exec(query);
-
-            string homePageUrl;
-            string homePageTitle;
-            if (!r.empty()) {
-                const pqxx::row row(r[0]);
-                homePageUrl.assign(row[0].c_str());
-                homePageTitle.assign(row[1].c_str());
-            }
-
-            replace_all(htmlData, "${home-page-url}", homePageUrl);
-            replace_all(htmlData, "${home-page-title}", homePageTitle);
-
-            string link(cgiEnv->GetInformation().Server.Url);
-
-            if (!ends_with(link, "/"))
-                link += "/";
-
-            if (type == Message::Confirm) {
-                link += (format("?subscribe=2&recipient=%1%")
-                         % uuid).str();
-
-                replace_all(htmlData, "${confirm-link}", link);
-            } else if (type == Message::Cancel) {
-                std::string token;
-                Pool::Crypto().Encrypt(lexical_cast<string>(n.RawTime()), token);
-
-                link += (format("?subscribe=-2&recipient=%1%&token=%2%")
-                         % uuid
-                         % token).str();
+            /// Fill the template
+            tmpl->setTemplateText(WString::fromUTF8(htmlData), TextFormat::XHTMLUnsafeText);
 
-                replace_all(htmlData, "${cancel-link}", link);
-            }
+            tmpl->bindString("title", title);
+            tmpl->bindString("message", message);
 
-            CoreLib::Mail *mail = new CoreLib::Mail(
-                        cgiEnv->GetInformation().Server.NoReplyAddress,
-                        inbox, subject, htmlData);
-            mail->SetDeleteLater(true);
-            mail->SendAsync();
+            tmpl->bindString("home-page-url", WString::fromUTF8(homePageUrl));
+            tmpl->bindString("home-page-title", WString::fromUTF8(homePageTitle));
         }
     }
 
-    catch (const pqxx::sql_error &ex) {
-        LOG_ERROR(ex.what(), ex.query(), cgiEnv->GetInformation().ToJson());
-    }
-
     catch (const boost::exception &ex) {
         LOG_ERROR(boost::diagnostic_information(ex), cgiEnv->GetInformation().ToJson());
     }
@@ -0,0 +1,516 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A session-less JSON API for subscribing, unsubscribing, confirming and
+ * cancelling, so that subscription forms can be embedded in other pages.
+ */
+
+
+#include <istream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <ctime>
+#include <boost/algorithm/string.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/optional.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <Wt/Http/Request>
+#include <Wt/Http/Response>
+#include <CoreLib/Crypto.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include <CoreLib/Utility.hpp>
+#include <CoreLib/Validate.hpp>
+#include "CgiEnv.hpp"
+#include "LocalizedStrings.hpp"
+#include "Pool.hpp"
+#include "SettingsCache.hpp"
+#include "Subscriber.hpp"
+#include "SubscriptionApi.hpp"
+#include "SubscriptionLink.hpp"
+
+/// Once the throttle keeps track of this many keys, the ones whose window
+/// has already passed get forgotten
+#define     THROTTLE_PRUNE_THRESHOLD        4096
+
+using namespace std;
+using namespace boost;
+using namespace Wt;
+using namespace CoreLib;
+using namespace Service;
+
+struct SubscriptionApi::Impl
+{
+public:
+    struct Reply
+    {
+        int Status;
+        std::string Result;
+        std::string TitleKey;
+        std::string MessageKey;
+    };
+
+    struct ThrottleRecord
+    {
+        std::time_t WindowStart;
+        int Requests;
+    };
+
+public:
+    Endpoint ApiEndpoint;
+
+public:
+    explicit Impl(const Endpoint &endpoint);
+    ~Impl();
+
+public:
+    Reply Process(const Wt::Http::Request &request, CgiEnv::InformationRecord &info);
+
+    void FillInformation(const Wt::Http::Request &request, const boost::property_tree::ptree &tree,
+                         CgiEnv::InformationRecord &out_info) const;
+    static bool GetLanguages(const boost::property_tree::ptree &tree, const std::string &fallback,
+                             std::string &out_languages);
+    static bool IsAllowedOrigin(const std::string &origin);
+    static std::string GetOrigin(const std::string &url);
+    static bool IsThrottled(const std::string &key, const int limit);
+
+    static Reply GetReply(const int status, const std::string &result,
+                          const std::string &titleKey, const std::string &messageKey);
+    static void Respond(const CgiEnv::InformationRecord &info, const Reply &reply,
+                        Wt::Http::Response &response);
+};
+
+SubscriptionApi::SubscriptionApi(const Endpoint &endpoint, Wt::WObject *parent)
+    : WResource(parent),
+      m_pimpl(make_unique<SubscriptionApi::Impl>(endpoint))
+{
+
+}
+
+SubscriptionApi::~SubscriptionApi()
+{
+    beingDeleted();
+}
+
+void SubscriptionApi::handleRequest(const Wt::Http::Request &request,
+                                    Wt::Http::Response &response)
+{
+    response.addHeader("Cache-Control", "no-store");
+    response.addHeader("Vary", "Origin");
+
+    /// Meant to be embedded in our own sites only; browsers always send Origin
+    /// along with cross-origin requests, so any other page gets turned down
+    /// even when it gets away without a preflight
+    const string origin(request.headerValue("Origin"));
+    const bool originAllowed = origin.empty() || Impl::IsAllowedOrigin(origin);
+
+    if (!origin.empty() && originAllowed) {
+        response.addHeader("Access-Control-Allow-Origin", origin);
+    }
+
+    if (request.method() == "OPTIONS") {
+        response.setStatus(originAllowed ? 204 : 403);
+        response.addHeader("Access-Control-Allow-Methods", "POST, OPTIONS");
+        response.addHeader("Access-Control-Allow-Headers", "Content-Type");
+        response.addHeader("Access-Control-Max-Age", "86400");
+        return;
+    }
+
+    CgiEnv::InformationRecord info = CgiEnv::InformationRecord();
+    CgiEnv::FromRequest(request, "", info);
+
+    if (!originAllowed) {
+        Impl::Respond(info, Impl::GetReply(403, "forbidden-origin",
+                                           "api-invalid-request-title", "api-invalid-request-message"),
+                      response);
+        return;
+    }
+
+    if (request.method() != "POST") {
+        response.addHeader("Allow", "POST, OPTIONS");
+        Impl::Respond(info, Impl::GetReply(405, "method-not-allowed",
+                                           "api-invalid-request-title", "api-invalid-request-message"),
+                      response);
+        return;
+    }
+
+    Impl::Respond(info, m_pimpl->Process(request, info), response);
+}
+
+SubscriptionApi::Impl::Impl(const Endpoint &endpoint)
+    : ApiEndpoint(endpoint)
+{
+
+}
+
+SubscriptionApi::Impl::~Impl() = default;
+
+SubscriptionApi::Impl::Reply SubscriptionApi::Impl::Process(const Wt::Http::Request &request,
+                                                            CgiEnv::InformationRecord &info)
+{
+    const Reply invalidRequest(GetReply(400, "invalid-request",
+                                        "api-invalid-request-title", "api-invalid-request-message"));
+
+    try {
+        const std::size_t maxLength = static_cast<std::size_t>(Pool::Storage().ApiMaxRequestLength());
+
+        if (request.contentLength() > Pool::Storage().ApiMaxRequestLength()) {
+            return GetReply(413, "request-too-large",
+                            "api-invalid-request-title", "api-invalid-request-message");
+        }
+
+        /// Never trust Content-Length on its own
+        std::vector<char> buffer(maxLength + 1);
+        request.in().read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const std::size_t length = static_cast<std::size_t>(request.in().gcount());
+
+        if (length > maxLength) {
+            return GetReply(413, "request-too-large",
+                            "api-invalid-request-title", "api-invalid-request-message");
+        }
+
+        boost::property_tree::ptree tree;
+
+        try {
+            std::istringstream stream(string(buffer.data(), length));
+            boost::property_tree::read_json(stream, tree);
+        } catch (const boost::property_tree::json_parser_error &ex) {
+            (void)ex;
+            return invalidRequest;
+        }
+
+        FillInformation(request, tree, info);
+
+        switch (ApiEndpoint) {
+        case Endpoint::Subscribe:
+        case Endpoint::Unsubscribe: {
+            /// Stored lowercased, the same as the subscribe form and the importer
+            /// do; otherwise ON CONFLICT ( inbox ) lets case variants through
+            const string inbox(to_lower_copy(trim_copy(tree.get<string>("inbox", ""))));
+
+            if (!CoreLib::Validate::Email(inbox)) {
+                return invalidRequest;
+            }
+
+            /// The subscribe form checks the visitor's own language by
+            /// default, the unsubscribe one everything the inbox receives
+            string languages;
+            if (!GetLanguages(tree,
+                              ApiEndpoint == Endpoint::Unsubscribe
+                              ? "en_fa"
+                              : info.Client.Language.Code
+                                == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa
+                                ? "en_fa" : "en",
+                              languages)) {
+                return invalidRequest;
+            }
+
+            /// Both send an email to an arbitrary address, which is what the
+            /// captcha on the Wt pages guards against; limit both the senders
+            /// and the receivers
+            if (IsThrottled("ip:" + info.Client.IPAddress, Pool::Storage().ApiMailRequestsPerWindow())
+                    || IsThrottled("inbox:" + inbox, Pool::Storage().ApiMailRequestsPerInbox())) {
+                return GetReply(429, "too-many-requests",
+                                "api-too-many-requests-title", "api-too-many-requests-message");
+            }
+
+            info.Subscription.Inbox = inbox;
+
+            if (ApiEndpoint == Endpoint::Subscribe) {
+                switch (Subscriber::Subscribe(info, inbox, languages)) {
+                case Subscriber::Result::Done:
+                    return GetReply(200, "done",
+                                    "home-subscription-subscribe-success-dialog-title",
+                                    "home-subscription-subscribe-success-dialog-message");
+                default:
+                    break;
+                }
+            } else {
+                switch (Subscriber::Unsubscribe(info, inbox, languages)) {
+                case Subscriber::Result::Done:
+                    return GetReply(200, "done",
+                                    "home-subscription-unsubscribe-success-dialog-title",
+                                    "home-subscription-unsubscribe-success-dialog-message");
+                case Subscriber::Result::InvalidRecipient:
+                    return GetReply(404, "invalid-recipient",
+                                    "home-subscription-invalid-recipient-id-title",
+                                    "home-subscription-invalid-recipient-id-message");
+                default:
+                    break;
+                }
+            }
+        } break;
+
+        case Endpoint::Confirm: {
+            string inbox;
+            string subscription;
+
+            switch (Subscriber::Confirm(info, inbox, subscription)) {
+            case Subscriber::Result::Done:
+                return GetReply(200, "done",
+                                "home-subscription-confirmation-congratulation-title",
+                                "home-subscription-confirmation-congratulation-message");
+            case Subscriber::Result::InvalidRecipient:
+                return GetReply(404, "invalid-recipient",
+                                "home-subscription-invalid-recipient-id-title",
+                                "home-subscription-invalid-recipient-id-message");
+            case Subscriber::Result::Expired:
+                return GetReply(410, "expired",
+                                "home-subscription-token-has-expired-title",
+                                "home-subscription-token-has-expired-message");
+            case Subscriber::Result::AlreadyDone:
+                return GetReply(200, "already-done",
+                                "home-subscription-confirmation-already-confirmed-title",
+                                "home-subscription-confirmation-already-confirmed-message");
+            case Subscriber::Result::NothingPending:
+                return GetReply(409, "nothing-pending",
+                                "home-subscription-unsubscribe-already-unsubscribed-title",
+                                "home-subscription-unsubscribe-already-unsubscribed-message");
+            case Subscriber::Result::Failed:
+                break;
+            }
+        } break;
+
+        case Endpoint::Cancel: {
+            string inbox;
+            string subscription;
+
+            switch (Subscriber::Cancel(info, inbox, subscription)) {
+            case Subscriber::Result::Done:
+                return GetReply(200, "done",
+                                "home-subscription-cancellation-cancelled-title",
+                                "home-subscription-cancellation-cancelled-message");
+            case Subscriber::Result::InvalidRecipient:
+                return GetReply(404, "invalid-recipient",
+                                "home-subscription-invalid-recipient-id-title",
+                                "home-subscription-invalid-recipient-id-message");
+            case Subscriber::Result::Expired:
+                return GetReply(410, "expired",
+                                "home-subscription-token-has-expired-title",
+                                "home-subscription-token-has-expired-message");
+            case Subscriber::Result::AlreadyDone:
+                return GetReply(200, "already-done",
+                                "home-subscription-cancellation-already-cancelled-title",
+                                "home-subscription-cancellation-already-cancelled-message");
+            case Subscriber::Result::NothingPending:
+                return GetReply(409, "nothing-pending",
+                                "home-subscription-cancellation-invalid-request-title",
+                                "home-subscription-cancellation-invalid-request-message");
+            case Subscriber::Result::Failed:
+                break;
+            }
+        } break;
+        }
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+
+    return GetReply(500, "failed", "internal-server-error", "internal-server-error");
+}
+
+void SubscriptionApi::Impl::FillInformation(const Wt::Http::Request &request, const boost::property_tree::ptree &tree,
+                                            CgiEnv::InformationRecord &out_info) const
+{
+    CgiEnv::FromRequest(request, tree.get<string>("lang", ""), out_info);
+
+    switch (ApiEndpoint) {
+    case Endpoint::Subscribe:
+        out_info.Subscription.Subscribe = CgiEnv::InformationRecord::SubscriptionRecord::Action::Subscribe;
+        break;
+    case Endpoint::Unsubscribe:
+        out_info.Subscription.Subscribe = CgiEnv::InformationRecord::SubscriptionRecord::Action::Unsubscribe;
+        break;
+    case Endpoint::Confirm:
+        out_info.Subscription.Subscribe = CgiEnv::InformationRecord::SubscriptionRecord::Action::Confirm;
+        break;
+    case Endpoint::Cancel:
+        out_info.Subscription.Subscribe = CgiEnv::InformationRecord::SubscriptionRecord::Action::Cancel;
+        break;
+    }
+
+    const string recipient(tree.get<string>("recipient", ""));
+    if (CoreLib::Validate::Uuid(recipient)) {
+        out_info.Subscription.Uuid = recipient;
+    }
+
+    const string languages(tree.get<string>("subscription", ""));
+    if (CoreLib::Validate::LanguageArray(languages)) {
+        vector<string> vec;
+        split(vec, languages, boost::is_any_of(","));
+        for (const auto &s : vec) {
+            if (s == "en") {
+                out_info.Subscription.Languages.push_back(CgiEnv::InformationRecord::SubscriptionRecord::Language::En);
+            } else if (s == "fa") {
+                out_info.Subscription.Languages.push_back(CgiEnv::InformationRecord::SubscriptionRecord::Language::Fa);
+            }
+        }
+    }
+
+    if (ApiEndpoint == Endpoint::Cancel) {
+        /// A token issued for someone else is as good as none
+        string tokenRecipient;
+        time_t expiry;
+        if (Pool::Crypto().OpenToken(tree.get<string>("token", ""), tokenRecipient, expiry)
+                && tokenRecipient == out_info.Subscription.Uuid) {
+            out_info.Subscription.Timestamp = expiry;
+        }
+    } else if (ApiEndpoint == Endpoint::Confirm) {
+        /// Confirmation links must be signed by us; forget about the
+        /// recipient of a forged one, the same as CgiEnv does
+        if (!SubscriptionLink::Verify("2", out_info.Subscription.Uuid,
+                                      out_info.Subscription.Languages.empty() ? "" : languages,
+                                      tree.get<string>("expires", ""), tree.get<string>("signature", ""),
+                                      out_info.Subscription.Timestamp)) {
+            out_info.Subscription.Uuid.clear();
+        }
+    }
+}
+
+bool SubscriptionApi::Impl::GetLanguages(const boost::property_tree::ptree &tree, const std::string &fallback,
+                                         std::string &out_languages)
+{
+    const string languages(tree.get<string>("subscription", ""));
+
+    if (languages.empty()) {
+        out_languages.assign(fallback);
+        return true;
+    }
+
+    if (!CoreLib::Validate::LanguageArray(languages))
+        return false;
+
+    const bool en = languages.find("en") != string::npos;
+    const bool fa = languages.find("fa") != string::npos;
+
+    out_languages.assign(en && fa ? "en_fa" : en ? "en" : "fa");
+
+    return true;
+}
+
+bool SubscriptionApi::Impl::IsAllowedOrigin(const std::string &origin)
+{
+    const string requested(to_lower_copy(origin));
+
+    if (requested == GetOrigin(Pool::Storage().ServiceUrl()))
+        return true;
+
+    SettingsCache::SnapshotPtr settings(Pool::Settings().Get());
+
+    return requested == GetOrigin(settings->HomePageUrlEn)
+            || requested == GetOrigin(settings->HomePageUrlFa);
+}
+
+std::string SubscriptionApi::Impl::GetOrigin(const std::string &url)
+{
+    /// scheme://host[:port], which is all an Origin header carries
+    const string::size_type scheme = url.find("://");
+    if (scheme == string::npos)
+        return string();
+
+    return to_lower_copy(url.substr(0, url.find('/', scheme + 3)));
+}
+
+bool SubscriptionApi::Impl::IsThrottled(const std::string &key, const int limit)
+{
+    /// A fixed window per key, shared by all the endpoints
+    static boost::mutex mutex;
+    static std::unordered_map<std::string, ThrottleRecord> records;
+
+    const time_t now = std::time(nullptr);
+    const time_t window = static_cast<time_t>(Pool::Storage().ApiMailRequestsWindow());
+
+    boost::lock_guard<boost::mutex> lock(mutex);
+    (void)lock;
+
+    if (records.size() >= THROTTLE_PRUNE_THRESHOLD) {
+        for (auto it = records.begin(); it != records.end();) {
+            if (now - it->second.WindowStart >= window) {
+                it = records.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    ThrottleRecord &record = records[key];
+
+    if (record.Requests == 0 || now - record.WindowStart >= window) {
+        record.WindowStart = now;
+        record.Requests = 0;
+    }
+
+    return ++record.Requests > limit;
+}
+
+SubscriptionApi::Impl::Reply SubscriptionApi::Impl::GetReply(const int status, const std::string &result,
+                                                             const std::string &titleKey,
+                                                             const std::string &messageKey)
+{
+    Reply reply;
+    reply.Status = status;
+    reply.Result = result;
+    reply.TitleKey = titleKey;
+    reply.MessageKey = messageKey;
+    return reply;
+}
+
+void SubscriptionApi::Impl::Respond(const CgiEnv::InformationRecord &info, const Reply &reply,
+                                    Wt::Http::Response &response)
+{
+    const string locale(Subscriber::GetLocale(info));
+
+    /// Both are XHTML fragments, exactly as the Wt pages show them
+    string json("{\"result\":");
+    CoreLib::Utility::AppendJsonString(reply.Result, json);
+    json.append(",\"title\":");
+    CoreLib::Utility::AppendJsonString(trim_copy(Pool::Localization().Resolve(locale, reply.TitleKey)), json);
+    json.append(",\"message\":");
+    CoreLib::Utility::AppendJsonString(trim_copy(Pool::Localization().Resolve(locale, reply.MessageKey)), json);
+    json.append("}");
+
+    response.setStatus(reply.Status);
+    response.setMimeType("application/json; charset=utf-8");
+    response.out() << json;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Signs and verifies the query string of the confirmation and unsubscribe
+ * links sent out by email, so forged, mangled or expired ones are turned away
+ * before anything touches the database.
+ */
+
+
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <CoreLib/Crypto.hpp>
+#include "Pool.hpp"
+#include "SubscriptionLink.hpp"
+
+#define     SUBSCRIPTION_LINK_VERSION       "v1"
+
+using namespace std;
+using namespace boost;
+using namespace Service;
+
+bool SubscriptionLink::Sign(const std::string &action, const std::string &uuid, const std::string &languages,
+                            const std::time_t expiry, std::string &out_query)
+{
+    const string expiryString(lexical_cast<string>(expiry));
+
+    string signature;
+    if (!Pool::Crypto().Sign(Message(action, uuid, languages, expiryString), signature))
+        return false;
+
+    out_query += (format("subscribe=%1%&recipient=%2%") % action % uuid).str();
+    if (!languages.empty())
+        out_query += (format("&subscription=%1%") % languages).str();
+    out_query += (format("&expires=%1%&signature=%2%") % expiryString % signature).str();
+
+    return true;
+}
+
+bool SubscriptionLink::Verify(const std::string &action, const std::string &uuid, const std::string &languages,
+                              const std::string &expiry, const std::string &signature, std::time_t &out_expiry)
+{
+    out_expiry = 0;
+
+    if (uuid.empty() || expiry.empty() || signature.empty())
+        return false;
+
+    if (!Pool::Crypto().VerifySignature(Message(action, uuid, languages, expiry), signature))
+        return false;
+
+    /// Authentic, hence it was us who wrote a valid number there
+    try {
+        out_expiry = lexical_cast<time_t>(expiry);
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string SubscriptionLink::Message(const std::string &action, const std::string &uuid, const std::string &languages,
+                                      const std::string &expiry)
+{
+    /// None of the fields may contain the separator; CgiEnv validates uuid and
+    /// languages against their regexes before they reach here
+    return (format("%1%|%2%|%3%|%4%|%5%")
+            % SUBSCRIPTION_LINK_VERSION % action % uuid % languages % expiry).str();
+}
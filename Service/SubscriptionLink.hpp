@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Signs and verifies the query string of the confirmation and unsubscribe
+ * links sent out by email, so forged, mangled or expired ones are turned away
+ * before anything touches the database.
+ */
+
+
+#ifndef SERVICE_SUBSCRIPTION_LINK_HPP
+#define SERVICE_SUBSCRIPTION_LINK_HPP
+
+
+#include <string>
+#include <ctime>
+
+namespace Service {
+class SubscriptionLink;
+}
+
+class Service::SubscriptionLink
+{
+public:
+    /// Appends subscribe, recipient, subscription (if any), expires and
+    /// signature parameters to the query string
+    static bool Sign(const std::string &action, const std::string &uuid, const std::string &languages,
+                     const std::time_t expiry, std::string &out_query);
+
+    /// Parameters as they came in; fails on a bad signature only, so the caller
+    /// may tell expired links apart from forged ones through out_expiry
+    static bool Verify(const std::string &action, const std::string &uuid, const std::string &languages,
+                       const std::string &expiry, const std::string &signature, std::time_t &out_expiry);
+
+private:
+    static std::string Message(const std::string &action, const std::string &uuid, const std::string &languages,
+                               const std::string &expiry);
+};
+
+
+#endif /* SERVICE_SUBSCRIPTION_LINK_HPP */
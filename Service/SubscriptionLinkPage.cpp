@@ -0,0 +1,410 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Serves the confirmation and cancellation links of the subscription emails
+ * as static, pre-localized pages without ever creating a Wt session. Opening
+ * a link only asks for the recipient's consent; the button on that page
+ * posts back to the very same link, which is when it gets acted upon.
+ */
+
+
+#include <atomic>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <Wt/Http/Request>
+#include <Wt/Http/Response>
+#include <Wt/Utils>
+#include <CoreLib/Crypto.hpp>
+#include <CoreLib/FileSystem.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include <CoreLib/Validate.hpp>
+#include "CgiEnv.hpp"
+#include "LocalizedStrings.hpp"
+#include "Pool.hpp"
+#include "Subscriber.hpp"
+#include "SubscriptionLink.hpp"
+#include "SubscriptionLinkPage.hpp"
+
+using namespace std;
+using namespace boost;
+using namespace Wt;
+using namespace CoreLib;
+using namespace Service;
+
+struct SubscriptionLinkPage::Impl
+{
+public:
+    enum class Page : unsigned char {
+        ConfirmPrompt,
+        CancelPrompt,
+        Confirmed,
+        AlreadyConfirmed,
+        Cancelled,
+        AlreadyCancelled,
+        InvalidCancellation,
+        InvalidRecipient,
+        Expired,
+        InvalidRequest,
+        Failed
+    };
+
+    static constexpr std::size_t PAGE_COUNT = 11;
+
+    struct PageRecord
+    {
+        const char *TitleKey;
+        const char *MessageKey;
+        const char *ButtonKey;
+        int Status;
+    };
+
+    /// Every page in both languages with everything but the home page
+    /// filled in, which lives in the settings and may change at any time
+    struct Pages
+    {
+        LocalizedStrings::SnapshotPtr Source;
+        std::string En[PAGE_COUNT];
+        std::string Fa[PAGE_COUNT];
+    };
+
+    typedef std::shared_ptr<const Pages> PagesPtr;
+
+public:
+    /// Always accessed through std::atomic_load / std::atomic_store
+    PagesPtr Rendered;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    PagesPtr GetPages();
+
+    Page Confirm(const Wt::Http::Request &request, CgiEnv::InformationRecord &info, std::string &out_redirect);
+    Page Cancel(const Wt::Http::Request &request, CgiEnv::InformationRecord &info);
+
+    void Respond(const CgiEnv::InformationRecord &info, const Page &page, Wt::Http::Response &response);
+
+    static const PageRecord &GetRecord(const Page &page);
+    static std::string GetParameter(const Wt::Http::Request &request, const std::string &name);
+};
+
+const std::string &SubscriptionLinkPage::Path()
+{
+    static const string PATH("subscription");
+    return PATH;
+}
+
+SubscriptionLinkPage::SubscriptionLinkPage(Wt::WObject *parent)
+    : WResource(parent),
+      m_pimpl(make_unique<SubscriptionLinkPage::Impl>())
+{
+
+}
+
+SubscriptionLinkPage::~SubscriptionLinkPage()
+{
+    beingDeleted();
+}
+
+void SubscriptionLinkPage::handleRequest(const Wt::Http::Request &request,
+                                         Wt::Http::Response &response)
+{
+    /// One-shot by nature, and the query string carries the credentials
+    response.addHeader("Cache-Control", "no-store");
+    response.addHeader("Referrer-Policy", "no-referrer");
+
+    CgiEnv::InformationRecord info = CgiEnv::InformationRecord();
+    CgiEnv::FromRequest(request, Impl::GetParameter(request, "lang"), info);
+
+    try {
+        /// Mail scanners probing the link must not act on behalf of the recipient
+        if (request.method() == "HEAD") {
+            response.setStatus(200);
+            response.setMimeType("text/html; charset=utf-8");
+            return;
+        }
+
+        const string action(Impl::GetParameter(request, "subscribe"));
+
+        /// Neither do those following it; only the recipient presses the button
+        if (request.method() == "GET") {
+            if (action == "2") {
+                m_pimpl->Respond(info, Impl::Page::ConfirmPrompt, response);
+            } else if (action == "-2") {
+                m_pimpl->Respond(info, Impl::Page::CancelPrompt, response);
+            } else {
+                m_pimpl->Respond(info, Impl::Page::InvalidRequest, response);
+            }
+
+            return;
+        }
+
+        if (request.method() != "POST") {
+            response.addHeader("Allow", "GET, HEAD, POST");
+            m_pimpl->Respond(info, Impl::Page::InvalidRequest, response);
+            response.setStatus(405);
+            return;
+        }
+
+        if (action == "2") {
+            string redirect;
+            Impl::Page page = m_pimpl->Confirm(request, info, redirect);
+
+            if (!redirect.empty()) {
+                response.setStatus(303);
+                response.addHeader("Location", redirect);
+                return;
+            }
+
+            m_pimpl->Respond(info, page, response);
+        } else if (action == "-2") {
+            m_pimpl->Respond(info, m_pimpl->Cancel(request, info), response);
+        } else {
+            m_pimpl->Respond(info, Impl::Page::InvalidRequest, response);
+        }
+
+        return;
+    }
+
+    catch (const boost::exception &ex) {
+        LOG_ERROR(boost::diagnostic_information(ex), info.ToJson());
+    }
+
+    catch (const std::exception &ex) {
+        LOG_ERROR(ex.what(), info.ToJson());
+    }
+
+    catch (...) {
+        LOG_ERROR(UNKNOWN_ERROR, info.ToJson());
+    }
+
+    response.setStatus(500);
+}
+
+SubscriptionLinkPage::Impl::Impl()
+{
+
+}
+
+SubscriptionLinkPage::Impl::~Impl() = default;
+
+SubscriptionLinkPage::Impl::PagesPtr SubscriptionLinkPage::Impl::GetPages()
+{
+    LocalizedStrings::SnapshotPtr strings(Pool::Localization().Get());
+    PagesPtr pages(std::atomic_load(&Rendered));
+
+    if (pages && pages->Source == strings)
+        return pages;
+
+    /// First request or the bundles have been reloaded since; concurrent
+    /// requests may render the same pages twice, which is harmless
+    auto fresh = std::make_shared<Pages>();
+    fresh->Source = strings;
+
+    string en;
+    string fa;
+    CoreLib::FileSystem::Read("../templates/home-subscription-page.wtml", en);
+    CoreLib::FileSystem::Read("../templates/home-subscription-page-fa.wtml", fa);
+
+    /// Without an action the form posts back to the page's own URL, query
+    /// string and all, so the link's parameters come along untouched
+    static const string FORM("<form method=\"post\" class=\"text-center\">"
+                             "<button type=\"submit\" class=\"btn btn-primary\">${button}</button>"
+                             "</form>");
+
+    for (std::size_t i = 0; i < PAGE_COUNT; ++i) {
+        const PageRecord &record = GetRecord(static_cast<Page>(i));
+
+        string enForm;
+        string faForm;
+        if (record.ButtonKey) {
+            enForm = replace_all_copy(FORM, "${button}", trim_copy(Pool::Localization().Resolve("en", record.ButtonKey)));
+            faForm = replace_all_copy(FORM, "${button}", trim_copy(Pool::Localization().Resolve("fa", record.ButtonKey)));
+        }
+
+        fresh->En[i] = en;
+        replace_all(fresh->En[i], "${title}", trim_copy(Pool::Localization().Resolve("en", record.TitleKey)));
+        replace_all(fresh->En[i], "${message}", trim_copy(Pool::Localization().Resolve("en", record.MessageKey)));
+        replace_all(fresh->En[i], "${form}", enForm);
+
+        fresh->Fa[i] = fa;
+        replace_all(fresh->Fa[i], "${title}", trim_copy(Pool::Localization().Resolve("fa", record.TitleKey)));
+        replace_all(fresh->Fa[i], "${message}", trim_copy(Pool::Localization().Resolve("fa", record.MessageKey)));
+        replace_all(fresh->Fa[i], "${form}", faForm);
+    }
+
+    pages = fresh;
+    std::atomic_store(&Rendered, pages);
+
+    return pages;
+}
+
+SubscriptionLinkPage::Impl::Page SubscriptionLinkPage::Impl::Confirm(const Wt::Http::Request &request,
+                                                                     CgiEnv::InformationRecord &info,
+                                                                     std::string &out_redirect)
+{
+    info.Subscription.Subscribe = CgiEnv::InformationRecord::SubscriptionRecord::Action::Confirm;
+
+    const string recipient(GetParameter(request, "recipient"));
+    if (CoreLib::Validate::Uuid(recipient)) {
+        info.Subscription.Uuid = recipient;
+    }
+
+    string languages(GetParameter(request, "subscription"));
+    if (!CoreLib::Validate::LanguageArray(languages)) {
+        languages.clear();
+    }
+
+    /// Confirmation links must be signed by us; the same as CgiEnv does
+    if (!SubscriptionLink::Verify("2", info.Subscription.Uuid, languages,
+                                  GetParameter(request, "expires"), GetParameter(request, "signature"),
+                                  info.Subscription.Timestamp)) {
+        info.Subscription.Uuid.clear();
+    }
+
+    string inbox;
+    string subscription;
+
+    switch (Subscriber::Confirm(info, inbox, subscription)) {
+    case Subscriber::Result::Done:
+        return Page::Confirmed;
+    case Subscriber::Result::InvalidRecipient:
+        return Page::InvalidRecipient;
+    case Subscriber::Result::Expired:
+        return Page::Expired;
+    case Subscriber::Result::AlreadyDone:
+        return Page::AlreadyConfirmed;
+    case Subscriber::Result::NothingPending:
+        /// Neither subscribed nor pending, so hand over to the subscribe
+        /// form, which needs a session anyway
+        out_redirect = info.Server.Url;
+        if (!ends_with(out_redirect, "/"))
+            out_redirect += "/";
+        out_redirect += "?lang=" + info.Client.Language.CodeAsString
+                + "&subscribe=1&inbox=" + Wt::Utils::urlEncode(inbox)
+                + (info.Client.Language.Code == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa
+                   ? "&subscription=en,fa" : "&subscription=en");
+        return Page::Confirmed;
+    case Subscriber::Result::Failed:
+        break;
+    }
+
+    return Page::Failed;
+}
+
+SubscriptionLinkPage::Impl::Page SubscriptionLinkPage::Impl::Cancel(const Wt::Http::Request &request,
+                                                                    CgiEnv::InformationRecord &info)
+{
+    info.Subscription.Subscribe = CgiEnv::InformationRecord::SubscriptionRecord::Action::Cancel;
+
+    const string recipient(GetParameter(request, "recipient"));
+    if (CoreLib::Validate::Uuid(recipient)) {
+        info.Subscription.Uuid = recipient;
+    }
+
+    /// A token issued for someone else is as good as none
+    string tokenRecipient;
+    time_t expiry;
+    if (Pool::Crypto().OpenToken(GetParameter(request, "token"), tokenRecipient, expiry)
+            && tokenRecipient == info.Subscription.Uuid) {
+        info.Subscription.Timestamp = expiry;
+    }
+
+    string inbox;
+    string subscription;
+
+    switch (Subscriber::Cancel(info, inbox, subscription)) {
+    case Subscriber::Result::Done:
+        return Page::Cancelled;
+    case Subscriber::Result::InvalidRecipient:
+        return Page::InvalidRecipient;
+    case Subscriber::Result::Expired:
+        return Page::Expired;
+    case Subscriber::Result::AlreadyDone:
+        return Page::AlreadyCancelled;
+    case Subscriber::Result::NothingPending:
+        return Page::InvalidCancellation;
+    case Subscriber::Result::Failed:
+        break;
+    }
+
+    return Page::Failed;
+}
+
+void SubscriptionLinkPage::Impl::Respond(const CgiEnv::InformationRecord &info, const Page &page,
+                                         Wt::Http::Response &response)
+{
+    PagesPtr pages(GetPages());
+
+    const std::size_t index = static_cast<std::size_t>(page);
+    string html(info.Client.Language.Code == CgiEnv::InformationRecord::ClientRecord::LanguageCode::Fa
+                ? pages->Fa[index] : pages->En[index]);
+
+    string homePageUrl;
+    string homePageTitle;
+    Subscriber::GetHomePage(info, homePageUrl, homePageTitle);
+
+    replace_all(html, "${home-page-url}", Wt::Utils::htmlEncode(homePageUrl));
+    replace_all(html, "${home-page-title}", Wt::Utils::htmlEncode(homePageTitle));
+
+    response.setStatus(GetRecord(page).Status);
+    response.setMimeType("text/html; charset=utf-8");
+    response.out() << html;
+}
+
+const SubscriptionLinkPage::Impl::PageRecord &SubscriptionLinkPage::Impl::GetRecord(const Page &page)
+{
+    /// In the order of Page
+    static const PageRecord RECORDS[PAGE_COUNT] = {
+        { "home-subscription-confirmation-prompt-title", "home-subscription-confirmation-prompt-message", "home-subscription-confirmation-prompt-button", 200 },
+        { "home-subscription-cancellation-prompt-title", "home-subscription-cancellation-prompt-message", "home-subscription-cancellation-prompt-button", 200 },
+        { "home-subscription-confirmation-congratulation-title", "home-subscription-confirmation-congratulation-message", nullptr, 200 },
+        { "home-subscription-confirmation-already-confirmed-title", "home-subscription-confirmation-already-confirmed-message", nullptr, 200 },
+        { "home-subscription-cancellation-cancelled-title", "home-subscription-cancellation-cancelled-message", nullptr, 200 },
+        { "home-subscription-cancellation-already-cancelled-title", "home-subscription-cancellation-already-cancelled-message", nullptr, 200 },
+        { "home-subscription-cancellation-invalid-request-title", "home-subscription-cancellation-invalid-request-message", nullptr, 409 },
+        { "home-subscription-invalid-recipient-id-title", "home-subscription-invalid-recipient-id-message", nullptr, 404 },
+        { "home-subscription-token-has-expired-title", "home-subscription-token-has-expired-message", nullptr, 410 },
+        { "api-invalid-request-title", "api-invalid-request-message", nullptr, 400 },
+        { "internal-server-error", "internal-server-error", nullptr, 500 }
+    };
+
+    return RECORDS[static_cast<std::size_t>(page)];
+}
+
+std::string SubscriptionLinkPage::Impl::GetParameter(const Wt::Http::Request &request, const std::string &name)
+{
+    const string *value = request.getParameter(name);
+    return value ? *value : string();
+}
@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Serves the confirmation and cancellation links of the subscription emails
+ * as static, pre-localized pages without ever creating a Wt session. Opening
+ * a link only asks for the recipient's consent; the button on that page
+ * posts back to the very same link, which is when it gets acted upon.
+ */
+
+
+#ifndef SERVICE_SUBSCRIPTION_LINK_PAGE_HPP
+#define SERVICE_SUBSCRIPTION_LINK_PAGE_HPP
+
+
+#include <memory>
+#include <string>
+#include <Wt/WResource>
+
+namespace Service {
+class SubscriptionLinkPage;
+}
+
+class Service::SubscriptionLinkPage : public Wt::WResource
+{
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    /// Relative to the deployment path
+    static const std::string &Path();
+
+public:
+    explicit SubscriptionLinkPage(Wt::WObject *parent = 0);
+    virtual ~SubscriptionLinkPage() override;
+
+public:
+    virtual void handleRequest(const Wt::Http::Request &request,
+                               Wt::Http::Response &response) override;
+};
+
+
+#endif /* SERVICE_SUBSCRIPTION_LINK_PAGE_HPP */
@@ -0,0 +1,293 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A fixed set of worker threads fed from a bounded, strictly first come,
+ * first served queue. Each job may carry a cost, e.g. the memory it needs,
+ * and only starts once it fits into what the running jobs leave of the
+ * pool's budget.
+ */
+
+
+#include <algorithm>
+#include <deque>
+#include <boost/chrono/chrono.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <CoreLib/Log.hpp>
+#include <CoreLib/make_unique.hpp>
+#include "WorkerPool.hpp"
+
+using namespace std;
+using namespace boost;
+using namespace CoreLib;
+using namespace Service;
+
+struct WorkerPool::Impl
+{
+public:
+    struct Job
+    {
+        std::size_t Cost;
+        Work Run;
+        boost::chrono::steady_clock::time_point EnqueueTime;
+    };
+
+public:
+    std::string Name;
+
+    boost::thread_group Workers;
+    std::size_t WorkersCount;
+    std::size_t MaxQueueDepth;
+
+    std::deque<Job> Queue;
+    mutable boost::mutex QueueMutex;
+    boost::condition_variable QueueCondition;
+    bool Stopping;
+
+    std::size_t CostBudget;
+    std::size_t CostInUse;
+    std::size_t Running;
+
+    std::size_t PeakQueueDepth;
+    uint_fast64_t Submitted;
+    uint_fast64_t Completed;
+    uint_fast64_t Rejected;
+    uint_fast64_t TotalWaitMilliseconds;
+
+public:
+    Impl();
+    ~Impl();
+
+public:
+    void Run();
+};
+
+WorkerPool::WorkerPool()
+    : m_pimpl(make_unique<WorkerPool::Impl>())
+{
+
+}
+
+WorkerPool::~WorkerPool()
+{
+    Stop();
+}
+
+void WorkerPool::Start(const std::string &name, const std::size_t workers, const std::size_t maxQueueDepth,
+                       const std::size_t costBudget)
+{
+    boost::lock_guard<boost::mutex> lock(m_pimpl->QueueMutex);
+    (void)lock;
+
+    if (m_pimpl->WorkersCount > 0)
+        return;
+
+    LOG_INFO("Starting worker pool...", name);
+
+    m_pimpl->Name = name;
+    m_pimpl->WorkersCount = std::max<std::size_t>(workers, 1);
+    m_pimpl->MaxQueueDepth = maxQueueDepth;
+    m_pimpl->CostBudget = costBudget;
+    m_pimpl->Stopping = false;
+
+    for (std::size_t i = 0; i < m_pimpl->WorkersCount; ++i) {
+        m_pimpl->Workers.create_thread([this]() { m_pimpl->Run(); });
+    }
+
+    LOG_INFO("Worker pool started!", name,
+             (boost::format("Workers: %1%") % m_pimpl->WorkersCount).str());
+}
+
+void WorkerPool::Stop()
+{
+    {
+        boost::lock_guard<boost::mutex> lock(m_pimpl->QueueMutex);
+        (void)lock;
+
+        if (m_pimpl->WorkersCount == 0)
+            return;
+
+        m_pimpl->Stopping = true;
+
+        if (!m_pimpl->Queue.empty()) {
+            LOG_WARNING("Dropping pending jobs!", m_pimpl->Name,
+                        (boost::format("Queue depth: %1%") % m_pimpl->Queue.size()).str());
+            m_pimpl->Queue.clear();
+        }
+    }
+
+    m_pimpl->QueueCondition.notify_all();
+    m_pimpl->Workers.join_all();
+
+    boost::lock_guard<boost::mutex> lock(m_pimpl->QueueMutex);
+    (void)lock;
+
+    m_pimpl->WorkersCount = 0;
+}
+
+bool WorkerPool::Post(const Work &work, const std::size_t cost)
+{
+    {
+        boost::lock_guard<boost::mutex> lock(m_pimpl->QueueMutex);
+        (void)lock;
+
+        if (m_pimpl->WorkersCount == 0 || m_pimpl->Stopping
+                || m_pimpl->Queue.size() >= m_pimpl->MaxQueueDepth) {
+            ++m_pimpl->Rejected;
+            LOG_WARNING("Job rejected!", m_pimpl->Name,
+                        (boost::format("Queue depth: %1%") % m_pimpl->Queue.size()).str(),
+                        (boost::format("Running: %1%") % m_pimpl->Running).str());
+            return false;
+        }
+
+        /// A single job has to fit no matter what, otherwise it would never run
+        Impl::Job job;
+        job.Cost = std::min(cost, m_pimpl->CostBudget);
+        job.Run = work;
+        job.EnqueueTime = boost::chrono::steady_clock::now();
+        m_pimpl->Queue.push_back(std::move(job));
+
+        ++m_pimpl->Submitted;
+        m_pimpl->PeakQueueDepth = std::max(m_pimpl->PeakQueueDepth, m_pimpl->Queue.size());
+    }
+
+    m_pimpl->QueueCondition.notify_one();
+
+    return true;
+}
+
+WorkerPool::Metrics WorkerPool::GetMetrics() const
+{
+    boost::lock_guard<boost::mutex> lock(m_pimpl->QueueMutex);
+    (void)lock;
+
+    Metrics metrics;
+    metrics.Workers = m_pimpl->WorkersCount;
+    metrics.QueueDepth = m_pimpl->Queue.size();
+    metrics.PeakQueueDepth = m_pimpl->PeakQueueDepth;
+    metrics.Running = m_pimpl->Running;
+    metrics.CostInUse = m_pimpl->CostInUse;
+    metrics.CostBudget = m_pimpl->CostBudget;
+    metrics.Submitted = m_pimpl->Submitted;
+    metrics.Completed = m_pimpl->Completed;
+    metrics.Rejected = m_pimpl->Rejected;
+    metrics.AverageWaitMilliseconds = m_pimpl->Completed > 0
+            ? m_pimpl->TotalWaitMilliseconds / m_pimpl->Completed : 0;
+
+    return metrics;
+}
+
+WorkerPool::Impl::Impl()
+    : WorkersCount(0),
+      MaxQueueDepth(0),
+      Stopping(false),
+      CostBudget(0),
+      CostInUse(0),
+      Running(0),
+      PeakQueueDepth(0),
+      Submitted(0),
+      Completed(0),
+      Rejected(0),
+      TotalWaitMilliseconds(0)
+{
+
+}
+
+WorkerPool::Impl::~Impl() = default;
+
+void WorkerPool::Impl::Run()
+{
+    for (;;) {
+        Job job;
+
+        {
+            boost::unique_lock<boost::mutex> lock(QueueMutex);
+
+            /// Strictly first come, first served: a costly job at the front
+            /// waits for the budget to free up rather than being overtaken
+            /// forever
+            QueueCondition.wait(lock, [this]() {
+                return Stopping
+                        || (!Queue.empty() && CostInUse + Queue.front().Cost <= CostBudget);
+            });
+
+            /// Whatever is running gets to finish; the rest was dropped by Stop()
+            if (Stopping)
+                break;
+
+            job = std::move(Queue.front());
+            Queue.pop_front();
+
+            CostInUse += job.Cost;
+            ++Running;
+
+            const auto wait = boost::chrono::duration_cast<boost::chrono::milliseconds>(
+                        boost::chrono::steady_clock::now() - job.EnqueueTime).count();
+            TotalWaitMilliseconds += static_cast<uint_fast64_t>(wait);
+
+            LOG_INFO("Running job...", Name,
+                     (boost::format("Waited: %1% ms") % wait).str(),
+                     (boost::format("Queue depth: %1%") % Queue.size()).str(),
+                     (boost::format("Running: %1%") % Running).str());
+        }
+
+        try {
+            job.Run();
+        }
+
+        catch (const boost::exception &ex) {
+            LOG_ERROR(boost::diagnostic_information(ex), Name);
+        }
+
+        catch (const std::exception &ex) {
+            LOG_ERROR(ex.what(), Name);
+        }
+
+        catch (...) {
+            LOG_ERROR(UNKNOWN_ERROR, Name);
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(QueueMutex);
+            (void)lock;
+
+            CostInUse -= job.Cost;
+            --Running;
+            ++Completed;
+        }
+
+        QueueCondition.notify_all();
+    }
+}
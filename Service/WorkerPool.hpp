@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A fixed set of worker threads fed from a bounded, strictly first come,
+ * first served queue. Each job may carry a cost, e.g. the memory it needs,
+ * and only starts once it fits into what the running jobs leave of the
+ * pool's budget.
+ */
+
+
+#ifndef SERVICE_WORKER_POOL_HPP
+#define SERVICE_WORKER_POOL_HPP
+
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace Service {
+class WorkerPool;
+}
+
+class Service::WorkerPool
+{
+public:
+    typedef std::function<void()> Work;
+
+    struct Metrics
+    {
+        std::size_t Workers;
+        std::size_t QueueDepth;
+        std::size_t PeakQueueDepth;
+        std::size_t Running;
+        std::size_t CostInUse;
+        std::size_t CostBudget;
+        uint_fast64_t Submitted;
+        uint_fast64_t Completed;
+        uint_fast64_t Rejected;
+        uint_fast64_t AverageWaitMilliseconds;
+    };
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_pimpl;
+
+public:
+    WorkerPool();
+    virtual ~WorkerPool();
+
+public:
+    void Start(const std::string &name, const std::size_t workers, const std::size_t maxQueueDepth,
+               const std::size_t costBudget = std::numeric_limits<std::size_t>::max());
+    /// Lets the running jobs finish, drops the queued ones
+    void Stop();
+
+    /// The work runs outside of any Wt session. Returns false, without ever
+    /// running it, when the queue is full or the pool is not running.
+    bool Post(const Work &work, const std::size_t cost = 0);
+
+    Metrics GetMetrics() const;
+};
+
+
+#endif /* SERVICE_WORKER_POOL_HPP */
@@ -33,6 +33,8 @@
  */
 
 
+#include <string>
+#include <vector>
 #include <csignal>
 #include <cstdlib>
 #if defined ( _WIN32 )
@@ -47,6 +49,7 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 #include <pqxx/pqxx>
 #include <Wt/WServer>
 #include <Wt/WString>
@@ -65,19 +68,28 @@
 #include <CoreLib/make_unique.hpp>
 #include <CoreLib/Random.hpp>
 #include <CoreLib/System.hpp>
+#include "Argon2Executor.hpp"
 #include "CgiRoot.hpp"
 #include "Exception.hpp"
+#include "Janitor.hpp"
+#include "LocalizedStrings.hpp"
 #include "Pool.hpp"
+#include "SessionCache.hpp"
+#include "SharedLocalizedStrings.hpp"
+#include "SettingsCache.hpp"
+#include "SubscriptionApi.hpp"
+#include "SubscriptionLinkPage.hpp"
 #include "VersionInfo.hpp"
+#include "WorkerPool.hpp"
+
+#define     BACKGROUND_WORKERS              2
+#define     BACKGROUND_MAX_QUEUE_DEPTH      32
+#define     VALIDATION_MAX_QUEUE_DEPTH      64
 
 void Terminate [[noreturn]] (int signo);
 void InitializeDatabase();
 
-#if defined ( __unix__ )
-int main(int argc, char **argv, char **envp)
-#else
 int main(int argc, char **argv)
-#endif  // defined ( __unix__ )
 {
     try {
         /// Gracefully handle SIGTERM
@@ -180,20 +192,80 @@ int main(int argc, char **argv)
         InitializeDatabase();
 
 
+        /// Load the settings cache, start listening for changes to both the
+        /// settings and the root sessions
+        Service::Pool::Settings().Initialize();
+        Service::Pool::Sessions().Initialize();
+
+
+        /// Start purging expired and abandoned rows in the background
+        Service::Pool::Janitor().Start();
+
+
+        /// Keep password hashing off the Wt event threads
+        Service::Pool::Argon2().Start();
+
+
+        /// Same for the CMS's slow database work
+        Service::Pool::Background().Start("background", BACKGROUND_WORKERS, BACKGROUND_MAX_QUEUE_DEPTH);
+
+
+        /// One shared set of threads for CPU-bound import validation, so that
+        /// concurrent imports queue up instead of each spawning their own
+        Service::Pool::Validation().Start("validation", boost::thread::hardware_concurrency(),
+                                          VALIDATION_MAX_QUEUE_DEPTH);
+
+
+        /// Parse the message bundles once for whatever runs outside of a Wt session
+        const std::string localizationPath((boost::filesystem::path(appPath)
+                                            / boost::filesystem::path("..")
+                                            / boost::filesystem::path("i18n")
+                                            / boost::filesystem::path("localization")).string());
+        Service::Pool::Localization().Load(localizationPath, { "fa" });
+
+
+        /// Session-less endpoints; these have to outlive the server
+        Service::SubscriptionApi subscribeApi(Service::SubscriptionApi::Endpoint::Subscribe);
+        Service::SubscriptionApi unsubscribeApi(Service::SubscriptionApi::Endpoint::Unsubscribe);
+        Service::SubscriptionApi confirmApi(Service::SubscriptionApi::Endpoint::Confirm);
+        Service::SubscriptionApi cancelApi(Service::SubscriptionApi::Endpoint::Cancel);
+        Service::SubscriptionLinkPage subscriptionLinkPage;
+
+
         /// Start the server, otherwise go down
         LOG_INFO("Starting the server...");
         Wt::WServer server(argv[0]);
         server.setServerConfiguration(argc, argv, WTHTTP_CONFIGURATION);
+        /// Owned by the server
+        Service::SharedLocalizedStrings *localizedStrings = new Service::SharedLocalizedStrings(localizationPath);
+        server.setLocalizedStrings(localizedStrings);
         server.addEntryPoint(Wt::Application, Service::CgiRoot::CreateApplication, "", "favicon.ico");
+        server.addResource(&subscribeApi, "/api/v1/subscribe");
+        server.addResource(&unsubscribeApi, "/api/v1/unsubscribe");
+        server.addResource(&confirmApi, "/api/v1/confirm");
+        server.addResource(&cancelApi, "/api/v1/cancel");
+        server.addResource(&subscriptionLinkPage, "/" + Service::SubscriptionLinkPage::Path());
         if (server.start()) {
             int sig = Wt::WServer::waitForShutdown();
-            server.stop();
 
 #if defined ( __unix__ )
-            /// Experimental, UNIX only
-            if (sig == SIGHUP)
-                Wt::WServer::restart(argc, argv, envp);
+            /// Pick up edited message bundles without dropping the sessions
+            while (sig == SIGHUP) {
+                LOG_INFO("Reloading the message bundles...");
+                Service::Pool::Localization().Load(localizationPath, { "fa" });
+                localizedStrings->Reload();
+                sig = Wt::WServer::waitForShutdown();
+            }
 #endif  // defined ( __unix__ )
+
+            /// Finish off whatever is hashing while sessions may still receive the outcome
+            Service::Pool::Argon2().Stop();
+            Service::Pool::Background().Stop();
+            /// Only once the imports waiting on it are done
+            Service::Pool::Validation().Stop();
+            server.stop();
+
+            Service::Pool::Janitor().Stop();
         }
 
 
@@ -249,17 +321,14 @@ void InitializeDatabase()
     try {
         LOG_INFO("main: Initializing database...");
 
-        LOG_INFO("main: Registering database enums...");
-
-        Service::Pool::Database().RegisterEnum("SUBSCRIPTION", "subscription",
-        { "none", "en_fa", "en", "fa" });
-
-        LOG_INFO("main: Registered all database enums!");
-
         LOG_INFO("main: Registering database tables...");
 
+        /// Owned by the migrations engine, see Database::Migrate()
         Service::Pool::Database().RegisterTable("VERSION", "version",
-                                                " version SMALLINT NOT NULL PRIMARY KEY ");
+                                                " version INTEGER NOT NULL PRIMARY KEY, "
+                                                " description TEXT, "
+                                                " checksum TEXT, "
+                                                " applied_time TIMESTAMPTZ ");
 
         Service::Pool::Database().RegisterTable("ROOT", "root",
                                                 " user_id UUID NOT NULL PRIMARY KEY, "
@@ -366,14 +435,250 @@ void InitializeDatabase()
                                                 " subscription SUBSCRIPTION NOT NULL DEFAULT 'none', "
                                                 " pending_confirm SUBSCRIPTION NOT NULL DEFAULT 'none', "
                                                 " pending_cancel SUBSCRIPTION NOT NULL DEFAULT 'none', "
-                                                " join_date TEXT NOT NULL, "
-                                                " update_date TEXT NOT NULL ");
+                                                " join_date TIMESTAMPTZ NOT NULL DEFAULT NOW(), "
+                                                " update_date TIMESTAMPTZ NOT NULL DEFAULT NOW() ");
+
+        Service::Pool::Database().RegisterTable("SUBSCRIBER_COUNTS", "subscriber_counts",
+                                                " subscription SUBSCRIPTION NOT NULL PRIMARY KEY, "
+                                                " count BIGINT NOT NULL DEFAULT 0 ");
 
         LOG_INFO("main: Registered all database tables!");
 
+        LOG_INFO("main: Registering database migrations...");
+
+        /// Never edit a migration once it has shipped; add a new one instead.
+        /// The SQL is spelled out rather than built from the table definitions
+        /// above, so that editing those never alters the checksum of an applied
+        /// migration. Versions 1 and 2 predate the migrations engine and may get
+        /// applied on top of an existing schema, so they must stay re-runnable.
+
+        /// Trigram indexes for substring search on subscriber inboxes, partial
+        /// indexes on the pending states and btree indexes for time ranges.
+        /// Subscriber counts are maintained through a trigger, so that the
+        /// admin panel never has to count(*) the subscribers table; writers
+        /// are locked out while (re-)installing the trigger and seeding the
+        /// counters, otherwise the counts could drift right from the start.
+        Service::Pool::Database().RegisterMigration(
+                    1, "Baseline schema",
+                    " CREATE EXTENSION IF NOT EXISTS \"pg_trgm\";"
+                    " DO $$ BEGIN"
+                    " CREATE TYPE \"subscription\" AS ENUM ( 'none', 'en_fa', 'en', 'fa' );"
+                    " EXCEPTION WHEN duplicate_object THEN NULL;"
+                    " END $$;"
+                    " CREATE TABLE IF NOT EXISTS \"root\" ( "
+                    " user_id UUID NOT NULL PRIMARY KEY, "
+                    " username TEXT NOT NULL UNIQUE, "
+                    " email TEXT NOT NULL UNIQUE, "
+                    " creation_time TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$, "
+                    " modification_time TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$ "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"root_credentials\" ( "
+                    " user_id UUID NOT NULL PRIMARY KEY, "
+                    " pwd TEXT NOT NULL, "
+                    " modification_time TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$ "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"root_credentials_recovery\" ( "
+                    " token UUID NOT NULL PRIMARY KEY, "
+                    " user_id UUID NOT NULL, "
+                    " expiry TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$, "
+                    " new_pwd TEXT NOT NULL, "
+                    " request_time TIMESTAMPTZ NOT NULL, "
+                    " request_ip_address INET, "
+                    " request_location_country_code TEXT, "
+                    " request_location_country_code3 TEXT, "
+                    " request_location_country_name TEXT, "
+                    " request_location_region TEXT, "
+                    " request_location_city TEXT, "
+                    " request_location_postal_code TEXT, "
+                    " request_location_latitude TEXT, "
+                    " request_location_longitude TEXT, "
+                    " request_location_metro_code TEXT, "
+                    " request_location_dma_code TEXT, "
+                    " request_location_area_code TEXT, "
+                    " request_location_charset TEXT, "
+                    " request_location_continent_code TEXT, "
+                    " request_location_netmask TEXT, "
+                    " request_location_asn TEXT, "
+                    " request_location_aso TEXT, "
+                    " request_location_raw_data JSONB, "
+                    " request_user_agent TEXT, "
+                    " request_referer TEXT, "
+                    " utilization_time TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$, "
+                    " utilization_ip_address INET, "
+                    " utilization_location_country_code TEXT, "
+                    " utilization_location_country_code3 TEXT, "
+                    " utilization_location_country_name TEXT, "
+                    " utilization_location_region TEXT, "
+                    " utilization_location_city TEXT, "
+                    " utilization_location_postal_code TEXT, "
+                    " utilization_location_latitude TEXT, "
+                    " utilization_location_longitude TEXT, "
+                    " utilization_location_metro_code TEXT, "
+                    " utilization_location_dma_code TEXT, "
+                    " utilization_location_area_code TEXT, "
+                    " utilization_location_charset TEXT, "
+                    " utilization_location_continent_code TEXT, "
+                    " utilization_location_netmask TEXT, "
+                    " utilization_location_aso TEXT, "
+                    " utilization_location_asn TEXT, "
+                    " utilization_location_raw_data JSONB, "
+                    " utilization_user_agent TEXT, "
+                    " utilization_referer TEXT "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"root_sessions\" ( "
+                    " token UUID NOT NULL PRIMARY KEY, "
+                    " user_id UUID NOT NULL, "
+                    " expiry TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$, "
+                    " login_time TIMESTAMPTZ NOT NULL DEFAULT TIMESTAMPTZ $token$'EPOCH'''$token$, "
+                    " ip_address INET, "
+                    " location_country_code TEXT, "
+                    " location_country_code3 TEXT, "
+                    " location_country_name TEXT, "
+                    " location_region TEXT, "
+                    " location_city TEXT, "
+                    " location_postal_code TEXT, "
+                    " location_latitude REAL, "
+                    " location_longitude REAL, "
+                    " location_metro_code INTEGER, "
+                    " location_dma_code INTEGER, "
+                    " location_area_code INTEGER, "
+                    " location_charset INTEGER, "
+                    " location_continent_code TEXT, "
+                    " location_netmask INTEGER, "
+                    " location_asn INTEGER, "
+                    " location_aso TEXT, "
+                    " location_raw_data JSONB, "
+                    " user_agent TEXT, "
+                    " referer TEXT "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"settings\" ( "
+                    " pseudo_id TEXT NOT NULL PRIMARY KEY, "
+                    " homepage_url_en TEXT NOT NULL, "
+                    " homepage_url_fa TEXT NOT NULL, "
+                    " homepage_title_en TEXT NOT NULL, "
+                    " homepage_title_fa TEXT NOT NULL "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"contacts\" ( "
+                    " recipient TEXT NOT NULL PRIMARY KEY, "
+                    " recipient_fa TEXT NOT NULL UNIQUE, "
+                    " address TEXT NOT NULL, "
+                    " is_default BOOLEAN NOT NULL DEFAULT FALSE "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"subscribers\" ( "
+                    " inbox TEXT NOT NULL PRIMARY KEY, "
+                    " uuid UUID NOT NULL UNIQUE, "
+                    " subscription SUBSCRIPTION NOT NULL DEFAULT 'none', "
+                    " pending_confirm SUBSCRIPTION NOT NULL DEFAULT 'none', "
+                    " pending_cancel SUBSCRIPTION NOT NULL DEFAULT 'none', "
+                    " join_date TIMESTAMPTZ NOT NULL DEFAULT NOW(), "
+                    " update_date TIMESTAMPTZ NOT NULL DEFAULT NOW() "
+                    " );"
+                    " CREATE TABLE IF NOT EXISTS \"subscriber_counts\" ( "
+                    " subscription SUBSCRIPTION NOT NULL PRIMARY KEY, "
+                    " count BIGINT NOT NULL DEFAULT 0 "
+                    " );"
+                    " CREATE INDEX IF NOT EXISTS \"subscribers_inbox_trgm\" ON \"subscribers\" USING GIN ( inbox gin_trgm_ops );"
+                    " CREATE INDEX IF NOT EXISTS \"subscribers_pending_confirm\" ON \"subscribers\" ( inbox ) WHERE pending_confirm <> 'none';"
+                    " CREATE INDEX IF NOT EXISTS \"subscribers_pending_cancel\" ON \"subscribers\" ( inbox ) WHERE pending_cancel <> 'none';"
+                    " LOCK TABLE \"subscribers\" IN SHARE ROW EXCLUSIVE MODE;"
+                    " CREATE OR REPLACE FUNCTION \"subscribers_count\"() RETURNS TRIGGER AS $fn$"
+                    " BEGIN"
+                    " IF TG_OP = 'UPDATE' AND OLD.subscription = NEW.subscription THEN"
+                    " RETURN NULL;"
+                    " END IF;"
+                    " IF TG_OP IN ( 'UPDATE', 'DELETE' ) THEN"
+                    " UPDATE \"subscriber_counts\" SET count = count - 1 WHERE subscription = OLD.subscription;"
+                    " END IF;"
+                    " IF TG_OP IN ( 'INSERT', 'UPDATE' ) THEN"
+                    " UPDATE \"subscriber_counts\" SET count = count + 1 WHERE subscription = NEW.subscription;"
+                    " END IF;"
+                    " RETURN NULL;"
+                    " END;"
+                    " $fn$ LANGUAGE plpgsql;"
+                    " DROP TRIGGER IF EXISTS \"subscribers_count\" ON \"subscribers\";"
+                    " CREATE TRIGGER \"subscribers_count\""
+                    " AFTER INSERT OR DELETE OR UPDATE OF subscription ON \"subscribers\""
+                    " FOR EACH ROW EXECUTE PROCEDURE \"subscribers_count\"();"
+                    " INSERT INTO \"subscriber_counts\" ( subscription, count )"
+                    " SELECT e, ( SELECT count(*) FROM \"subscribers\" WHERE subscription = e )"
+                    " FROM unnest( enum_range( NULL::SUBSCRIPTION ) ) AS e"
+                    " ON CONFLICT ( subscription ) DO UPDATE SET count = EXCLUDED.count;");
+
+        /// subscribers.join_date and subscribers.update_date used to be TEXT
+        /// columns holding seconds since epoch, indexed through BIGINT casts
+        Service::Pool::Database().RegisterMigration(
+                    2, "Subscriber dates as TIMESTAMPTZ",
+                    " DO $$ BEGIN"
+                    " IF ( SELECT data_type FROM information_schema.columns"
+                    " WHERE table_name = 'subscribers' AND column_name = 'join_date' ) = 'text' THEN"
+                    " DROP INDEX IF EXISTS \"subscribers_join_date\";"
+                    " DROP INDEX IF EXISTS \"subscribers_update_date\";"
+                    " ALTER TABLE \"subscribers\""
+                    " ALTER COLUMN join_date TYPE TIMESTAMPTZ USING TO_TIMESTAMP( join_date::BIGINT ),"
+                    " ALTER COLUMN join_date SET DEFAULT NOW(),"
+                    " ALTER COLUMN update_date TYPE TIMESTAMPTZ USING TO_TIMESTAMP( update_date::BIGINT ),"
+                    " ALTER COLUMN update_date SET DEFAULT NOW();"
+                    " END IF;"
+                    " END $$;"
+                    " CREATE INDEX IF NOT EXISTS \"subscribers_join_date\" ON \"subscribers\" ( join_date );"
+                    " CREATE INDEX IF NOT EXISTS \"subscribers_update_date\" ON \"subscribers\" ( update_date );");
+
+        /// Bulk imports adjust the counters in one go; they used to switch the
+        /// trigger off with ALTER TABLE, which locks everyone else out of the
+        /// table and requires its owner
+        Service::Pool::Database().RegisterMigration(
+                    3, "Subscribers count trigger skipped during bulk imports",
+                    " CREATE OR REPLACE FUNCTION \"subscribers_count\"() RETURNS TRIGGER AS $fn$"
+                    " BEGIN"
+                    " IF current_setting( 'app.bulk_import', TRUE ) = 'on' THEN"
+                    " RETURN NULL;"
+                    " END IF;"
+                    " IF TG_OP = 'UPDATE' AND OLD.subscription = NEW.subscription THEN"
+                    " RETURN NULL;"
+                    " END IF;"
+                    " IF TG_OP IN ( 'UPDATE', 'DELETE' ) THEN"
+                    " UPDATE \"subscriber_counts\" SET count = count - 1 WHERE subscription = OLD.subscription;"
+                    " END IF;"
+                    " IF TG_OP IN ( 'INSERT', 'UPDATE' ) THEN"
+                    " UPDATE \"subscriber_counts\" SET count = count + 1 WHERE subscription = NEW.subscription;"
+                    " END IF;"
+                    " RETURN NULL;"
+                    " END;"
+                    " $fn$ LANGUAGE plpgsql;");
+
+        LOG_INFO("main: Registered all database migrations!");
+
+
+        /// Rather than failing somewhere in the middle of a migration
+        {
+            auto server = Service::Pool::Database().Connection();
+            server->activate();
+
+            /// Migration 3 relies on current_setting( ..., missing_ok )
+            if (server->server_version() < 90600) {
+                LOG_FATAL("main: PostgreSQL 9.6 or newer is required!",
+                          (boost::format("Server version: %1%") % server->server_version()).str());
+                exit(EXIT_FAILURE);
+            }
+
+            /// Before PostgreSQL 13 creating it takes a superuser or the
+            /// database owner, which the service's own role rarely is
+            pqxx::nontransaction txn(*server.get());
+            pqxx::result r = txn.exec("SELECT 1 FROM pg_extension WHERE extname = 'pg_trgm';");
+            if (r.empty()) {
+                LOG_FATAL("main: The pg_trgm extension is missing from the database!",
+                          "Have an administrator run CREATE EXTENSION pg_trgm; in the service database.");
+                exit(EXIT_FAILURE);
+            }
+        }
 
-        LOG_INFO("main: Calling Database::Initialize()...");
-        Service::Pool::Database().Initialize();
+
+        LOG_INFO("main: Calling Database::Migrate()...");
+        if (!Service::Pool::Database().Migrate("VERSION")) {
+            /// Never serve on top of a schema of unknown shape
+            LOG_FATAL("main: Database migration has failed!");
+            exit(EXIT_FAILURE);
+        }
 
 
         LOG_INFO("main: Setting up the database...");
@@ -382,20 +687,10 @@ void InitializeDatabase()
         conn->activate();
         pqxx::work txn(*conn.get());
 
-        /// Check the database version
-        pqxx::result r = txn.exec((boost::format("SELECT version FROM \"%1%\" WHERE 1 = 1;")
-                                   % txn.esc(Service::Pool::Database().GetTableName("VERSION"))).str());
-
-        /// If the database is un-versioned
-        if (r.empty()) {
-            /// Insert the version number 1
-            Service::Pool::Database().Insert("VERSION", "version", { "1" });
-        }
-
         /// Check whether the default root user already exists
-        r = txn.exec((boost::format("SELECT username FROM \"%1%\" WHERE username=%2%;")
-                      % txn.esc(Service::Pool::Database().GetTableName("ROOT"))
-                      % txn.quote(Service::Pool::Storage().RootUsername())).str());
+        pqxx::result r = txn.exec((boost::format("SELECT username FROM \"%1%\" WHERE username=%2%;")
+                                   % txn.esc(Service::Pool::Database().GetTableName("ROOT"))
+                                   % txn.quote(Service::Pool::Storage().RootUsername())).str());
 
         /// If the default root user does not exists
         if (r.empty()) {
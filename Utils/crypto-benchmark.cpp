@@ -0,0 +1,180 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A tiny micro-benchmark comparing CoreLib::Crypto's pre-keyed per-thread
+ * ciphers and table-driven hex codec against the former CryptoPP pipelines,
+ * which re-keyed AES and went through heap-allocated filters on every call.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <boost/format.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/filters.h>
+#include <cryptopp/hex.h>
+#include <cryptopp/modes.h>
+#include <CoreLib/Crypto.hpp>
+#include <CoreLib/Stopwatch.hpp>
+
+#define     DEFAULT_ITERATIONS      200000
+
+/// Throw-away key material, never used outside of this benchmark
+static const CoreLib::Crypto::Byte KEY[] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const CoreLib::Crypto::Byte IV[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+void LegacyEncrypt(const std::string &plainText, std::string &out_encodedText);
+void LegacyDecrypt(const std::string &cipherText, std::string &out_recoveredText);
+
+template <typename Function_T>
+double Measure(const std::size_t iterations, Function_T function);
+
+void Report(const std::string &name, const std::size_t iterations, const double legacy, const double current);
+
+int main(int argc, char **argv)
+{
+    const std::size_t iterations = argc > 1
+            ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_ITERATIONS;
+
+    CoreLib::Crypto crypto(KEY, sizeof(KEY), IV, sizeof(IV));
+
+    /// Roughly the size of a session token or an encrypted Argon2 hash
+    const std::string plainText("$argon2i$v=19$m=32768,t=4,p=1$c29tZXNhbHRzb21lc2FsdA$"
+                                "0123456789abcdef0123456789abcdef0123456789a");
+
+    std::string legacyCipher;
+    std::string cipher;
+    LegacyEncrypt(plainText, legacyCipher);
+    crypto.Encrypt(plainText, cipher);
+
+    if (cipher != legacyCipher) {
+        std::cerr << "Cipher texts do not match!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string recovered;
+    if (!crypto.Decrypt(legacyCipher, recovered) || recovered != plainText) {
+        std::cerr << "Round trip failed!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << (boost::format("Iterations: %1%, plain text: %2% bytes") % iterations % plainText.size()).str()
+              << std::endl << std::endl;
+
+    Report("Encrypt", iterations,
+           Measure(iterations, [&]() { LegacyEncrypt(plainText, legacyCipher); }),
+           Measure(iterations, [&]() { crypto.Encrypt(plainText, cipher); }));
+
+    Report("Decrypt", iterations,
+           Measure(iterations, [&]() { LegacyDecrypt(cipher, recovered); }),
+           Measure(iterations, [&]() { crypto.Decrypt(cipher, recovered); }));
+
+    std::string hex;
+    std::string raw;
+    Report("Hex encode", iterations,
+           Measure(iterations, [&]() {
+               hex.clear();
+               CryptoPP::StringSource(plainText, true, new CryptoPP::HexEncoder(new CryptoPP::StringSink(hex)));
+           }),
+           Measure(iterations, [&]() {
+               CoreLib::Crypto::HexEncode(reinterpret_cast<const CoreLib::Crypto::Byte *>(plainText.data()),
+                                          plainText.size(), hex);
+           }));
+
+    Report("Hex decode", iterations,
+           Measure(iterations, [&]() {
+               raw.clear();
+               CryptoPP::StringSource(hex, true, new CryptoPP::HexDecoder(new CryptoPP::StringSink(raw)));
+           }),
+           Measure(iterations, [&]() { CoreLib::Crypto::HexDecode(hex, raw); }));
+
+    return EXIT_SUCCESS;
+}
+
+void LegacyEncrypt(const std::string &plainText, std::string &out_encodedText)
+{
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption enc;
+    enc.SetKeyWithIV(KEY, sizeof(KEY), IV, sizeof(IV));
+
+    std::string cipher;
+    CryptoPP::StringSource(plainText, true,
+                           new CryptoPP::StreamTransformationFilter(enc, new CryptoPP::StringSink(cipher)));
+
+    std::string encoded;
+    CryptoPP::StringSource(cipher, true, new CryptoPP::HexEncoder(new CryptoPP::StringSink(encoded)));
+    out_encodedText.assign(std::move(encoded));
+}
+
+void LegacyDecrypt(const std::string &cipherText, std::string &out_recoveredText)
+{
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption dec;
+    dec.SetKeyWithIV(KEY, sizeof(KEY), IV, sizeof(IV));
+
+    std::string cipher;
+    CryptoPP::StringSource(cipherText, true, new CryptoPP::HexDecoder(new CryptoPP::StringSink(cipher)));
+
+    std::string decoded;
+    CryptoPP::StringSource(cipher, true,
+                           new CryptoPP::StreamTransformationFilter(dec, new CryptoPP::StringSink(decoded)));
+    out_recoveredText.assign(std::move(decoded));
+}
+
+template <typename Function_T>
+double Measure(const std::size_t iterations, Function_T function)
+{
+    /// Warm-up, e.g. the per-thread cipher contexts get keyed here
+    function();
+
+    CoreLib::Stopwatch<> stopwatch;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        function();
+    }
+    return stopwatch.Stop();
+}
+
+void Report(const std::string &name, const std::size_t iterations, const double legacy, const double current)
+{
+    std::cout << (boost::format("%1%\n"
+                                "    legacy:  %2$10.3f us total, %3$8.3f us/op\n"
+                                "    current: %4$10.3f us total, %5$8.3f us/op\n"
+                                "    speedup: %6$.2fx")
+                  % name
+                  % legacy % (legacy / iterations)
+                  % current % (current / iterations)
+                  % (current > 0.0 ? legacy / current : 0.0)).str()
+              << std::endl << std::endl;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * Checks CoreLib::CDate's buffer-based Jalali / asctime() rendering and its
+ * Persian digit table against the lexical_cast / asctime() / switch code they
+ * replace over a range of timestamps, then times the mail template ${time}
+ * rendering both ways, with and without the per-second memoization.
+ */
+
+
+#include <codecvt>
+#include <ctime>
+#include <iostream>
+#include <locale>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <CoreLib/CDate.hpp>
+#include <CoreLib/Stopwatch.hpp>
+
+#define     DEFAULT_ITERATIONS      200000
+#define     FIRST_TIMESTAMP         0
+#define     TIMESTAMP_STEP          7919
+
+using namespace CoreLib::CDate;
+
+/// The code CoreLib::CDate::DateConv used to run; only the digit switch of
+/// FormatToPersianNums() is folded into a range check
+struct Legacy
+{
+    static std::string CalcToJ(const int gYear, const int dayOfYear)
+    {
+        bool isLeapYear = DateConv::IsLeapYearG(gYear - 1);
+        int dayMatch[13] = { 80, 111, 142, 173, 204, 235, 266, 296, 326, 356, !isLeapYear ? 21 : 20, !isLeapYear ? 51 : 50, 999 };
+
+        std::string jDay;
+        std::string jMonth;
+
+        for (int i = 0; i < 12; ++i)
+            if ((dayOfYear >= dayMatch[i] && dayOfYear < dayMatch[i + 1]) || ((dayOfYear >= dayMatch[i] || dayOfYear < dayMatch[i + 1]) && (i == 9))) {
+                jDay = boost::lexical_cast<std::string>(dayOfYear >= dayMatch[i] ? dayOfYear - dayMatch[i] + 1 : !isLeapYear ? dayOfYear + 10 : dayOfYear + 11);
+                jMonth = boost::lexical_cast<std::string>(i + 1);
+                break;
+            }
+
+        return boost::lexical_cast<std::string>(dayOfYear > 79 ? gYear - 621 : gYear - 622) + "/" +
+                (jMonth.size() == 1 ? "0" + jMonth : jMonth)
+                + "/" +
+                (jDay.size() != 1 ? jDay : "0" + jDay);
+    }
+
+    static std::string ToJalali(const std::time_t rawTime)
+    {
+        struct tm *timeInfo = gmtime(&rawTime);
+        return CalcToJ(timeInfo->tm_year + 1900, timeInfo->tm_yday + 1);
+    }
+
+    static std::string DateTimeString(const std::time_t rawTime)
+    {
+        return asctime(gmtime(&rawTime));
+    }
+
+    static std::wstring FormatToPersianNums(const std::string &date)
+    {
+        std::wstring res;
+
+        for (size_t i = 0; i < date.length(); ++i) {
+            if (date[i] >= 0x30 && date[i] <= 0x39) {
+                res += static_cast<wchar_t>(0x06F0 + (date[i] - 0x30));
+            } else {
+                res += date[i];
+            }
+        }
+
+        return res;
+    }
+
+    /// What the mail templates used to substitute for ${time}, with
+    /// Wt::WString::toUTF8() standing in by std::wstring_convert
+    static std::string PersianTimeStamp(const std::time_t rawTime)
+    {
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+
+        return (boost::format("%1% ~ %2%")
+                % converter.to_bytes(FormatToPersianNums(ToJalali(rawTime)))
+                % boost::algorithm::trim_copy(DateTimeString(rawTime))).str();
+    }
+};
+
+std::string PersianTimeStamp(const std::time_t rawTime);
+
+template <typename Function_T>
+double Measure(const std::vector<std::time_t> &inputs, Function_T function);
+
+void Report(const std::string &name, const std::size_t count, const double legacy, const double current);
+
+int main(int argc, char **argv)
+{
+    const std::size_t iterations = argc > 1
+            ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_ITERATIONS;
+
+    std::vector<std::time_t> timestamps;
+    timestamps.reserve(iterations);
+    for (std::size_t i = 0; i < iterations; ++i) {
+        timestamps.push_back(static_cast<std::time_t>(FIRST_TIMESTAMP + i * TIMESTAMP_STEP));
+    }
+
+    for (const auto &t : timestamps) {
+        const std::string expected(Legacy::PersianTimeStamp(t));
+        const std::string actual(PersianTimeStamp(t));
+
+        if (expected != actual
+                || DateConv::FormatToPersianNums(Legacy::ToJalali(t)) != Legacy::FormatToPersianNums(Legacy::ToJalali(t))) {
+            std::cerr << (boost::format("Disagreement on %1%: legacy \"%2%\", current \"%3%\"")
+                          % t % expected % actual).str()
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << (boost::format("Timestamps: %1%, equivalent") % iterations).str()
+              << std::endl << std::endl;
+
+    Report("${time} per timestamp", iterations,
+           Measure(timestamps, [](const std::time_t t) { return Legacy::PersianTimeStamp(t).size(); }),
+           Measure(timestamps, [](const std::time_t t) { return PersianTimeStamp(t).size(); }));
+
+    const Now now(Timezone::UTC);
+    const std::vector<std::time_t> sameSecond(iterations, now.RawTime());
+
+    Report("${time} within one second", iterations,
+           Measure(sameSecond, [](const std::time_t t) { return Legacy::PersianTimeStamp(t).size(); }),
+           Measure(sameSecond, [&](const std::time_t) { return DateConv::PersianTimeStamp(now).size(); }));
+
+    return EXIT_SUCCESS;
+}
+
+/// DateConv::PersianTimeStamp() without the memoization, since it only takes
+/// the current second
+std::string PersianTimeStamp(const std::time_t rawTime)
+{
+    char date[DateConv::BUFFER_SIZE];
+    char persian[DateConv::BUFFER_SIZE];
+    char time[DateConv::BUFFER_SIZE];
+
+    std::string result(persian, DateConv::FormatToPersianNums(
+                           date, DateConv::ToJalali(rawTime, Timezone::UTC, date), persian));
+    result.append(" ~ ");
+    result.append(time, DateConv::DateTimeString(rawTime, Timezone::UTC, time));
+
+    return result;
+}
+
+template <typename Function_T>
+double Measure(const std::vector<std::time_t> &inputs, Function_T function)
+{
+    std::size_t length = 0;
+
+    CoreLib::Stopwatch<> stopwatch;
+    for (const auto &input : inputs) {
+        length += function(input);
+    }
+    const double elapsed = stopwatch.Stop();
+
+    /// Keeps the calls from being optimized away
+    if (length == 0)
+        std::cerr << length << std::endl;
+
+    return elapsed;
+}
+
+void Report(const std::string &name, const std::size_t count, const double legacy, const double current)
+{
+    std::cout << (boost::format("%1%\n"
+                                "    legacy:    %2$10.3f us total, %3$8.3f us/op\n"
+                                "    current:   %4$10.3f us total, %5$8.3f us/op\n"
+                                "    speedup:   %6$.2fx")
+                  % name
+                  % legacy % (legacy / count)
+                  % current % (current / count)
+                  % (current > 0.0 ? legacy / current : 0.0)).str()
+              << std::endl << std::endl;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Checks Service::LocalizedStrings, the process-wide message bundle parser
+ * used outside of Wt sessions, against Wt's own WMessageResourceBundle: first
+ * on a bundle exercising comments, CDATA sections and character references,
+ * then key by key on the shipped bundles for every locale.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <Wt/Test/WTestEnvironment>
+#include <Wt/WApplication>
+#include <Wt/WMessageResourceBundle>
+#include <CoreLib/FileSystem.hpp>
+#include <CoreLib/Log.hpp>
+#include <Service/LocalizedStrings.hpp>
+
+#define     DEFAULT_BUNDLE_PATH     "../i18n/localization"
+
+/// Entity-bearing messages along with what they must resolve to
+static const char *const SAMPLE_BUNDLE =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<messages>\n"
+        "    <!-- <message id=\"commented-out\">never</message> -->\n"
+        "    <message id=\"first\">&#171; First</message>\n"
+        "    <message id=\"next\">Next &#x203A;</message>\n"
+        "    <message id=\"escaped\">&lt;b&gt; &amp; &quot;q&quot;</message>\n"
+        "    <message id=\"markup\"><a href=\"?a=1&amp;b=2\">link</a><!-- note --></message>\n"
+        "    <message id=\"cdata\"><![CDATA[<raw> & text]]></message>\n"
+        "</messages>\n";
+
+static const std::vector<std::pair<std::string, std::string>> SAMPLE_MESSAGES {
+    { "first", "\xC2\xAB First" },
+    { "next", "Next \xE2\x80\xBA" },
+    { "escaped", "&lt;b&gt; &amp; \"q\"" },
+    { "markup", "<a href=\"?a=1&amp;b=2\">link</a>" },
+    { "cdata", "&lt;raw&gt; &amp; text" }
+};
+
+bool Compare(const std::string &path, const std::vector<std::string> &locales, std::size_t &out_keys);
+
+int main(int argc, char **argv)
+{
+    CoreLib::Log::Initialize(std::cerr);
+
+    const std::string path(argc > 1 ? argv[1] : DEFAULT_BUNDLE_PATH);
+
+    const boost::filesystem::path sampleDir(boost::filesystem::temp_directory_path()
+                                            / boost::filesystem::unique_path());
+    boost::filesystem::create_directories(sampleDir);
+    const std::string samplePath((sampleDir / "sample").string());
+    CoreLib::FileSystem::Write(samplePath + ".xml", SAMPLE_BUNDLE);
+
+    Service::LocalizedStrings sample;
+    bool passed = sample.Load(samplePath, { });
+
+    for (const auto &m : SAMPLE_MESSAGES) {
+        std::string value;
+        if (!sample.Resolve("", m.first, value) || value != m.second) {
+            std::cerr << (boost::format("Sample \"%1%\": expected \"%2%\", got \"%3%\"")
+                          % m.first % m.second % value).str()
+                      << std::endl;
+            passed = false;
+        }
+    }
+
+    std::string value;
+    if (sample.Resolve("", "commented-out", value)) {
+        std::cerr << "Sample \"commented-out\" must not exist" << std::endl;
+        passed = false;
+    }
+
+    std::size_t sampleKeys = 0;
+    passed = Compare(samplePath, { }, sampleKeys) && passed;
+    boost::filesystem::remove_all(sampleDir);
+
+    std::size_t keys = 0;
+    passed = Compare(path, { "fa" }, keys) && passed;
+
+    if (!passed)
+        return EXIT_FAILURE;
+
+    std::cout << (boost::format("Sample keys: %1%, bundle keys: %2%, identical to WMessageResourceBundle")
+                  % sampleKeys % keys).str()
+              << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+/// Resolves every key of the bundle in the default and each of the locales
+/// both ways
+bool Compare(const std::string &path, const std::vector<std::string> &locales, std::size_t &out_keys)
+{
+    Service::LocalizedStrings strings;
+    if (!strings.Load(path, locales)) {
+        std::cerr << (boost::format("Failed to load \"%1%\"") % path).str() << std::endl;
+        return false;
+    }
+
+    Service::LocalizedStrings::SnapshotPtr snapshot(strings.Get());
+
+    Wt::Test::WTestEnvironment environment;
+    Wt::WApplication app(environment);
+    app.messageResourceBundle().use(path);
+
+    std::vector<std::string> all { "" };
+    all.insert(all.end(), locales.begin(), locales.end());
+
+    bool identical = true;
+    out_keys = 0;
+
+    for (const auto &locale : all) {
+        app.setLocale(locale);
+
+        std::vector<std::string> keys;
+        for (const auto &m : snapshot->Default)
+            keys.push_back(m.first);
+        if (!locale.empty()) {
+            for (const auto &m : snapshot->Locales.at(locale))
+                keys.push_back(m.first);
+        }
+
+        for (const auto &key : keys) {
+            std::string expected;
+            std::string actual;
+
+            if (!app.messageResourceBundle().resolveKey(key, expected)
+                    || !strings.Resolve(locale, key, actual) || expected != actual) {
+                std::cerr << (boost::format("Disagreement on \"%1%\" in \"%2%\": Wt \"%3%\", ours \"%4%\"")
+                              % key % locale % expected % actual).str()
+                          << std::endl;
+                identical = false;
+            }
+
+            ++out_keys;
+        }
+    }
+
+    return identical;
+}
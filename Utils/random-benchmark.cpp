@@ -0,0 +1,182 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A tiny multi-threaded micro-benchmark comparing CoreLib::Random's per-thread
+ * keystream against the former single mt19937 behind one global mutex. The
+ * legacy UUIDs take the lock as well, which they never did.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <boost/format.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/random_device.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <CoreLib/Random.hpp>
+#include <CoreLib/Stopwatch.hpp>
+
+#define     DEFAULT_ITERATIONS      200000
+#define     ALPHANUMERIC            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+
+/// The former CoreLib::Random, lock and all
+struct Legacy
+{
+    static boost::random::mt19937 &GetEngine()
+    {
+        static boost::random::random_device rd;
+        static boost::random::mt19937 rng(rd);
+        return rng;
+    }
+
+    static boost::mutex &GetLock()
+    {
+        static boost::mutex lock;
+        return lock;
+    }
+
+    static void Characters(const std::size_t length, std::string &out_chars)
+    {
+        static const std::string CHARS(ALPHANUMERIC);
+
+        boost::lock_guard<boost::mutex> guard(GetLock());
+        boost::random::uniform_int_distribution<> dist(0, static_cast<int>(CHARS.size()) - 1);
+
+        out_chars.clear();
+        for (std::size_t i = 0; i < length; ++i) {
+            out_chars += CHARS[static_cast<std::size_t>(dist(GetEngine()))];
+        }
+    }
+
+    static int Number(const int lowerBound, const int upperBound)
+    {
+        boost::lock_guard<boost::mutex> guard(GetLock());
+        boost::random::uniform_int_distribution<> dist(lowerBound, upperBound);
+        return dist(GetEngine());
+    }
+
+    static void Uuid(std::string &out_uuid)
+    {
+        boost::lock_guard<boost::mutex> guard(GetLock());
+        static boost::uuids::basic_random_generator<boost::random::mt19937> rng(&GetEngine());
+        out_uuid.assign(boost::uuids::to_string(rng()));
+    }
+};
+
+template <typename Function_T>
+double Measure(const std::size_t threads, const std::size_t iterations, Function_T function);
+
+void Report(const std::string &name, const std::size_t threads, const std::size_t iterations,
+            const double legacy, const double current);
+
+int main(int argc, char **argv)
+{
+    const std::size_t iterations = argc > 1
+            ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_ITERATIONS;
+    std::size_t threads = argc > 2
+            ? static_cast<std::size_t>(std::strtoul(argv[2], nullptr, 10))
+            : static_cast<std::size_t>(boost::thread::hardware_concurrency());
+    if (threads == 0)
+        threads = 1;
+
+    std::cout << (boost::format("Iterations: %1% per thread, threads: %2%") % iterations % threads).str()
+              << std::endl << std::endl;
+
+    Report("Characters (24, alphanumeric)", threads, iterations,
+           Measure(threads, iterations, []() {
+               std::string chars;
+               Legacy::Characters(24, chars);
+           }),
+           Measure(threads, iterations, []() {
+               std::string chars;
+               CoreLib::Random::Characters(CoreLib::Random::Character::Alphanumeric, 24, chars);
+           }));
+
+    Report("Number (1, 10)", threads, iterations,
+           Measure(threads, iterations, []() { Legacy::Number(1, 10); }),
+           Measure(threads, iterations, []() { CoreLib::Random::Number(1, 10); }));
+
+    Report("Uuid", threads, iterations,
+           Measure(threads, iterations, []() {
+               std::string uuid;
+               Legacy::Uuid(uuid);
+           }),
+           Measure(threads, iterations, []() {
+               std::string uuid;
+               CoreLib::Random::Uuid(uuid);
+           }));
+
+    return EXIT_SUCCESS;
+}
+
+template <typename Function_T>
+double Measure(const std::size_t threads, const std::size_t iterations, Function_T function)
+{
+    /// Warm-up, e.g. the calling thread's keystream gets seeded here
+    function();
+
+    CoreLib::Stopwatch<> stopwatch;
+
+    boost::thread_group group;
+    for (std::size_t t = 0; t < threads; ++t) {
+        group.create_thread([iterations, function]() {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                function();
+            }
+        });
+    }
+    group.join_all();
+
+    return stopwatch.Stop();
+}
+
+void Report(const std::string &name, const std::size_t threads, const std::size_t iterations,
+            const double legacy, const double current)
+{
+    const double operations = static_cast<double>(threads * iterations);
+
+    std::cout << (boost::format("%1%\n"
+                                "    legacy:  %2$10.3f us total, %3$8.3f us/op\n"
+                                "    current: %4$10.3f us total, %5$8.3f us/op\n"
+                                "    speedup: %6$.2fx")
+                  % name
+                  % legacy % (legacy / operations)
+                  % current % (current / operations)
+                  % (current > 0.0 ? legacy / current : 0.0)).str()
+              << std::endl << std::endl;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file
+ * @author  Mamadou Babaei <info@babaei.net>
+ * @version 0.1.0
+ *
+ * @section LICENSE
+ *
+ * (The MIT License)
+ *
+ * Copyright (c) 2016 - 2019 Mamadou Babaei
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Fuzzes CoreLib::Validate against the boost::regex patterns it replaces,
+ * failing on the first disagreement, then times both. Inputs never contain
+ * line breaks, on which boost's multi-line ^ and $ used to accept a value if
+ * any single line of it matched.
+ */
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <boost/format.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/regex.hpp>
+#include <CoreLib/Stopwatch.hpp>
+#include <CoreLib/Validate.hpp>
+
+#define     DEFAULT_ITERATIONS      200000
+#define     DEFAULT_SEED            5489u
+#define     MAX_MUTATIONS           4
+
+/// Verbatim copies of Service::Pool::StorageStruct's patterns
+#define     REGEX_EMAIL             "[a-z0-9!#$%&'*+/=?^_`{|}~-]+(?:\\.[a-z0-9!#$%&'*+/=?^_`{|}~-]+)*@(?:[a-z0-9](?:[a-z0-9-]*[a-z0-9])?\\.)+(?:[a-z]{2}|com|org|net|edu|gov|mil|biz|info|mobi|name|aero|asia|jobs|museum)\\b"
+#define     REGEX_UUID              "^[0-9a-f]{8}-[0-9a-f]{4}-[1-5][0-9a-f]{3}-[89ab][0-9a-f]{3}-[0-9a-f]{12}$"
+#define     REGEX_LANGUAGE_ARRAY    "^((^|,)(en|fa))+$"
+
+/// Heavy on the characters the formats care about
+static const std::string ALPHABET("abcefmnorsuz019AZ@.-_,+!~ '");
+
+struct Fuzzer
+{
+public:
+    boost::random::mt19937 Engine;
+
+public:
+    explicit Fuzzer(const unsigned int seed) : Engine(seed)
+    {
+    }
+
+    std::size_t Pick(const std::size_t count)
+    {
+        boost::random::uniform_int_distribution<std::size_t> dist(0, count - 1);
+        return dist(Engine);
+    }
+
+    std::string Mutate(const std::vector<std::string> &seeds)
+    {
+        std::string text(seeds[Pick(seeds.size())]);
+
+        const std::size_t mutations = Pick(MAX_MUTATIONS + 1);
+        for (std::size_t m = 0; m < mutations; ++m) {
+            const char c = ALPHABET[Pick(ALPHABET.size())];
+            const std::size_t at = Pick(text.size() + 1);
+
+            switch (Pick(3)) {
+            case 0:
+                text.insert(at, 1, c);
+                break;
+            case 1:
+                if (at < text.size())
+                    text.erase(at, 1);
+                break;
+            case 2:
+                if (at < text.size())
+                    text[at] = c;
+                break;
+            }
+        }
+
+        return text;
+    }
+};
+
+template <typename Validator_T>
+bool Compare(const std::string &name, const std::vector<std::string> &inputs,
+             Validator_T validator, const boost::regex &regex, const bool search);
+
+template <typename Function_T>
+double Measure(const std::vector<std::string> &inputs, Function_T function);
+
+void Report(const std::string &name, const std::size_t count, const double regex, const double current);
+
+int main(int argc, char **argv)
+{
+    const std::size_t iterations = argc > 1
+            ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_ITERATIONS;
+    const unsigned int seed = argc > 2
+            ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_SEED;
+
+    const boost::regex emailRegex(REGEX_EMAIL);
+    const boost::regex uuidRegex(REGEX_UUID);
+    const boost::regex languageArrayRegex(REGEX_LANGUAGE_ARRAY);
+
+    const std::vector<std::string> emailSeeds {
+        "john.doe@example.com", "a@b.co", "x+tag@sub.domain.museum", "first.last@my-host.info",
+        "me@host.comx", "me@host.co.uk", "o'neil@a1.b2.name", "text before a@b.cd_ and after",
+        "a@-b.com", "a@b-.com", "a.@b.com", ".a@b.com", "a..b@c.de", "a@b..com", "@b.com", "a@.com"
+    };
+    const std::vector<std::string> uuidSeeds {
+        "123e4567-e89b-42d3-a456-426614174000", "00000000-0000-1000-8000-000000000000",
+        "ffffffff-ffff-5fff-bfff-ffffffffffff", "123E4567-E89B-42D3-A456-426614174000",
+        "123e4567-e89b-62d3-a456-426614174000", "123e4567-e89b-42d3-c456-426614174000"
+    };
+    const std::vector<std::string> languageArraySeeds {
+        "en", "fa", "en,fa", "fa,en,en", ",en", ",,en", "en,", "enfa", "en,,fa", "de", ""
+    };
+
+    Fuzzer fuzzer(seed);
+    std::vector<std::string> emails;
+    std::vector<std::string> uuids;
+    std::vector<std::string> languageArrays;
+    emails.reserve(iterations);
+    uuids.reserve(iterations);
+    languageArrays.reserve(iterations);
+    for (std::size_t i = 0; i < iterations; ++i) {
+        emails.push_back(fuzzer.Mutate(emailSeeds));
+        uuids.push_back(fuzzer.Mutate(uuidSeeds));
+        languageArrays.push_back(fuzzer.Mutate(languageArraySeeds));
+    }
+
+    std::cout << (boost::format("Inputs: %1% per format, seed: %2%") % iterations % seed).str()
+              << std::endl << std::endl;
+
+    if (!Compare("Email", emails, &CoreLib::Validate::Email, emailRegex, false)
+            || !Compare("ContainsEmail", emails, &CoreLib::Validate::ContainsEmail, emailRegex, true)
+            || !Compare("Uuid", uuids, &CoreLib::Validate::Uuid, uuidRegex, true)
+            || !Compare("LanguageArray", languageArrays, &CoreLib::Validate::LanguageArray, languageArrayRegex, true)) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::endl;
+
+    Report("Email", iterations,
+           Measure(emails, [&](const std::string &s) { return boost::regex_match(s, emailRegex); }),
+           Measure(emails, [](const std::string &s) { return CoreLib::Validate::Email(s); }));
+
+    Report("ContainsEmail", iterations,
+           Measure(emails, [&](const std::string &s) { return boost::regex_search(s, emailRegex); }),
+           Measure(emails, [](const std::string &s) { return CoreLib::Validate::ContainsEmail(s); }));
+
+    Report("Uuid", iterations,
+           Measure(uuids, [&](const std::string &s) { return boost::regex_search(s, uuidRegex); }),
+           Measure(uuids, [](const std::string &s) { return CoreLib::Validate::Uuid(s); }));
+
+    Report("LanguageArray", iterations,
+           Measure(languageArrays, [&](const std::string &s) { return boost::regex_search(s, languageArrayRegex); }),
+           Measure(languageArrays, [](const std::string &s) { return CoreLib::Validate::LanguageArray(s); }));
+
+    return EXIT_SUCCESS;
+}
+
+template <typename Validator_T>
+bool Compare(const std::string &name, const std::vector<std::string> &inputs,
+             Validator_T validator, const boost::regex &regex, const bool search)
+{
+    std::size_t accepted = 0;
+
+    for (const auto &input : inputs) {
+        const bool expected = search ? boost::regex_search(input, regex) : boost::regex_match(input, regex);
+        const bool actual = validator(input);
+
+        if (expected != actual) {
+            std::cerr << (boost::format("%1% disagrees on \"%2%\": regex %3%, validator %4%")
+                          % name % input % expected % actual).str()
+                      << std::endl;
+            return false;
+        }
+
+        if (actual)
+            ++accepted;
+    }
+
+    std::cout << (boost::format("%1%: equivalent, %2% accepted") % name % accepted).str() << std::endl;
+
+    return true;
+}
+
+template <typename Function_T>
+double Measure(const std::vector<std::string> &inputs, Function_T function)
+{
+    std::size_t accepted = 0;
+
+    CoreLib::Stopwatch<> stopwatch;
+    for (const auto &input : inputs) {
+        if (function(input))
+            ++accepted;
+    }
+    const double elapsed = stopwatch.Stop();
+
+    /// Keeps the calls from being optimized away
+    if (accepted > inputs.size())
+        std::cerr << accepted << std::endl;
+
+    return elapsed;
+}
+
+void Report(const std::string &name, const std::size_t count, const double regex, const double current)
+{
+    std::cout << (boost::format("%1%\n"
+                                "    regex:     %2$10.3f us total, %3$8.3f us/op\n"
+                                "    validator: %4$10.3f us total, %5$8.3f us/op\n"
+                                "    speedup:   %6$.2fx")
+                  % name
+                  % regex % (regex / count)
+                  % current % (current / count)
+                  % (current > 0.0 ? regex / current : 0.0)).str()
+              << std::endl << std::endl;
+}
@@ -49,8 +49,33 @@ SET_PROPERTY( CACHE BUILD_UTILS_SPAWN_FASTCGI PROPERTY STRINGS "YES" "NO" )
 SET ( BUILD_UTILS_SPAWN_WTHTTPD "YES" CACHE STRING "" )
 SET_PROPERTY( CACHE BUILD_UTILS_SPAWN_WTHTTPD PROPERTY STRINGS "YES" "NO" )
 
+# A development-only micro-benchmark for CoreLib::Crypto; it never gets installed.
+SET ( BUILD_UTILS_CRYPTO_BENCHMARK "NO" CACHE STRING "" )
+SET_PROPERTY( CACHE BUILD_UTILS_CRYPTO_BENCHMARK PROPERTY STRINGS "YES" "NO" )
+
+# A development-only multi-threaded micro-benchmark for CoreLib::Random; it never gets installed.
+SET ( BUILD_UTILS_RANDOM_BENCHMARK "NO" CACHE STRING "" )
+SET_PROPERTY( CACHE BUILD_UTILS_RANDOM_BENCHMARK PROPERTY STRINGS "YES" "NO" )
+
+# A development-only fuzz-equivalence check and micro-benchmark for CoreLib::Validate; it never gets installed.
+SET ( BUILD_UTILS_VALIDATE_BENCHMARK "NO" CACHE STRING "" )
+SET_PROPERTY( CACHE BUILD_UTILS_VALIDATE_BENCHMARK PROPERTY STRINGS "YES" "NO" )
+
+# A development-only equivalence check and micro-benchmark for CoreLib::CDate's formatting; it never gets installed.
+SET ( BUILD_UTILS_DATE_BENCHMARK "NO" CACHE STRING "" )
+SET_PROPERTY( CACHE BUILD_UTILS_DATE_BENCHMARK PROPERTY STRINGS "YES" "NO" )
+
+# A development-only check of the shared message bundle parser against Wt's own; it never gets installed.
+SET ( BUILD_UTILS_LOCALIZATION_CHECK "NO" CACHE STRING "" )
+SET_PROPERTY( CACHE BUILD_UTILS_LOCALIZATION_CHECK PROPERTY STRINGS "YES" "NO" )
+
 SET ( CORELIB_BIN_NAME "core" CACHE STRING "" )
 SET ( SERVICE_BIN_NAME "subscribe.app" CACHE STRING "" )
 SET ( UTILS_GEOIP_UPDATER_BIN_NAME "geoip-updater" CACHE STRING "" )
 SET ( UTILS_SPAWN_FASTCGI_BIN_NAME "spawn-fastcgi" CACHE STRING "" )
 SET ( UTILS_SPAWN_WTHTTPD_BIN_NAME "spawn-wthttpd" CACHE STRING "" )
+SET ( UTILS_CRYPTO_BENCHMARK_BIN_NAME "crypto-benchmark" CACHE STRING "" )
+SET ( UTILS_RANDOM_BENCHMARK_BIN_NAME "random-benchmark" CACHE STRING "" )
+SET ( UTILS_VALIDATE_BENCHMARK_BIN_NAME "validate-benchmark" CACHE STRING "" )
+SET ( UTILS_DATE_BENCHMARK_BIN_NAME "date-benchmark" CACHE STRING "" )
+SET ( UTILS_LOCALIZATION_CHECK_BIN_NAME "localization-check" CACHE STRING "" )
@@ -35,6 +35,11 @@ SET ( ROOT_INITIAL_PASSWORD "41:35:34:38:33:37:2e:65:50:58:32:72:42:39:39:42:34:
 SET ( CRYPTO_KEY            "52:7c:62:5d:2b:2e:27:54:55:5d:7b:72:68:7e:2f:75:40:7a:32:7e:5f:3d:68:2b:3e:38:42:4a:37:7d:38:78" CACHE STRING "" ) # R|b]+.'TU]{rh~/u@z2~_=h+>8BJ7}8x
 SET ( CRYPTO_IV             "45:2b:25:5d:2d:3b:32:3f:41:79:21:29:66:39:73:3e" CACHE STRING "" ) # E+%]-;2?Ay!)f9s>
 
+# The public URL the service is reachable at, e.g. https://subscribe.example.com;
+# links in outgoing emails and redirects are built upon it, never upon the
+# client-supplied Host header
+SET ( SERVICE_URL "https://subscribe.babaei.net" CACHE STRING "" )
+
 SET (INITAL_EN_HOME_PAGE_URL "http://www.babaei.net/" CACHE STRING "" )
 SET (INITAL_FA_HOME_PAGE_URL "http://fa.babaei.net/" CACHE STRING "" )
 SET (INITAL_EN_HOME_PAGE_TITLE "The blog of Mamadou Babaei" CACHE STRING "" )
@@ -57,6 +62,15 @@ SET ( PGSQL_DATABASE "blog_subscription_service_production" CACHE STRING "" )
 SET ( PGSQL_USER "blog_subscription_service" CACHE STRING "" )
 SET ( PGSQL_PASSWORD "A_STRONG_SECRET_PASSPHRASE" CACHE STRING "" )
 
+# Optional hot standby replicas to serve CMS and reporting reads from.
+# Same connection string format as above, separated by '|', e.g.
+# "host=replica1 dbname=... user=...|host=replica2 dbname=... user=..."
+# Leave it empty to send every query to the primary.
+SET ( PGSQL_REPLICA_CONNECTION_STRINGS "" CACHE STRING "" )
+# Replicas lagging behind by more than this many seconds are skipped until
+# they catch up. Set it to 0 in order to disable the replication lag check.
+SET ( PGSQL_REPLICA_MAX_LAG_SECONDS "30" CACHE STRING "" )
+
 SET ( GDPR_COMPLIANCE 1 CACHE STRING "" )
 
 SET ( CEREAL_THREAD_SAFE 1 CACHE STRING "" )